@@ -23,6 +23,11 @@
  * Please ensure that HAL_USE_I2C is TRUE in the halconf.h file and that
  * STM32_I2C_USE_I2C1 is TRUE in the mcuconf.h file. Pins B6 and B7 are used
  * but using any other I2C pins should be trivial.
+ *
+ * Transfers run on a dedicated thread, which sleeps while the ChibiOS
+ * driver moves the data with DMA. The asynchronous functions queue a
+ * transfer and return, the blocking ones queue it and wait for it, so both
+ * kinds are executed in the order they were submitted.
  */
 
 #include "i2c_master.h"
@@ -72,29 +77,119 @@ __attribute__((weak)) void i2c_init(void) {
     // i2cInit(); //This is invoked by halInit() so no need to redo it.
 }
 
+typedef struct {
+    uint8_t        address;
+    uint8_t        regaddr;
+    bool           use_regaddr;
+    const uint8_t* tx_body;
+    uint16_t       tx_length;
+    uint8_t*       rx_body;
+    uint16_t       rx_length;
+    uint16_t       timeout;
+    i2c_callback_t callback;
+    void*          callback_arg;
+    i2c_status_t*  result;
+} i2c_request_t;
+
+static i2c_request_t     i2c_queue[I2C_QUEUE_SIZE];
+static volatile uint32_t i2c_submitted      = 0;
+static volatile uint32_t i2c_completed      = 0;
+static bool              i2c_thread_started = false;
+
+static SEMAPHORE_DECL(i2c_queue_free, I2C_QUEUE_SIZE);
+static SEMAPHORE_DECL(i2c_queue_pending, 0);
+static MUTEX_DECL(i2c_queue_lock);
+static CONDVAR_DECL(i2c_queue_done);
+
+static THD_WORKING_AREA(i2cThreadStack, I2C_THREAD_STACK_SIZE);
+static THD_FUNCTION(i2cThread, arg) {
+    (void)arg;
+    chRegSetThreadName("i2c");
+    while (true) {
+        chSemWait(&i2c_queue_pending);
+        i2c_request_t* request = &i2c_queue[i2c_completed % I2C_QUEUE_SIZE];
+
+        i2cStart(&I2C_DRIVER, &i2cconfig);
+        const uint8_t* tx_body   = request->use_regaddr ? &request->regaddr : request->tx_body;
+        uint16_t       tx_length = request->use_regaddr ? 1 : request->tx_length;
+        msg_t          status;
+        if (tx_length > 0) {
+            status = i2cMasterTransmitTimeout(&I2C_DRIVER, (request->address >> 1), tx_body, tx_length, request->rx_body, request->rx_length, MS2ST(request->timeout));
+        } else {
+            status = i2cMasterReceiveTimeout(&I2C_DRIVER, (request->address >> 1), request->rx_body, request->rx_length, MS2ST(request->timeout));
+        }
+        i2c_status_t result = chibios_to_qmk(&status);
+        if (request->callback) {
+            request->callback(result, request->callback_arg);
+        }
+
+        chMtxLock(&i2c_queue_lock);
+        if (request->result) {
+            *request->result = result;
+        }
+        i2c_completed++;
+        chCondBroadcast(&i2c_queue_done);
+        chMtxUnlock(&i2c_queue_lock);
+        chSemSignal(&i2c_queue_free);
+    }
+}
+
+// Returns the sequence number of the queued request, waits for a free slot
+// if the queue is full
+static uint32_t i2c_submit(const i2c_request_t* request) {
+    chSysLock();
+    bool start_thread  = !i2c_thread_started;
+    i2c_thread_started = true;
+    chSysUnlock();
+    if (start_thread) {
+        chThdCreateStatic(i2cThreadStack, sizeof(i2cThreadStack), I2C_THREAD_PRIORITY, i2cThread, NULL);
+    }
+
+    chSemWait(&i2c_queue_free);
+    chMtxLock(&i2c_queue_lock);
+    uint32_t id                    = i2c_submitted++;
+    i2c_queue[id % I2C_QUEUE_SIZE] = *request;
+    chMtxUnlock(&i2c_queue_lock);
+    chSemSignal(&i2c_queue_pending);
+    return id;
+}
+
+static void i2c_wait_for(uint32_t id) {
+    chMtxLock(&i2c_queue_lock);
+    while ((int32_t)(i2c_completed - id) <= 0) {
+        chCondWait(&i2c_queue_done);
+    }
+    chMtxUnlock(&i2c_queue_lock);
+}
+
+static i2c_status_t i2c_transfer(i2c_request_t* request) {
+    i2c_status_t result = I2C_STATUS_ERROR;
+    request->result     = &result;
+    i2c_wait_for(i2c_submit(request));
+    return result;
+}
+
 i2c_status_t i2c_start(uint8_t address) {
     i2c_address = address;
+    i2c_wait();
     i2cStart(&I2C_DRIVER, &i2cconfig);
     return I2C_STATUS_SUCCESS;
 }
 
 i2c_status_t i2c_transmit(uint8_t address, const uint8_t* data, uint16_t length, uint16_t timeout) {
-    i2c_address = address;
-    i2cStart(&I2C_DRIVER, &i2cconfig);
-    msg_t status = i2cMasterTransmitTimeout(&I2C_DRIVER, (i2c_address >> 1), data, length, 0, 0, MS2ST(timeout));
-    return chibios_to_qmk(&status);
+    i2c_address           = address;
+    i2c_request_t request = {.address = address, .tx_body = data, .tx_length = length, .timeout = timeout};
+    return i2c_transfer(&request);
 }
 
 i2c_status_t i2c_receive(uint8_t address, uint8_t* data, uint16_t length, uint16_t timeout) {
-    i2c_address = address;
-    i2cStart(&I2C_DRIVER, &i2cconfig);
-    msg_t status = i2cMasterReceiveTimeout(&I2C_DRIVER, (i2c_address >> 1), data, length, MS2ST(timeout));
-    return chibios_to_qmk(&status);
+    i2c_address           = address;
+    i2c_request_t request = {.address = address, .rx_body = data, .rx_length = length, .timeout = timeout};
+    return i2c_transfer(&request);
 }
 
 i2c_status_t i2c_writeReg(uint8_t devaddr, uint8_t regaddr, const uint8_t* data, uint16_t length, uint16_t timeout) {
     i2c_address = devaddr;
-    i2cStart(&I2C_DRIVER, &i2cconfig);
 
     uint8_t complete_packet[length + 1];
     for (uint8_t i = 0; i < length; i++) {
@@ -102,15 +197,43 @@ i2c_status_t i2c_writeReg(uint8_t devaddr, uint8_t regaddr, const uint8_t* data,
     }
     complete_packet[0] = regaddr;
 
-    msg_t status = i2cMasterTransmitTimeout(&I2C_DRIVER, (i2c_address >> 1), complete_packet, length + 1, 0, 0, MS2ST(timeout));
-    return chibios_to_qmk(&status);
+    i2c_request_t request = {.address = devaddr, .tx_body = complete_packet, .tx_length = length + 1, .timeout = timeout};
+    return i2c_transfer(&request);
 }
 
 i2c_status_t i2c_readReg(uint8_t devaddr, uint8_t regaddr, uint8_t* data, uint16_t length, uint16_t timeout) {
-    i2c_address = devaddr;
-    i2cStart(&I2C_DRIVER, &i2cconfig);
-    msg_t status = i2cMasterTransmitTimeout(&I2C_DRIVER, (i2c_address >> 1), &regaddr, 1, data, length, MS2ST(timeout));
-    return chibios_to_qmk(&status);
+    i2c_address           = devaddr;
+    i2c_request_t request = {.address = devaddr, .regaddr = regaddr, .use_regaddr = true, .rx_body = data, .rx_length = length, .timeout = timeout};
+    return i2c_transfer(&request);
+}
+
+i2c_status_t i2c_transmit_async(uint8_t address, const uint8_t* data, uint16_t length, uint16_t timeout, i2c_callback_t callback, void* callback_arg) {
+    i2c_request_t request = {.address = address, .tx_body = data, .tx_length = length, .timeout = timeout, .callback = callback, .callback_arg = callback_arg};
+    i2c_submit(&request);
+    return I2C_STATUS_SUCCESS;
+}
+
+i2c_status_t i2c_receive_async(uint8_t address, uint8_t* data, uint16_t length, uint16_t timeout, i2c_callback_t callback, void* callback_arg) {
+    i2c_request_t request = {.address = address, .rx_body = data, .rx_length = length, .timeout = timeout, .callback = callback, .callback_arg = callback_arg};
+    i2c_submit(&request);
+    return I2C_STATUS_SUCCESS;
 }
 
-void i2c_stop(void) { i2cStop(&I2C_DRIVER); }
+i2c_status_t i2c_readReg_async(uint8_t devaddr, uint8_t regaddr, uint8_t* data, uint16_t length, uint16_t timeout, i2c_callback_t callback, void* callback_arg) {
+    i2c_request_t request = {.address = devaddr, .regaddr = regaddr, .use_regaddr = true, .rx_body = data, .rx_length = length, .timeout = timeout, .callback = callback, .callback_arg = callback_arg};
+    i2c_submit(&request);
+    return I2C_STATUS_SUCCESS;
+}
+
+uint16_t i2c_pending(void) { return i2c_submitted - i2c_completed; }
+
+void i2c_wait(void) {
+    if (i2c_pending() > 0) {
+        i2c_wait_for(i2c_submitted - 1);
+    }
+}
+
+void i2c_stop(void) {
+    i2c_wait();
+    i2cStop(&I2C_DRIVER);
+}
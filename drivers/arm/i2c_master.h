@@ -93,6 +93,19 @@
 #    define I2C_DRIVER I2CD1
 #endif
 
+// Number of transfers which can be queued before submitting blocks
+#ifndef I2C_QUEUE_SIZE
+#    define I2C_QUEUE_SIZE 16
+#endif
+
+#ifndef I2C_THREAD_PRIORITY
+#    define I2C_THREAD_PRIORITY (NORMALPRIO + 1)
+#endif
+
+#ifndef I2C_THREAD_STACK_SIZE
+#    define I2C_THREAD_STACK_SIZE 256
+#endif
+
 typedef int16_t i2c_status_t;
 
 #define I2C_STATUS_SUCCESS (0)
@@ -107,3 +120,17 @@ i2c_status_t i2c_transmit_receive(uint8_t address, uint8_t* tx_body, uint16_t tx
 i2c_status_t i2c_writeReg(uint8_t devaddr, uint8_t regaddr, const uint8_t* data, uint16_t length, uint16_t timeout);
 i2c_status_t i2c_readReg(uint8_t devaddr, uint8_t regaddr, uint8_t* data, uint16_t length, uint16_t timeout);
 void         i2c_stop(void);
+
+// Asynchronous transfers. These queue the transfer and return, the data
+// has to stay valid until the transfer completes. The callback, which can
+// be NULL, runs on the I2C thread once the transfer is done, so it must not
+// call the blocking functions.
+typedef void (*i2c_callback_t)(i2c_status_t status, void* callback_arg);
+
+i2c_status_t i2c_transmit_async(uint8_t address, const uint8_t* data, uint16_t length, uint16_t timeout, i2c_callback_t callback, void* callback_arg);
+i2c_status_t i2c_receive_async(uint8_t address, uint8_t* data, uint16_t length, uint16_t timeout, i2c_callback_t callback, void* callback_arg);
+i2c_status_t i2c_readReg_async(uint8_t devaddr, uint8_t regaddr, uint8_t* data, uint16_t length, uint16_t timeout, i2c_callback_t callback, void* callback_arg);
+// Number of queued transfers which haven't completed yet
+uint16_t i2c_pending(void);
+// Waits for all queued transfers to complete
+void i2c_wait(void);
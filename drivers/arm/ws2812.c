@@ -0,0 +1,252 @@
+/* Copyright 2019 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ch.h"
+#include "hal.h"
+#include <string.h>
+
+#include "ws2812.h"
+
+#ifdef RGB_MATRIX_ENABLE
+// LED color buffer
+LED_TYPE led[DRIVER_LED_TOTAL];
+#    define WS2812_LED_COUNT DRIVER_LED_TOTAL
+#else
+#    define WS2812_LED_COUNT RGBLED_NUM
+#endif
+
+#define WS2812_BYTES_PER_LED sizeof(LED_TYPE)
+
+#ifdef WS2812_DRIVER_PWM
+
+#    ifndef WS2812_PWM_DRIVER
+#        define WS2812_PWM_DRIVER PWMD2
+#    endif
+#    ifndef WS2812_PWM_CHANNEL
+#        define WS2812_PWM_CHANNEL 2
+#    endif
+#    ifndef WS2812_DMA_STREAM
+#        define WS2812_DMA_STREAM STM32_DMA1_STREAM2
+#    endif
+#    ifndef WS2812_DMA_CHANNEL
+#        define WS2812_DMA_CHANNEL 2
+#    endif
+#    ifndef WS2812_PWM_FREQUENCY
+#        define WS2812_PWM_FREQUENCY (STM32_SYSCLK / 2)
+#    endif
+
+// One timer period for each bit, 1.25us, high for 0.35us for a 0 and 0.8us
+// for a 1
+#    define WS2812_PWM_PERIOD (WS2812_PWM_FREQUENCY / 800000)
+#    define WS2812_DUTYCYCLE_0 (WS2812_PWM_FREQUENCY / (1000000000 / 350))
+#    define WS2812_DUTYCYCLE_1 (WS2812_PWM_FREQUENCY / (1000000000 / 800))
+
+// The line stays low for the reset bits, which latches the colors
+#    define WS2812_PREAMBLE_SIZE 0
+#    define WS2812_RESET_SIZE 50
+#    define WS2812_SYMBOLS_PER_BYTE 8
+typedef uint16_t ws2812_symbol_t;
+
+#else
+
+#    ifndef WS2812_SPI
+#        define WS2812_SPI SPID2
+#    endif
+#    ifndef WS2812_SPI_CR1
+#        define WS2812_SPI_CR1 (SPI_CR1_BR_1 | SPI_CR1_BR_0)
+#    endif
+
+// Each SPI byte carries two bits, as 0b1000 for a 0 and 0b1110 for a 1. A
+// few low bytes first in case MOSI idles high, and about 500us low at the
+// end to latch the colors.
+#    define WS2812_PREAMBLE_SIZE 4
+#    define WS2812_RESET_SIZE 200
+#    define WS2812_SYMBOLS_PER_BYTE 4
+typedef uint8_t ws2812_symbol_t;
+
+#endif
+
+#define WS2812_DATA_SIZE (WS2812_LED_COUNT * WS2812_BYTES_PER_LED * WS2812_SYMBOLS_PER_BYTE)
+#define WS2812_BUFFER_SIZE (WS2812_PREAMBLE_SIZE + WS2812_DATA_SIZE + WS2812_RESET_SIZE)
+
+// The CPU encodes into the back buffer while the thread sends the other one
+static ws2812_symbol_t ws2812_buffers[2][WS2812_BUFFER_SIZE];
+static uint8_t         ws2812_back;
+static bool            ws2812_queued;
+static BSEMAPHORE_DECL(ws2812_wakeup, true);
+
+// The colors of the last frame, a frame without changes isn't sent again
+static LED_TYPE ws2812_last[WS2812_LED_COUNT];
+static uint16_t ws2812_last_count;
+static bool     ws2812_started;
+
+#ifdef WS2812_DRIVER_PWM
+static BSEMAPHORE_DECL(ws2812_done, true);
+
+static void ws2812_dma_done(void *param, uint32_t flags) {
+    (void)param;
+    (void)flags;
+    chSysLockFromISR();
+    dmaStreamDisable(WS2812_DMA_STREAM);
+    chBSemSignalI(&ws2812_done);
+    chSysUnlockFromISR();
+}
+
+static void ws2812_encode_byte(ws2812_symbol_t *symbols, uint8_t data) {
+    for (uint8_t i = 0; i < 8; i++) {
+        symbols[i] = (data & (0x80 >> i)) ? WS2812_DUTYCYCLE_1 : WS2812_DUTYCYCLE_0;
+    }
+}
+
+static void ws2812_start_backend(void) {
+    static const PWMConfig ws2812_pwm_config = {
+        .frequency = WS2812_PWM_FREQUENCY,
+        .period    = WS2812_PWM_PERIOD,
+        .callback  = NULL,
+        // The other channels are left at PWM_OUTPUT_DISABLED
+        .channels = {[WS2812_PWM_CHANNEL - 1] = {PWM_OUTPUT_ACTIVE_HIGH, NULL}},
+        .cr2       = 0,
+        // Each update event requests the duty cycle of the next bit
+        .dier = TIM_DIER_UDE,
+    };
+    pwmStart(&WS2812_PWM_DRIVER, &ws2812_pwm_config);
+    dmaStreamAllocate(WS2812_DMA_STREAM, 10, ws2812_dma_done, NULL);
+    dmaStreamSetPeripheral(WS2812_DMA_STREAM, &(WS2812_PWM_DRIVER.tim->CCR[WS2812_PWM_CHANNEL - 1]));
+    pwmEnableChannel(&WS2812_PWM_DRIVER, WS2812_PWM_CHANNEL - 1, 0);
+}
+
+static void ws2812_transmit(const ws2812_symbol_t *buffer) {
+    dmaStreamSetMemory0(WS2812_DMA_STREAM, buffer);
+    dmaStreamSetTransactionSize(WS2812_DMA_STREAM, WS2812_BUFFER_SIZE);
+    dmaStreamSetMode(WS2812_DMA_STREAM, STM32_DMA_CR_CHSEL(WS2812_DMA_CHANNEL) | STM32_DMA_CR_DIR_M2P | STM32_DMA_CR_PSIZE_HWORD | STM32_DMA_CR_MSIZE_HWORD | STM32_DMA_CR_MINC | STM32_DMA_CR_PL(3) | STM32_DMA_CR_TCIE);
+    dmaStreamEnable(WS2812_DMA_STREAM);
+    chBSemWait(&ws2812_done);
+}
+
+#else
+
+static void ws2812_encode_byte(ws2812_symbol_t *symbols, uint8_t data) {
+    static const uint8_t bit_pairs[4] = {0x88, 0x8E, 0xE8, 0xEE};
+    for (uint8_t i = 0; i < 4; i++) {
+        symbols[i] = bit_pairs[(data >> (6 - 2 * i)) & 0x03];
+    }
+}
+
+static void ws2812_start_backend(void) {
+    static const SPIConfig ws2812_spi_config = {
+        .end_cb = NULL,
+        .cr1    = WS2812_SPI_CR1,
+    };
+    spiAcquireBus(&WS2812_SPI);
+    spiStart(&WS2812_SPI, &ws2812_spi_config);
+}
+
+static void ws2812_transmit(const ws2812_symbol_t *buffer) { spiSend(&WS2812_SPI, WS2812_BUFFER_SIZE, buffer); }
+
+#endif
+
+// Sends the last queued frame, then sleeps until the next one
+static THD_WORKING_AREA(ws2812_thread_wa, 128);
+static THD_FUNCTION(ws2812_thread, arg) {
+    (void)arg;
+    chRegSetThreadName("ws2812");
+    while (true) {
+        chBSemWait(&ws2812_wakeup);
+        chSysLock();
+        if (!ws2812_queued) {
+            chSysUnlock();
+            continue;
+        }
+        uint8_t front = ws2812_back;
+        ws2812_back ^= 1;
+        ws2812_queued = false;
+        chSysUnlock();
+        ws2812_transmit(ws2812_buffers[front]);
+    }
+}
+
+void ws2812_init(void) {
+    if (ws2812_started) {
+        return;
+    }
+    ws2812_started = true;
+#if defined(WS2812_PAL_MODE) && defined(PORT_WS2812) && defined(PIN_WS2812)
+    palSetPadMode(PORT_WS2812, PIN_WS2812, WS2812_PAL_MODE);
+#endif
+    // The preamble and the reset stay low, the data starts out black
+    for (uint8_t b = 0; b < 2; b++) {
+        memset(ws2812_buffers[b], 0, sizeof(ws2812_buffers[b]));
+        for (uint16_t i = 0; i < WS2812_LED_COUNT * WS2812_BYTES_PER_LED; i++) {
+            ws2812_encode_byte(&ws2812_buffers[b][WS2812_PREAMBLE_SIZE + i * WS2812_SYMBOLS_PER_BYTE], 0);
+        }
+    }
+    ws2812_start_backend();
+    // Above the main loop, so that a new frame starts out right away
+    chThdCreateStatic(ws2812_thread_wa, sizeof(ws2812_thread_wa), NORMALPRIO + 1, ws2812_thread, NULL);
+}
+
+#ifdef RGB_MATRIX_ENABLE
+// Set an led in the buffer to a color
+void ws2812_setled(int i, uint8_t r, uint8_t g, uint8_t b) {
+    led[i].r = r;
+    led[i].g = g;
+    led[i].b = b;
+}
+
+void ws2812_setled_all(uint8_t r, uint8_t g, uint8_t b) {
+    for (int i = 0; i < DRIVER_LED_TOTAL; i++) {
+        led[i].r = r;
+        led[i].g = g;
+        led[i].b = b;
+    }
+}
+#endif
+
+void ws2812_setleds(LED_TYPE *ledarray, uint16_t number_of_leds) {
+    if (number_of_leds > WS2812_LED_COUNT) {
+        number_of_leds = WS2812_LED_COUNT;
+    }
+    if (!ws2812_started) {
+        ws2812_init();
+    } else if (number_of_leds == ws2812_last_count && memcmp(ws2812_last, ledarray, number_of_leds * sizeof(LED_TYPE)) == 0) {
+        return;
+    }
+    memcpy(ws2812_last, ledarray, number_of_leds * sizeof(LED_TYPE));
+    ws2812_last_count = number_of_leds;
+
+    // Take back a frame which the thread didn't pick up yet, so it can't
+    // swap the buffers while they are being written
+    chSysLock();
+    ws2812_queued = false;
+    chSysUnlock();
+
+    // The structs are in the order of the bytes on the wire
+    const uint8_t   *data    = (const uint8_t *)ledarray;
+    ws2812_symbol_t *symbols = &ws2812_buffers[ws2812_back][WS2812_PREAMBLE_SIZE];
+    for (uint16_t i = 0; i < number_of_leds * WS2812_BYTES_PER_LED; i++) {
+        ws2812_encode_byte(symbols, data[i]);
+        symbols += WS2812_SYMBOLS_PER_BYTE;
+    }
+
+    chSysLock();
+    ws2812_queued = true;
+    chBSemSignalI(&ws2812_wakeup);
+    chSchRescheduleS();
+    chSysUnlock();
+}
+
+// LED_TYPE carries the white channel when RGBW is defined
+void ws2812_setleds_rgbw(LED_TYPE *ledarray, uint16_t number_of_leds) { ws2812_setleds(ledarray, number_of_leds); }
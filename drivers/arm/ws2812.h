@@ -0,0 +1,52 @@
+/* Copyright 2019 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* WS2812 driver for ChibiOS, follows the interface of the AVR driver.
+ *
+ * The LED data is encoded into a back buffer and handed to a thread which
+ * sends it with DMA, so the next frame can be rendered while the previous
+ * one is on the wire. Nothing is sent while the colors don't change.
+ *
+ * The SPI backend is the default, the data goes out on MOSI:
+ *     WS2812_SPI      SPI driver, SPID2 by default
+ *     WS2812_SPI_CR1  SPI clock, fpclk / 16 by default, which has to be
+ *                     close to 3.2MHz
+ * The timer PWM backend is used when WS2812_DRIVER_PWM is defined, the data
+ * goes out on a timer channel which is updated by DMA:
+ *     WS2812_PWM_DRIVER   PWM driver, PWMD2 by default
+ *     WS2812_PWM_CHANNEL  timer channel, starting from 1, 2 by default
+ *     WS2812_DMA_STREAM   DMA stream of the update event of the timer,
+ *                         STM32_DMA1_STREAM2 by default
+ *     WS2812_DMA_CHANNEL  DMA channel (request) of that stream, 2 by default
+ * It uses two bytes of RAM for every bit sent, so 96 bytes for each LED.
+ *
+ * The data pin is set to WS2812_PAL_MODE when the keyboard defines it along
+ * with PORT_WS2812 and PIN_WS2812, otherwise the keyboard sets it up itself.
+ */
+#pragma once
+
+#include "quantum/color.h"
+
+#ifdef RGB_MATRIX_ENABLE
+void ws2812_setled(int index, uint8_t r, uint8_t g, uint8_t b);
+void ws2812_setled_all(uint8_t r, uint8_t g, uint8_t b);
+#endif
+
+// Starts the driver, called by the first ws2812_setleds() otherwise
+void ws2812_init(void);
+
+void ws2812_setleds(LED_TYPE *ledarray, uint16_t number_of_leds);
+void ws2812_setleds_rgbw(LED_TYPE *ledarray, uint16_t number_of_leds);
@@ -26,6 +26,9 @@
 #include <avr/io.h>
 #include <util/delay.h>
 #include "debug.h"
+#ifdef WS2812_DRIVER_USART
+#    include <avr/pgmspace.h>
+#endif
 
 #if !defined(LED_ARRAY) && defined(RGB_MATRIX_ENABLE)
 // LED color buffer
@@ -264,9 +267,75 @@ void ws2812_sendarray(uint8_t *data, uint16_t datlen) { ws2812_sendarray_mask(da
 #define w_nop8 w_nop4 w_nop4
 #define w_nop16 w_nop8 w_nop8
 
+#ifdef WS2812_DRIVER_USART
+/*
+  The USART in master SPI mode shifts the bits out of TXD1 (D3), three SPI
+  bits for every bit of the LEDs: 0b100 for a 0 and 0b110 for a 1. The
+  transmit buffer holds the next byte, so the interrupts stay enabled and
+  only have to be shorter than the reset time of the LEDs.
+*/
+#    ifndef UCSR1B
+#        error "The WS2812 USART driver needs USART1, as on the ATmega32U4"
+#    endif
+#    if F_CPU != 16000000
+#        error "The WS2812 USART driver needs F_CPU at 16MHz"
+#    endif
+#    if RGB_DI_PIN != D3
+#        error "The WS2812 USART driver sends on D3 (TXD1), set RGB_DI_PIN to D3"
+#    endif
+
+// 2.67MHz, 0.375us per SPI bit
+#    define WS2812_USART_UBRR 2
+
+// The twelve SPI bits for each nibble
+static const uint16_t ws2812_usart_nibbles[16] PROGMEM = {
+    0x924, 0x926, 0x934, 0x936, 0x9A4, 0x9A6, 0x9B4, 0x9B6, 0xD24, 0xD26, 0xD34, 0xD36, 0xDA4, 0xDA6, 0xDB4, 0xDB6,
+};
+
+static inline void ws2812_usart_put(uint8_t byte) {
+    while (!(UCSR1A & (1 << UDRE1)))
+        ;
+    UDR1 = byte;
+}
+
+static void ws2812_usart_send(uint8_t *data, uint16_t datlen) {
+    // The pin is low between frames, and XCK1 (D5) has to be an output in
+    // master SPI mode
+    PORTD &= ~(1 << 3);
+    DDRD |= (1 << 3) | (1 << 5);
+    UBRR1  = 0;
+    UCSR1C = (1 << UMSEL11) | (1 << UMSEL10);
+    UCSR1B = (1 << TXEN1);
+    UBRR1  = WS2812_USART_UBRR;
+    UCSR1A = (1 << TXC1);
+
+    while (datlen--) {
+        uint8_t  curbyte = *data++;
+        uint16_t hi      = pgm_read_word(&ws2812_usart_nibbles[curbyte >> 4]);
+        uint16_t lo      = pgm_read_word(&ws2812_usart_nibbles[curbyte & 0x0F]);
+        ws2812_usart_put(hi >> 4);
+        ws2812_usart_put((hi << 4) | (lo >> 8));
+        ws2812_usart_put(lo);
+    }
+
+    // Hand the pin back to the port once the last bit is out
+    while (!(UCSR1A & (1 << TXC1)))
+        ;
+    UCSR1B = 0;
+}
+#endif
+
 void inline ws2812_sendarray_mask(uint8_t *data, uint16_t datlen, uint8_t maskhi) {
+#ifdef WS2812_DRIVER_USART
+    (void)maskhi;
+    ws2812_usart_send(data, datlen);
+#else
     uint8_t curbyte, ctr, masklo;
     uint8_t sreg_prev;
+#    ifdef WS2812_CHUNK_SIZE
+    uint8_t pinmask = maskhi;
+    uint8_t chunk   = 0;
+#    endif
 
     // masklo  =~maskhi&ws2812_PORTREG;
     // maskhi |=        ws2812_PORTREG;
@@ -276,6 +345,20 @@ void inline ws2812_sendarray_mask(uint8_t *data, uint16_t datlen, uint8_t maskhi
     cli();
 
     while (datlen--) {
+#    ifdef WS2812_CHUNK_SIZE
+        // Let the pending interrupts run between the chunks. The line is
+        // low meanwhile, which the LEDs only take as the end of the frame
+        // if the interrupts take longer than their reset time.
+        if (++chunk > WS2812_CHUNK_SIZE) {
+            chunk = 1;
+            SREG  = sreg_prev;
+            asm volatile("nop");
+            cli();
+            // The interrupts may have changed the other pins of the port
+            masklo = ~pinmask & _SFR_IO8((RGB_DI_PIN >> 4) + 2);
+            maskhi = pinmask | _SFR_IO8((RGB_DI_PIN >> 4) + 2);
+        }
+#    endif
         curbyte = (*data++);
 
         asm volatile("       ldi   %0,8  \n\t"
@@ -338,4 +421,5 @@ void inline ws2812_sendarray_mask(uint8_t *data, uint16_t datlen, uint8_t maskhi
     }
 
     SREG = sreg_prev;
+#endif
 }
@@ -41,6 +41,12 @@
  *         - Set the data-out pin as output
  *         - Send out the LED data
  *         - Wait 50�s to reset the LEDs
+ *
+ * The data pin is bit-banged with interrupts disabled, unless:
+ *         - WS2812_CHUNK_SIZE is defined, then pending interrupts run after
+ *           every chunk of that many bytes
+ *         - WS2812_DRIVER_USART is defined, then USART1 sends the data in
+ *           SPI mode on D3 (ATmega32U4 at 16MHz), with interrupts enabled
  */
 #ifdef RGB_MATRIX_ENABLE
 void ws2812_setled(int index, uint8_t r, uint8_t g, uint8_t b);
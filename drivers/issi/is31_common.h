@@ -0,0 +1,139 @@
+/* Copyright 2017 Jason Williams
+ * Copyright 2018 Jack Humbert
+ * Copyright 2018 Yiancar
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+// Code shared by the IS31FL3731, IS31FL3733, IS31FL3736 and IS31FL3737
+// drivers. The chips only differ in where the PWM and LED control registers
+// live, which is described by a constant is31_chip_t. Everything here is
+// inline, so that each driver gets a copy specialized for its chip.
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "i2c_master.h"
+
+#ifndef ISSI_TIMEOUT
+#    define ISSI_TIMEOUT 100
+#endif
+
+#ifndef ISSI_PERSISTENCE
+#    define ISSI_PERSISTENCE 0
+#endif
+
+#define ISSI_COMMANDREGISTER 0xFD
+#define ISSI_COMMANDREGISTER_WRITELOCK 0xFE
+#define ISSI_COMMANDREGISTER_UNLOCK 0xC5
+
+// The PWM registers are transferred in chunks of this many registers
+#define ISSI_PWM_CHUNK_SIZE 16
+
+typedef struct {
+    // The PWM registers, relative to the start of their page
+    uint8_t pwm_register_offset;
+    uint8_t pwm_register_count;
+    uint8_t pwm_page;
+    uint8_t control_register_count;
+    uint8_t control_page;
+    // The command register has to be unlocked before selecting a page
+    bool has_write_lock;
+    // The drivers which don't select the pages for every update leave the
+    // page with both the PWM and the LED control registers selected
+    bool select_pages;
+} is31_chip_t;
+
+// Transfer buffer for TWITransmitData(), defined by the driver
+extern uint8_t g_twi_transfer_buffer[20];
+
+static inline void is31_transmit(uint8_t addr, uint8_t length) {
+#if ISSI_PERSISTENCE > 0
+    for (uint8_t i = 0; i < ISSI_PERSISTENCE; i++) {
+        if (i2c_transmit(addr << 1, g_twi_transfer_buffer, length, ISSI_TIMEOUT) == 0) break;
+    }
+#else
+    i2c_transmit(addr << 1, g_twi_transfer_buffer, length, ISSI_TIMEOUT);
+#endif
+}
+
+static inline void is31_write_register(uint8_t addr, uint8_t reg, uint8_t data) {
+    g_twi_transfer_buffer[0] = reg;
+    g_twi_transfer_buffer[1] = data;
+    is31_transmit(addr, 2);
+}
+
+static inline void is31_select_page(const is31_chip_t *chip, uint8_t addr, uint8_t page) {
+    if (chip->has_write_lock) {
+        is31_write_register(addr, ISSI_COMMANDREGISTER_WRITELOCK, ISSI_COMMANDREGISTER_UNLOCK);
+    }
+    is31_write_register(addr, ISSI_COMMANDREGISTER, page);
+}
+
+static inline uint16_t is31_all_pwm_chunks(const is31_chip_t *chip) { return (1 << (chip->pwm_register_count / ISSI_PWM_CHUNK_SIZE)) - 1; }
+
+// Writes the chunks which have their bit set in chunks, assumes the PWM page
+// is already selected
+static inline void is31_write_pwm_buffer_chunks(const is31_chip_t *chip, uint8_t addr, const uint8_t *pwm_buffer, uint16_t chunks) {
+    for (uint8_t i = 0; i < chip->pwm_register_count; i += ISSI_PWM_CHUNK_SIZE) {
+        if (!(chunks & (1 << (i / ISSI_PWM_CHUNK_SIZE)))) {
+            continue;
+        }
+        // the device auto-increments the register for the data after the
+        // first byte, so the whole chunk goes in one transfer
+        g_twi_transfer_buffer[0] = chip->pwm_register_offset + i;
+        for (uint8_t j = 0; j < ISSI_PWM_CHUNK_SIZE; j++) {
+            g_twi_transfer_buffer[1 + j] = pwm_buffer[i + j];
+        }
+        is31_transmit(addr, 1 + ISSI_PWM_CHUNK_SIZE);
+    }
+}
+
+// Changes a PWM register in the buffer, and marks its chunk as dirty if the
+// value changed
+static inline void is31_set_pwm(uint8_t *pwm_buffer, uint16_t *dirty_chunks, uint8_t index, uint8_t value) {
+    if (pwm_buffer[index] != value) {
+        pwm_buffer[index] = value;
+        *dirty_chunks |= 1 << (index / ISSI_PWM_CHUNK_SIZE);
+    }
+}
+
+// Sends the dirty chunks, or the whole buffer if the buffer was changed
+// without tracking the chunks
+static inline void is31_update_pwm_buffer(const is31_chip_t *chip, uint8_t addr, const uint8_t *pwm_buffer, uint16_t *dirty_chunks) {
+    if (chip->select_pages) {
+        is31_select_page(chip, addr, chip->pwm_page);
+    }
+    is31_write_pwm_buffer_chunks(chip, addr, pwm_buffer, *dirty_chunks ? *dirty_chunks : is31_all_pwm_chunks(chip));
+    *dirty_chunks = 0;
+}
+
+// The LED control registers have one bit for each PWM register
+static inline void is31_set_control_bit(uint8_t *control_registers, uint8_t index, bool enabled) {
+    if (enabled) {
+        control_registers[index / 8] |= (1 << (index % 8));
+    } else {
+        control_registers[index / 8] &= ~(1 << (index % 8));
+    }
+}
+
+static inline void is31_update_control_registers(const is31_chip_t *chip, uint8_t addr, const uint8_t *control_registers) {
+    if (chip->select_pages) {
+        is31_select_page(chip, addr, chip->control_page);
+    }
+    for (uint8_t i = 0; i < chip->control_register_count; i++) {
+        is31_write_register(addr, i, control_registers[i]);
+    }
+}
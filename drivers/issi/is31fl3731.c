@@ -26,6 +26,7 @@
 #include "is31fl3731.h"
 #include <string.h>
 #include "i2c_master.h"
+#include "is31_common.h"
 #include "progmem.h"
 
 // This is a 7-bit address, that gets left-shifted and bit 0
@@ -51,16 +52,21 @@
 #define ISSI_REG_SHUTDOWN 0x0A
 #define ISSI_REG_AUDIOSYNC 0x06
 
-#define ISSI_COMMANDREGISTER 0xFD
 #define ISSI_BANK_FUNCTIONREG 0x0B  // helpfully called 'page nine'
 
-#ifndef ISSI_TIMEOUT
-#    define ISSI_TIMEOUT 100
-#endif
+#define IS31FL3731_PWM_REGISTER_COUNT 144
+#define IS31FL3731_CONTROL_REGISTER_COUNT 18
 
-#ifndef ISSI_PERSISTENCE
-#    define ISSI_PERSISTENCE 0
-#endif
+// Bank 0 stays selected after init, so the updates don't select it
+static const is31_chip_t is31fl3731 = {
+    .pwm_register_offset    = 0x24,
+    .pwm_register_count     = IS31FL3731_PWM_REGISTER_COUNT,
+    .pwm_page               = 0,
+    .control_register_count = IS31FL3731_CONTROL_REGISTER_COUNT,
+    .control_page           = 0,
+    .has_write_lock         = false,
+    .select_pages           = false,
+};
 
 // Transfer buffer for TWITransmitData()
 uint8_t g_twi_transfer_buffer[20];
@@ -70,11 +76,15 @@ uint8_t g_twi_transfer_buffer[20];
 // We could optimize this and take out the unused registers from these
 // buffers and the transfers in IS31FL3731_write_pwm_buffer() but it's
 // probably not worth the extra complexity.
-uint8_t g_pwm_buffer[DRIVER_COUNT][144];
+uint8_t g_pwm_buffer[DRIVER_COUNT][IS31FL3731_PWM_REGISTER_COUNT];
 bool    g_pwm_buffer_update_required[DRIVER_COUNT] = {false};
 
-uint8_t g_led_control_registers[DRIVER_COUNT][18]             = {{0}, {0}};
-bool    g_led_control_registers_update_required[DRIVER_COUNT] = {false};
+// One bit for each 16 register chunk of the PWM buffer which changed since
+// the last update, only those chunks are transferred.
+uint16_t g_pwm_buffer_dirty_chunks[DRIVER_COUNT] = {0};
+
+uint8_t g_led_control_registers[DRIVER_COUNT][IS31FL3731_CONTROL_REGISTER_COUNT] = {{0}, {0}};
+bool    g_led_control_registers_update_required[DRIVER_COUNT]                    = {false};
 
 // This is the bit pattern in the LED control registers
 // (for matrix A, add one to register for matrix B)
@@ -90,45 +100,10 @@ bool    g_led_control_registers_update_required[DRIVER_COUNT] = {false};
 // 0x0E - R17,G15,G14,G13,G12,G11,G10,G09
 // 0x10 - R16,R15,R14,R13,R12,R11,R10,R09
 
-void IS31FL3731_write_register(uint8_t addr, uint8_t reg, uint8_t data) {
-    g_twi_transfer_buffer[0] = reg;
-    g_twi_transfer_buffer[1] = data;
-
-#if ISSI_PERSISTENCE > 0
-    for (uint8_t i = 0; i < ISSI_PERSISTENCE; i++) {
-        if (i2c_transmit(addr << 1, g_twi_transfer_buffer, 2, ISSI_TIMEOUT) == 0) break;
-    }
-#else
-    i2c_transmit(addr << 1, g_twi_transfer_buffer, 2, ISSI_TIMEOUT);
-#endif
-}
-
-void IS31FL3731_write_pwm_buffer(uint8_t addr, uint8_t *pwm_buffer) {
-    // assumes bank is already selected
-
-    // transmit PWM registers in 9 transfers of 16 bytes
-    // g_twi_transfer_buffer[] is 20 bytes
-
-    // iterate over the pwm_buffer contents at 16 byte intervals
-    for (int i = 0; i < 144; i += 16) {
-        // set the first register, e.g. 0x24, 0x34, 0x44, etc.
-        g_twi_transfer_buffer[0] = 0x24 + i;
-        // copy the data from i to i+15
-        // device will auto-increment register for data after the first byte
-        // thus this sets registers 0x24-0x33, 0x34-0x43, etc. in one transfer
-        for (int j = 0; j < 16; j++) {
-            g_twi_transfer_buffer[1 + j] = pwm_buffer[i + j];
-        }
+void IS31FL3731_write_register(uint8_t addr, uint8_t reg, uint8_t data) { is31_write_register(addr, reg, data); }
 
-#if ISSI_PERSISTENCE > 0
-        for (uint8_t i = 0; i < ISSI_PERSISTENCE; i++) {
-            if (i2c_transmit(addr << 1, g_twi_transfer_buffer, 17, ISSI_TIMEOUT) == 0) break;
-        }
-#else
-        i2c_transmit(addr << 1, g_twi_transfer_buffer, 17, ISSI_TIMEOUT);
-#endif
-    }
-}
+// assumes bank is already selected
+void IS31FL3731_write_pwm_buffer(uint8_t addr, uint8_t *pwm_buffer) { is31_write_pwm_buffer_chunks(&is31fl3731, addr, pwm_buffer, is31_all_pwm_chunks(&is31fl3731)); }
 
 void IS31FL3731_init(uint8_t addr) {
     // In order to avoid the LEDs being driven with garbage data
@@ -190,10 +165,12 @@ void IS31FL3731_set_color(int index, uint8_t red, uint8_t green, uint8_t blue) {
         is31_led led = g_is31_leds[index];
 
         // Subtract 0x24 to get the second index of g_pwm_buffer
-        g_pwm_buffer[led.driver][led.r - 0x24]   = red;
-        g_pwm_buffer[led.driver][led.g - 0x24]   = green;
-        g_pwm_buffer[led.driver][led.b - 0x24]   = blue;
-        g_pwm_buffer_update_required[led.driver] = true;
+        is31_set_pwm(g_pwm_buffer[led.driver], &g_pwm_buffer_dirty_chunks[led.driver], led.r - 0x24, red);
+        is31_set_pwm(g_pwm_buffer[led.driver], &g_pwm_buffer_dirty_chunks[led.driver], led.g - 0x24, green);
+        is31_set_pwm(g_pwm_buffer[led.driver], &g_pwm_buffer_dirty_chunks[led.driver], led.b - 0x24, blue);
+        if (g_pwm_buffer_dirty_chunks[led.driver]) {
+            g_pwm_buffer_update_required[led.driver] = true;
+        }
     }
 }
 
@@ -206,43 +183,23 @@ void IS31FL3731_set_color_all(uint8_t red, uint8_t green, uint8_t blue) {
 void IS31FL3731_set_led_control_register(uint8_t index, bool red, bool green, bool blue) {
     is31_led led = g_is31_leds[index];
 
-    uint8_t control_register_r = (led.r - 0x24) / 8;
-    uint8_t control_register_g = (led.g - 0x24) / 8;
-    uint8_t control_register_b = (led.b - 0x24) / 8;
-    uint8_t bit_r              = (led.r - 0x24) % 8;
-    uint8_t bit_g              = (led.g - 0x24) % 8;
-    uint8_t bit_b              = (led.b - 0x24) % 8;
-
-    if (red) {
-        g_led_control_registers[led.driver][control_register_r] |= (1 << bit_r);
-    } else {
-        g_led_control_registers[led.driver][control_register_r] &= ~(1 << bit_r);
-    }
-    if (green) {
-        g_led_control_registers[led.driver][control_register_g] |= (1 << bit_g);
-    } else {
-        g_led_control_registers[led.driver][control_register_g] &= ~(1 << bit_g);
-    }
-    if (blue) {
-        g_led_control_registers[led.driver][control_register_b] |= (1 << bit_b);
-    } else {
-        g_led_control_registers[led.driver][control_register_b] &= ~(1 << bit_b);
-    }
+    is31_set_control_bit(g_led_control_registers[led.driver], led.r - 0x24, red);
+    is31_set_control_bit(g_led_control_registers[led.driver], led.g - 0x24, green);
+    is31_set_control_bit(g_led_control_registers[led.driver], led.b - 0x24, blue);
 
     g_led_control_registers_update_required[led.driver] = true;
 }
 
 void IS31FL3731_update_pwm_buffers(uint8_t addr, uint8_t index) {
     if (g_pwm_buffer_update_required[index]) {
-        IS31FL3731_write_pwm_buffer(addr, g_pwm_buffer[index]);
+        is31_update_pwm_buffer(&is31fl3731, addr, g_pwm_buffer[index], &g_pwm_buffer_dirty_chunks[index]);
     }
     g_pwm_buffer_update_required[index] = false;
 }
 
 void IS31FL3731_update_led_control_registers(uint8_t addr, uint8_t index) {
     if (g_led_control_registers_update_required[index]) {
-        for (int i = 0; i < 18; i++) {
-            IS31FL3731_write_register(addr, i, g_led_control_registers[index][i]);
-        }
+        is31_update_control_registers(&is31fl3731, addr, g_led_control_registers[index]);
     }
+    g_led_control_registers_update_required[index] = false;
 }
@@ -25,6 +25,7 @@
 #include "is31fl3736.h"
 #include <string.h>
 #include "i2c_master.h"
+#include "is31_common.h"
 #include "progmem.h"
 
 // This is a 7-bit address, that gets left-shifted and bit 0
@@ -39,8 +40,6 @@
 // The result is: 0b101(ADDR2)(ADDR1)
 #define ISSI_ADDR_DEFAULT 0x50
 
-#define ISSI_COMMANDREGISTER 0xFD
-#define ISSI_COMMANDREGISTER_WRITELOCK 0xFE
 #define ISSI_INTERRUPTMASKREGISTER 0xF0
 #define ISSI_INTERRUPTSTATUSREGISTER 0xF1
 
@@ -55,13 +54,18 @@
 #define ISSI_REG_SWPULLUP 0x0F       // PG3
 #define ISSI_REG_CSPULLUP 0x10       // PG3
 
-#ifndef ISSI_TIMEOUT
-#    define ISSI_TIMEOUT 100
-#endif
+#define IS31FL3736_PWM_REGISTER_COUNT 192
+#define IS31FL3736_CONTROL_REGISTER_COUNT 24
 
-#ifndef ISSI_PERSISTENCE
-#    define ISSI_PERSISTENCE 0
-#endif
+static const is31_chip_t is31fl3736 = {
+    .pwm_register_offset    = 0x00,
+    .pwm_register_count     = IS31FL3736_PWM_REGISTER_COUNT,
+    .pwm_page               = ISSI_PAGE_PWM,
+    .control_register_count = IS31FL3736_CONTROL_REGISTER_COUNT,
+    .control_page           = ISSI_PAGE_LEDCONTROL,
+    .has_write_lock         = true,
+    .select_pages           = true,
+};
 
 // Transfer buffer for TWITransmitData()
 uint8_t g_twi_transfer_buffer[20];
@@ -72,50 +76,21 @@ uint8_t g_twi_transfer_buffer[20];
 // We could optimize this and take out the unused registers from these
 // buffers and the transfers in IS31FL3736_write_pwm_buffer() but it's
 // probably not worth the extra complexity.
-uint8_t g_pwm_buffer[DRIVER_COUNT][192];
+uint8_t g_pwm_buffer[DRIVER_COUNT][IS31FL3736_PWM_REGISTER_COUNT];
 bool    g_pwm_buffer_update_required = false;
 
-uint8_t g_led_control_registers[DRIVER_COUNT][24] = {{0}, {0}};
-bool    g_led_control_registers_update_required   = false;
-
-void IS31FL3736_write_register(uint8_t addr, uint8_t reg, uint8_t data) {
-    g_twi_transfer_buffer[0] = reg;
-    g_twi_transfer_buffer[1] = data;
-
-#if ISSI_PERSISTENCE > 0
-    for (uint8_t i = 0; i < ISSI_PERSISTENCE; i++) {
-        if (i2c_transmit(addr << 1, g_twi_transfer_buffer, 2, ISSI_TIMEOUT) == 0) break;
-    }
-#else
-    i2c_transmit(addr << 1, g_twi_transfer_buffer, 2, ISSI_TIMEOUT);
-#endif
-}
+// One bit for each 16 register chunk of the PWM buffer which changed since
+// the last update, only those chunks are transferred.
+uint16_t g_pwm_buffer_dirty_chunks[DRIVER_COUNT] = {0};
 
-void IS31FL3736_write_pwm_buffer(uint8_t addr, uint8_t *pwm_buffer) {
-    // assumes PG1 is already selected
+uint8_t g_led_control_registers[DRIVER_COUNT][IS31FL3736_CONTROL_REGISTER_COUNT] = {{0}, {0}};
+bool    g_led_control_registers_update_required                                  = false;
 
-    // transmit PWM registers in 12 transfers of 16 bytes
-    // g_twi_transfer_buffer[] is 20 bytes
+void IS31FL3736_write_register(uint8_t addr, uint8_t reg, uint8_t data) { is31_write_register(addr, reg, data); }
 
-    // iterate over the pwm_buffer contents at 16 byte intervals
-    for (int i = 0; i < 192; i += 16) {
-        g_twi_transfer_buffer[0] = i;
-        // copy the data from i to i+15
-        // device will auto-increment register for data after the first byte
-        // thus this sets registers 0x00-0x0F, 0x10-0x1F, etc. in one transfer
-        for (int j = 0; j < 16; j++) {
-            g_twi_transfer_buffer[1 + j] = pwm_buffer[i + j];
-        }
+void IS31FL3736_write_pwm_buffer(uint8_t addr, uint8_t *pwm_buffer) { is31_write_pwm_buffer_chunks(&is31fl3736, addr, pwm_buffer, is31_all_pwm_chunks(&is31fl3736)); }
 
-#if ISSI_PERSISTENCE > 0
-        for (uint8_t i = 0; i < ISSI_PERSISTENCE; i++) {
-            if (i2c_transmit(addr << 1, g_twi_transfer_buffer, 17, ISSI_TIMEOUT) == 0) break;
-        }
-#else
-        i2c_transmit(addr << 1, g_twi_transfer_buffer, 17, ISSI_TIMEOUT);
-#endif
-    }
-}
+void IS31FL3736_write_pwm_buffer_chunks(uint8_t addr, uint8_t *pwm_buffer, uint16_t chunks) { is31_write_pwm_buffer_chunks(&is31fl3736, addr, pwm_buffer, chunks); }
 
 void IS31FL3736_init(uint8_t addr) {
     // In order to avoid the LEDs being driven with garbage data
@@ -123,32 +98,23 @@ void IS31FL3736_init(uint8_t addr) {
     // Set up the mode and other settings, clear the PWM registers,
     // then disable software shutdown.
 
-    // Unlock the command register.
-    IS31FL3736_write_register(addr, ISSI_COMMANDREGISTER_WRITELOCK, 0xC5);
-
     // Select PG0
-    IS31FL3736_write_register(addr, ISSI_COMMANDREGISTER, ISSI_PAGE_LEDCONTROL);
+    is31_select_page(&is31fl3736, addr, ISSI_PAGE_LEDCONTROL);
     // Turn off all LEDs.
     for (int i = 0x00; i <= 0x17; i++) {
         IS31FL3736_write_register(addr, i, 0x00);
     }
 
-    // Unlock the command register.
-    IS31FL3736_write_register(addr, ISSI_COMMANDREGISTER_WRITELOCK, 0xC5);
-
     // Select PG1
-    IS31FL3736_write_register(addr, ISSI_COMMANDREGISTER, ISSI_PAGE_PWM);
+    is31_select_page(&is31fl3736, addr, ISSI_PAGE_PWM);
     // Set PWM on all LEDs to 0
     // No need to setup Breath registers to PWM as that is the default.
     for (int i = 0x00; i <= 0xBF; i++) {
         IS31FL3736_write_register(addr, i, 0x00);
     }
 
-    // Unlock the command register.
-    IS31FL3736_write_register(addr, ISSI_COMMANDREGISTER_WRITELOCK, 0xC5);
-
     // Select PG3
-    IS31FL3736_write_register(addr, ISSI_COMMANDREGISTER, ISSI_PAGE_FUNCTION);
+    is31_select_page(&is31fl3736, addr, ISSI_PAGE_FUNCTION);
     // Set global current to maximum.
     IS31FL3736_write_register(addr, ISSI_REG_GLOBALCURRENT, 0xFF);
     // Disable software shutdown.
@@ -166,10 +132,12 @@ void IS31FL3736_set_color(int index, uint8_t red, uint8_t green, uint8_t blue) {
     if (index >= 0 && index < DRIVER_LED_TOTAL) {
         is31_led led = g_is31_leds[index];
 
-        g_pwm_buffer[led.driver][led.r] = red;
-        g_pwm_buffer[led.driver][led.g] = green;
-        g_pwm_buffer[led.driver][led.b] = blue;
-        g_pwm_buffer_update_required    = true;
+        is31_set_pwm(g_pwm_buffer[led.driver], &g_pwm_buffer_dirty_chunks[led.driver], led.r, red);
+        is31_set_pwm(g_pwm_buffer[led.driver], &g_pwm_buffer_dirty_chunks[led.driver], led.g, green);
+        is31_set_pwm(g_pwm_buffer[led.driver], &g_pwm_buffer_dirty_chunks[led.driver], led.b, blue);
+        if (g_pwm_buffer_dirty_chunks[led.driver]) {
+            g_pwm_buffer_update_required = true;
+        }
     }
 }
 
@@ -195,29 +163,9 @@ void IS31FL3736_set_led_control_register(uint8_t index, bool red, bool green, bo
     // A1-A4=0x00 A5-A8=0x01
     // So, the same math applies.
 
-    uint8_t control_register_r = led.r / 8;
-    uint8_t control_register_g = led.g / 8;
-    uint8_t control_register_b = led.b / 8;
-
-    uint8_t bit_r = led.r % 8;
-    uint8_t bit_g = led.g % 8;
-    uint8_t bit_b = led.b % 8;
-
-    if (red) {
-        g_led_control_registers[led.driver][control_register_r] |= (1 << bit_r);
-    } else {
-        g_led_control_registers[led.driver][control_register_r] &= ~(1 << bit_r);
-    }
-    if (green) {
-        g_led_control_registers[led.driver][control_register_g] |= (1 << bit_g);
-    } else {
-        g_led_control_registers[led.driver][control_register_g] &= ~(1 << bit_g);
-    }
-    if (blue) {
-        g_led_control_registers[led.driver][control_register_b] |= (1 << bit_b);
-    } else {
-        g_led_control_registers[led.driver][control_register_b] &= ~(1 << bit_b);
-    }
+    is31_set_control_bit(g_led_control_registers[led.driver], led.r, red);
+    is31_set_control_bit(g_led_control_registers[led.driver], led.g, green);
+    is31_set_control_bit(g_led_control_registers[led.driver], led.b, blue);
 
     g_led_control_registers_update_required = true;
 }
@@ -226,9 +174,11 @@ void IS31FL3736_mono_set_brightness(int index, uint8_t value) {
     if (index >= 0 && index < 96) {
         // Index in range 0..95 -> A1..A8, B1..B8, etc.
         // Map index 0..95 to registers 0x00..0xBE (interleaved)
-        uint8_t pwm_register          = index * 2;
-        g_pwm_buffer[0][pwm_register] = value;
-        g_pwm_buffer_update_required  = true;
+        uint8_t pwm_register = index * 2;
+        is31_set_pwm(g_pwm_buffer[0], &g_pwm_buffer_dirty_chunks[0], pwm_register, value);
+        if (g_pwm_buffer_dirty_chunks[0]) {
+            g_pwm_buffer_update_required = true;
+        }
     }
 }
 
@@ -244,38 +194,22 @@ void IS31FL3736_mono_set_led_control_register(uint8_t index, bool enabled) {
     // Map index 0..95 to registers 0x00..0xBE (interleaved)
     uint8_t pwm_register = index * 2;
     // Map register 0x00..0xBE (interleaved) into control register and bit
-    uint8_t control_register = pwm_register / 8;
-    uint8_t bit              = pwm_register % 8;
-
-    if (enabled) {
-        g_led_control_registers[0][control_register] |= (1 << bit);
-    } else {
-        g_led_control_registers[0][control_register] &= ~(1 << bit);
-    }
+    is31_set_control_bit(g_led_control_registers[0], pwm_register, enabled);
 
     g_led_control_registers_update_required = true;
 }
 
 void IS31FL3736_update_pwm_buffers(uint8_t addr1, uint8_t addr2) {
     if (g_pwm_buffer_update_required) {
-        // Firstly we need to unlock the command register and select PG1
-        IS31FL3736_write_register(addr1, ISSI_COMMANDREGISTER_WRITELOCK, 0xC5);
-        IS31FL3736_write_register(addr1, ISSI_COMMANDREGISTER, ISSI_PAGE_PWM);
-
-        IS31FL3736_write_pwm_buffer(addr1, g_pwm_buffer[0]);
-        // IS31FL3736_write_pwm_buffer( addr2, g_pwm_buffer[1] );
+        is31_update_pwm_buffer(&is31fl3736, addr1, g_pwm_buffer[0], &g_pwm_buffer_dirty_chunks[0]);
+        // is31_update_pwm_buffer(&is31fl3736, addr2, g_pwm_buffer[1], &g_pwm_buffer_dirty_chunks[1]);
     }
     g_pwm_buffer_update_required = false;
 }
 
 void IS31FL3736_update_led_control_registers(uint8_t addr1, uint8_t addr2) {
     if (g_led_control_registers_update_required) {
-        // Firstly we need to unlock the command register and select PG0
-        IS31FL3736_write_register(addr1, ISSI_COMMANDREGISTER_WRITELOCK, 0xC5);
-        IS31FL3736_write_register(addr1, ISSI_COMMANDREGISTER, ISSI_PAGE_LEDCONTROL);
-        for (int i = 0; i < 24; i++) {
-            IS31FL3736_write_register(addr1, i, g_led_control_registers[0][i]);
-            // IS31FL3736_write_register(addr2, i, g_led_control_registers[1][i] );
-        }
+        is31_update_control_registers(&is31fl3736, addr1, g_led_control_registers[0]);
+        // is31_update_control_registers(&is31fl3736, addr2, g_led_control_registers[1]);
     }
 }
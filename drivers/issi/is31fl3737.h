@@ -34,6 +34,8 @@ extern const is31_led g_is31_leds[DRIVER_LED_TOTAL];
 void IS31FL3737_init(uint8_t addr);
 void IS31FL3737_write_register(uint8_t addr, uint8_t reg, uint8_t data);
 void IS31FL3737_write_pwm_buffer(uint8_t addr, uint8_t *pwm_buffer);
+// Only writes the 16 register chunks which have their bit set in chunks
+void IS31FL3737_write_pwm_buffer_chunks(uint8_t addr, uint8_t *pwm_buffer, uint16_t chunks);
 
 void IS31FL3737_set_color(int index, uint8_t red, uint8_t green, uint8_t blue);
 void IS31FL3737_set_color_all(uint8_t red, uint8_t green, uint8_t blue);
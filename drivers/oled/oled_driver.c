@@ -22,6 +22,10 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <string.h>
 
+#if defined(OLED_RENDER_THREAD)
+#    include "ch.h"
+#endif
+
 #if defined(__AVR__)
 #    include <avr/io.h>
 #    include <avr/pgmspace.h>
@@ -83,8 +87,10 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #define CHARGE_PUMP 0x8D
 
 // Misc defines
-#define OLED_BLOCK_COUNT (sizeof(OLED_BLOCK_TYPE) * 8)
-#define OLED_BLOCK_SIZE (OLED_MATRIX_SIZE / OLED_BLOCK_COUNT)
+#define OLED_PAGE_COUNT (OLED_DISPLAY_HEIGHT / 8)
+#define OLED_LINE_COUNT (OLED_DISPLAY_WIDTH / 8 > OLED_PAGE_COUNT ? OLED_DISPLAY_WIDTH / 8 : OLED_PAGE_COUNT)
+// Rotated bytes are staged in chunks of this size before they are sent
+#define OLED_ROTATION_CHUNK 32
 
 // i2c defines
 #define I2C_CMD 0x00
@@ -105,14 +111,30 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 // this is so we don't end up with rounding errors with
 // parts of the display unusable or don't get cleared correctly
 // and also allows for drawing & inverting
-uint8_t         oled_buffer[OLED_MATRIX_SIZE];
-uint8_t *       oled_cursor;
-OLED_BLOCK_TYPE oled_dirty          = 0;
-bool            oled_initialized    = false;
-bool            oled_active         = false;
-bool            oled_scrolling      = false;
-uint8_t         oled_rotation       = 0;
-uint8_t         oled_rotation_width = 0;
+uint8_t  oled_buffer[OLED_MATRIX_SIZE];
+uint8_t *oled_cursor;
+bool     oled_initialized    = false;
+bool     oled_active         = false;
+bool     oled_scrolling      = false;
+uint8_t  oled_rotation       = 0;
+uint8_t  oled_rotation_width = 0;
+
+// The changed bytes of each line of a buffer, from start to end, a line is
+// clean when start is past end. A line is a page of the display, or 8 of
+// its columns when it is rotated by 90 degrees.
+typedef struct {
+    uint8_t start[OLED_LINE_COUNT];
+    uint8_t end[OLED_LINE_COUNT];
+} oled_changes_t;
+
+static oled_changes_t oled_changes;
+static uint8_t        oled_line_count = 0;
+static bool           oled_dirty      = false;
+
+#if defined(OLED_RENDER_THREAD)
+static void oled_render_start(void);
+#endif
+
 #if OLED_TIMEOUT > 0
 uint32_t oled_timeout;
 #endif
@@ -139,6 +161,47 @@ static i2c_status_t i2c_transmit_P(uint8_t address, const uint8_t *data, uint16_
 }
 #endif
 
+static void oled_add_change(oled_changes_t *changes, uint8_t line, uint8_t start, uint8_t end) {
+    if (start < changes->start[line]) {
+        changes->start[line] = start;
+    }
+    if (end > changes->end[line]) {
+        changes->end[line] = end;
+    }
+}
+
+static void oled_clean_line(oled_changes_t *changes, uint8_t line) {
+    changes->start[line] = UINT8_MAX;
+    changes->end[line]   = 0;
+}
+
+static void oled_dirty_line(uint8_t line, uint8_t start, uint8_t end) {
+    oled_add_change(&oled_changes, line, start, end);
+    oled_dirty = true;
+}
+
+static void oled_dirty_all(void) {
+    for (uint8_t line = 0; line < oled_line_count; line++) {
+        oled_changes.start[line] = 0;
+        oled_changes.end[line]   = oled_rotation_width - 1;
+    }
+    oled_dirty = true;
+}
+
+// Marks length bytes of the buffer from index as changed
+static void oled_dirty_buffer(uint16_t index, uint16_t length) {
+    while (length > 0) {
+        uint8_t  offset = index % oled_rotation_width;
+        uint16_t count  = oled_rotation_width - offset;
+        if (count > length) {
+            count = length;
+        }
+        oled_dirty_line(index / oled_rotation_width, offset, offset + count - 1);
+        index += count;
+        length -= count;
+    }
+}
+
 // Flips the rendering bits for a character at the current cursor position
 static void InvertCharacter(uint8_t *cursor) {
     const uint8_t *end = cursor + OLED_FONT_WIDTH;
@@ -149,12 +212,16 @@ static void InvertCharacter(uint8_t *cursor) {
 }
 
 bool oled_init(uint8_t rotation) {
+#if defined(OLED_RENDER_THREAD)
+    oled_render_start();
+#endif
     oled_rotation = oled_init_user(rotation);
     if (!HAS_FLAGS(oled_rotation, OLED_ROTATION_90)) {
         oled_rotation_width = OLED_DISPLAY_WIDTH;
     } else {
         oled_rotation_width = OLED_DISPLAY_HEIGHT;
     }
+    oled_line_count = OLED_MATRIX_SIZE / oled_rotation_width;
     i2c_init();
 
     static const uint8_t PROGMEM display_setup1[] = {
@@ -219,109 +286,274 @@ __attribute__((weak)) oled_rotation_t oled_init_user(oled_rotation_t rotation) {
 void oled_clear(void) {
     memset(oled_buffer, 0, sizeof(oled_buffer));
     oled_cursor = &oled_buffer[0];
-    oled_dirty  = -1;  // -1 will be max value as long as display_dirty is unsigned type
+    oled_dirty_all();
 }
 
-static void calc_bounds(uint8_t update_start, uint8_t *cmd_array) {
-    // Calculate commands to set memory addressing bounds.
-    uint8_t start_page   = OLED_BLOCK_SIZE * update_start / OLED_DISPLAY_WIDTH;
-    uint8_t start_column = OLED_BLOCK_SIZE * update_start % OLED_DISPLAY_WIDTH;
+// Rotates an 8x8 block of pixels by 90 degrees, bit i of dest[k] is bit k
+// of src[7 - i]. This is the 8x8 bit matrix transpose of Hacker's Delight,
+// which swaps 2x2, 4x4 and then 2 4x4 blocks of bits in two 32 bit words
+static void rotate_90(const uint8_t *src, uint8_t *dest) {
+    uint32_t x = (uint32_t)src[0] << 24 | (uint32_t)src[1] << 16 | (uint32_t)src[2] << 8 | src[3];
+    uint32_t y = (uint32_t)src[4] << 24 | (uint32_t)src[5] << 16 | (uint32_t)src[6] << 8 | src[7];
+    uint32_t t;
+
+    t = (x ^ (x >> 7)) & 0x00AA00AA;
+    x = x ^ t ^ (t << 7);
+    t = (y ^ (y >> 7)) & 0x00AA00AA;
+    y = y ^ t ^ (t << 7);
+
+    t = (x ^ (x >> 14)) & 0x0000CCCC;
+    x = x ^ t ^ (t << 14);
+    t = (y ^ (y >> 14)) & 0x0000CCCC;
+    y = y ^ t ^ (t << 14);
+
+    t = (x & 0xF0F0F0F0) | ((y >> 4) & 0x0F0F0F0F);
+    y = ((x << 4) & 0xF0F0F0F0) | (y & 0x0F0F0F0F);
+    x = t;
+
+    // The rows of the transpose are the columns from the left, which are the
+    // pages of the rotated block from the bottom
+    dest[7] = x >> 24;
+    dest[6] = x >> 16;
+    dest[5] = x >> 8;
+    dest[4] = x;
+    dest[3] = y >> 24;
+    dest[2] = y >> 16;
+    dest[1] = y >> 8;
+    dest[0] = y;
+}
+
+// Finds the next area of a buffer to send, from the first dirty line on for
+// as long as the next lines have changes in the same bytes. Returns false
+// when the whole buffer is clean.
+static bool oled_next_area(const oled_changes_t *changes, uint8_t *first_line, uint8_t *last_line, uint8_t *start, uint8_t *end) {
+    uint8_t line = 0;
+    while (line < oled_line_count && changes->start[line] > changes->end[line]) {
+        ++line;
+    }
+    if (line == oled_line_count) {
+        return false;
+    }
+
+    *first_line = line;
+    *start      = changes->start[line];
+    *end        = changes->end[line];
+    while (++line < oled_line_count) {
+        // Clean lines, and changes elsewhere on the line, end the area
+        if (changes->start[line] > changes->end[line] || changes->start[line] > *end + 1 || changes->end[line] + 1 < *start) {
+            break;
+        }
+        if (changes->start[line] < *start) {
+            *start = changes->start[line];
+        }
+        if (changes->end[line] > *end) {
+            *end = changes->end[line];
+        }
+    }
+    *last_line = line - 1;
+    return true;
+}
+
+// Sets the area of the display which the following data is written to
+static bool oled_set_area(uint8_t first_page, uint8_t last_page, uint8_t start_column, uint8_t end_column) {
 #if (OLED_IC == OLED_IC_SH1106)
     // Commands for Page Addressing Mode. Sets starting page and column; has no end bound.
     // Column value must be split into high and low nybble and sent as two commands.
-    cmd_array[0] = PAM_PAGE_ADDR | start_page;
-    cmd_array[1] = PAM_SETCOLUMN_LSB | ((OLED_COLUMN_OFFSET + start_column) & 0x0f);
-    cmd_array[2] = PAM_SETCOLUMN_MSB | ((OLED_COLUMN_OFFSET + start_column) >> 4 & 0x0f);
-    cmd_array[3] = NOP;
-    cmd_array[4] = NOP;
-    cmd_array[5] = NOP;
+    (void)last_page;
+    (void)end_column;
+    static uint8_t display_start[] = {I2C_CMD, PAM_PAGE_ADDR, PAM_SETCOLUMN_LSB, PAM_SETCOLUMN_MSB};
+    display_start[1] = PAM_PAGE_ADDR | first_page;
+    display_start[2] = PAM_SETCOLUMN_LSB | ((OLED_COLUMN_OFFSET + start_column) & 0x0f);
+    display_start[3] = PAM_SETCOLUMN_MSB | ((OLED_COLUMN_OFFSET + start_column) >> 4 & 0x0f);
 #else
-    // Commands for use in Horizontal Addressing mode.
-    cmd_array[1] = start_column;
-    cmd_array[4] = start_page;
-    cmd_array[2] = (OLED_BLOCK_SIZE + OLED_DISPLAY_WIDTH - 1) % OLED_DISPLAY_WIDTH + cmd_array[1];
-    cmd_array[5] = (OLED_BLOCK_SIZE + OLED_DISPLAY_WIDTH - 1) / OLED_DISPLAY_WIDTH - 1;
+    // Commands for use in Horizontal Addressing mode. The data wraps to the
+    // start column of the next page after the end column, so the whole
+    // area is one window.
+    static uint8_t display_start[] = {I2C_CMD, COLUMN_ADDR, 0, OLED_DISPLAY_WIDTH - 1, PAGE_ADDR, 0, OLED_PAGE_COUNT - 1};
+    display_start[2] = start_column;
+    display_start[3] = end_column;
+    display_start[5] = first_page;
+    display_start[6] = last_page;
 #endif
+    return I2C_TRANSMIT(display_start) == I2C_STATUS_SUCCESS;
 }
 
-static void calc_bounds_90(uint8_t update_start, uint8_t *cmd_array) {
-    cmd_array[1] = OLED_BLOCK_SIZE * update_start / OLED_DISPLAY_HEIGHT * 8;
-    cmd_array[4] = OLED_BLOCK_SIZE * update_start % OLED_DISPLAY_HEIGHT;
-    cmd_array[2] = (OLED_BLOCK_SIZE + OLED_DISPLAY_HEIGHT - 1) / OLED_DISPLAY_HEIGHT * 8 - 1 + cmd_array[1];
-    ;
-    cmd_array[5] = (OLED_BLOCK_SIZE + OLED_DISPLAY_HEIGHT - 1) % OLED_DISPLAY_HEIGHT / 8;
+// Sends the columns of a page from the 8x8 tiles of the lines, rotated
+static bool oled_send_rotated_page(const uint8_t *buffer, uint8_t page, uint8_t first_line, uint8_t last_line) {
+    static uint8_t temp_buffer[OLED_ROTATION_CHUNK];
+    // The tiles of the lines start from the bottom page
+    uint8_t tile   = OLED_PAGE_COUNT - 1 - page;
+    uint8_t length = 0;
+    for (uint8_t line = first_line; line <= last_line; ++line) {
+        rotate_90(&buffer[line * OLED_DISPLAY_HEIGHT + tile * 8], &temp_buffer[length]);
+        length += 8;
+        if (length == OLED_ROTATION_CHUNK || line == last_line) {
+            if (I2C_WRITE_REG(I2C_DATA, &temp_buffer[0], length) != I2C_STATUS_SUCCESS) {
+                return false;
+            }
+            length = 0;
+        }
+    }
+    return true;
 }
 
-uint8_t crot(uint8_t a, int8_t n) {
-    const uint8_t mask = 0x7;
-    n &= mask;
-    return a << n | a >> (-n & mask);
-}
+// Sends the changes of a buffer, and stops once OLED_RENDER_BUDGET ms are
+// up when budget is set. Returns true when all of them were sent.
+static bool oled_send_changes(const uint8_t *buffer, oled_changes_t *changes, bool budget) {
+    uint16_t render_start = timer_read();
+    uint8_t  first_line, last_line, start, end;
+    while (oled_next_area(changes, &first_line, &last_line, &start, &end)) {
+        uint8_t first_page, last_page, start_column, end_column;
+        if (!HAS_FLAGS(oled_rotation, OLED_ROTATION_90)) {
+            first_page   = first_line;
+            last_page    = last_line;
+            start_column = start;
+            end_column   = end;
+        } else {
+            first_page   = OLED_PAGE_COUNT - 1 - end / 8;
+            last_page    = OLED_PAGE_COUNT - 1 - start / 8;
+            start_column = first_line * 8;
+            end_column   = last_line * 8 + 7;
+        }
 
-static void rotate_90(const uint8_t *src, uint8_t *dest) {
-    for (uint8_t i = 0, shift = 7; i < 8; ++i, --shift) {
-        uint8_t selector = (1 << i);
-        for (uint8_t j = 0; j < 8; ++j) {
-            dest[i] |= crot(src[j] & selector, shift - (int8_t)j);
+        for (uint8_t page = first_page; page <= last_page; ++page) {
+            // SH1106 has no end bound, so each page is set up by itself
+            if ((OLED_IC == OLED_IC_SH1106 || page == first_page) && !oled_set_area(page, last_page, start_column, end_column)) {
+                print("oled_render offset command failed\n");
+                return false;
+            }
+
+            if (!HAS_FLAGS(oled_rotation, OLED_ROTATION_90)) {
+                // Send render data chunk as is
+                if (I2C_WRITE_REG(I2C_DATA, &buffer[page * OLED_DISPLAY_WIDTH + start], end - start + 1) != I2C_STATUS_SUCCESS) {
+                    print("oled_render data failed\n");
+                    return false;
+                }
+                oled_clean_line(changes, page);
+            } else {
+                if (!oled_send_rotated_page(buffer, page, first_line, last_line)) {
+                    print("oled_render90 data failed\n");
+                    return false;
+                }
+                // The pages go down the tiles, what is left of the lines
+                // is below this tile
+                uint8_t tile_start = (OLED_PAGE_COUNT - 1 - page) * 8;
+                for (uint8_t line = first_line; line <= last_line; ++line) {
+                    if (changes->start[line] >= tile_start) {
+                        oled_clean_line(changes, line);
+                    } else if (changes->end[line] >= tile_start) {
+                        changes->end[line] = tile_start - 1;
+                    }
+                }
+            }
+
+            // The rest waits for the next call once the time is up, at least
+            // one page is sent each time
+            if (budget && timer_elapsed(render_start) >= OLED_RENDER_BUDGET) {
+                return false;
+            }
         }
     }
+    return true;
 }
 
-void oled_render(void) {
-    // Do we have work to do?
-    if (!oled_dirty || oled_scrolling) {
-        return;
+#if defined(OLED_RENDER_THREAD)
+// The thread sends a copy of the changed bytes of the buffer, so drawing
+// can go on while it waits for the I2C transfers
+static uint8_t        oled_front_buffer[OLED_MATRIX_SIZE];
+static oled_changes_t oled_front_changes;
+static BSEMAPHORE_DECL(oled_render_wakeup, true);
+// Taken while the thread has changes to send
+static BSEMAPHORE_DECL(oled_render_idle, false);
+
+static THD_WORKING_AREA(oled_render_thread_wa, OLED_RENDER_THREAD_STACK_SIZE);
+static THD_FUNCTION(oled_render_thread, arg) {
+    (void)arg;
+    chRegSetThreadName("oled");
+    while (true) {
+        chBSemWait(&oled_render_wakeup);
+        // What isn't sent after an error goes out with the next changes
+        oled_send_changes(oled_front_buffer, &oled_front_changes, false);
+        chBSemSignal(&oled_render_idle);
     }
+}
+
+// Waits until the thread has sent the last changes
+static void oled_render_wait(void) {
+    chBSemWait(&oled_render_idle);
+    chBSemSignal(&oled_render_idle);
+}
 
-    // Find first dirty block
-    uint8_t update_start = 0;
-    while (!(oled_dirty & (1 << update_start))) {
-        ++update_start;
+// Starts the thread, or waits for it to finish when the display is set up
+// again, since the lines change with the rotation
+static void oled_render_start(void) {
+    static bool started = false;
+    if (started) {
+        oled_render_wait();
     }
+    for (uint8_t line = 0; line < OLED_LINE_COUNT; line++) {
+        oled_clean_line(&oled_front_changes, line);
+    }
+    if (!started) {
+        started = true;
+        chThdCreateStatic(oled_render_thread_wa, sizeof(oled_render_thread_wa), OLED_RENDER_THREAD_PRIORITY, oled_render_thread, NULL);
+    }
+}
 
-    // Set column & page position
-    static uint8_t display_start[] = {I2C_CMD, COLUMN_ADDR, 0, OLED_DISPLAY_WIDTH - 1, PAGE_ADDR, 0, OLED_DISPLAY_HEIGHT / 8 - 1};
-    if (!HAS_FLAGS(oled_rotation, OLED_ROTATION_90)) {
-        calc_bounds(update_start, &display_start[1]);  // Offset from I2C_CMD byte at the start
-    } else {
-        calc_bounds_90(update_start, &display_start[1]);  // Offset from I2C_CMD byte at the start
+// Whether the thread is still sending changes. Only oled_render_publish()
+// gives it new ones, so it stays idle until then.
+static bool oled_render_busy(void) {
+    if (chBSemWaitTimeout(&oled_render_idle, TIME_IMMEDIATE) != MSG_OK) {
+        return true;
     }
+    chBSemSignal(&oled_render_idle);
+    return false;
+}
 
-    // Send column & page position
-    if (I2C_TRANSMIT(display_start) != I2C_STATUS_SUCCESS) {
-        print("oled_render offset command failed\n");
+// Copies the changes into the front buffer and wakes up the thread, which
+// must be idle
+static void oled_render_publish(void) {
+    chBSemWait(&oled_render_idle);
+    for (uint8_t line = 0; line < oled_line_count; line++) {
+        uint8_t start = oled_changes.start[line];
+        uint8_t end   = oled_changes.end[line];
+        if (start > end) {
+            continue;
+        }
+        uint16_t index = line * oled_rotation_width + start;
+        memcpy(&oled_front_buffer[index], &oled_buffer[index], end - start + 1);
+        oled_add_change(&oled_front_changes, line, start, end);
+        oled_clean_line(&oled_changes, line);
+    }
+    oled_dirty = false;
+    chBSemSignal(&oled_render_wakeup);
+}
+#endif  // defined(OLED_RENDER_THREAD)
+
+void oled_render(void) {
+    // Do we have work to do?
+    if (!oled_dirty || oled_scrolling) {
         return;
     }
 
-    if (!HAS_FLAGS(oled_rotation, OLED_ROTATION_90)) {
-        // Send render data chunk as is
-        if (I2C_WRITE_REG(I2C_DATA, &oled_buffer[OLED_BLOCK_SIZE * update_start], OLED_BLOCK_SIZE) != I2C_STATUS_SUCCESS) {
-            print("oled_render data failed\n");
-            return;
-        }
-    } else {
-        // Rotate the render chunks
-        const static uint8_t source_map[] = OLED_SOURCE_MAP;
-        const static uint8_t target_map[] = OLED_TARGET_MAP;
-
-        static uint8_t temp_buffer[OLED_BLOCK_SIZE];
-        memset(temp_buffer, 0, sizeof(temp_buffer));
-        for (uint8_t i = 0; i < sizeof(source_map); ++i) {
-            rotate_90(&oled_buffer[OLED_BLOCK_SIZE * update_start + source_map[i]], &temp_buffer[target_map[i]]);
-        }
+#if defined(OLED_RENDER_THREAD)
+    // The changes stay for the next call while the thread is busy
+    if (oled_render_busy()) {
+        return;
+    }
 
-        // Send render data chunk after rotating
-        if (I2C_WRITE_REG(I2C_DATA, &temp_buffer[0], OLED_BLOCK_SIZE) != I2C_STATUS_SUCCESS) {
-            print("oled_render90 data failed\n");
-            return;
-        }
+    // Turn on display if it is off, before the thread gets the changes so
+    // that oled_on() doesn't wait for them to be sent
+    oled_on();
+    oled_render_publish();
+#else
+    if (oled_send_changes(oled_buffer, &oled_changes, true)) {
+        oled_dirty = false;
     }
 
     // Turn on display if it is off
     oled_on();
-
-    // Clear dirty flag
-    oled_dirty &= ~(1 << update_start);
+#endif
 }
 
 void oled_set_cursor(uint8_t col, uint8_t line) {
@@ -408,10 +640,7 @@ void oled_write_char(const char data, bool invert) {
 
     // Dirty check
     if (memcmp(&oled_temp_buffer, oled_cursor, OLED_FONT_WIDTH)) {
-        uint16_t index = oled_cursor - &oled_buffer[0];
-        oled_dirty |= (1 << (index / OLED_BLOCK_SIZE));
-        // Edgecase check if the written data spans the 2 chunks
-        oled_dirty |= (1 << ((index + OLED_FONT_WIDTH) / OLED_BLOCK_SIZE));
+        oled_dirty_buffer(oled_cursor - &oled_buffer[0], OLED_FONT_WIDTH);
     }
 
     // Finally move to the next char
@@ -446,6 +675,168 @@ void oled_write_ln_P(const char *data, bool invert) {
 }
 #endif  // defined(__AVR__)
 
+// The size of the buffer in pixels, as it is drawn to
+static uint8_t oled_pixel_width(void) { return oled_rotation_width; }
+
+static uint8_t oled_pixel_height(void) { return oled_line_count * 8; }
+
+// Sets the bits of mask in count bytes of a line from x to on or off, and
+// marks the bytes which changed
+static void oled_write_span(uint8_t line, uint8_t x, uint8_t count, uint8_t mask, bool on) {
+    uint8_t *data  = &oled_buffer[line * oled_rotation_width + x];
+    uint8_t  first = UINT8_MAX, last = 0;
+    for (uint8_t i = 0; i < count; ++i) {
+        uint8_t value = on ? data[i] | mask : data[i] & ~mask;
+        if (value != data[i]) {
+            data[i] = value;
+            if (first == UINT8_MAX) {
+                first = i;
+            }
+            last = i;
+        }
+    }
+    if (first != UINT8_MAX) {
+        oled_dirty_line(line, x + first, x + last);
+    }
+}
+
+// The bits of the lines from y0 to y1 - 1 which lie on the given line
+static uint8_t oled_line_mask(uint8_t line, uint8_t y0, uint8_t y1) {
+    uint8_t mask = 0xFF;
+    if (line == y0 / 8) {
+        mask &= 0xFF << (y0 & 7);
+    }
+    if (line == (y1 - 1) / 8) {
+        mask &= 0xFF >> (7 - ((y1 - 1) & 7));
+    }
+    return mask;
+}
+
+void oled_write_pixel(int16_t x, int16_t y, bool on) {
+    if (x < 0 || y < 0 || x >= oled_pixel_width() || y >= oled_pixel_height()) {
+        return;
+    }
+    oled_write_span(y / 8, x, 1, 1 << (y & 7), on);
+}
+
+void oled_fill_rect(int16_t x, int16_t y, int16_t width, int16_t height, bool on) {
+    int16_t x0 = x < 0 ? 0 : x;
+    int16_t y0 = y < 0 ? 0 : y;
+    int16_t x1 = x + width > oled_pixel_width() ? oled_pixel_width() : x + width;
+    int16_t y1 = y + height > oled_pixel_height() ? oled_pixel_height() : y + height;
+    if (x0 >= x1 || y0 >= y1) {
+        return;
+    }
+
+    for (uint8_t line = y0 / 8; line * 8 < y1; ++line) {
+        oled_write_span(line, x0, x1 - x0, oled_line_mask(line, y0, y1), on);
+    }
+}
+
+void oled_draw_rect(int16_t x, int16_t y, int16_t width, int16_t height, bool on) {
+    if (width <= 0 || height <= 0) {
+        return;
+    }
+    oled_fill_rect(x, y, width, 1, on);
+    oled_fill_rect(x, y + height - 1, width, 1, on);
+    oled_fill_rect(x, y + 1, 1, height - 2, on);
+    oled_fill_rect(x + width - 1, y + 1, 1, height - 2, on);
+}
+
+void oled_draw_line(int16_t x0, int16_t y0, int16_t x1, int16_t y1, bool on) {
+    // Straight lines are filled a byte at a time
+    if (x0 == x1 || y0 == y1) {
+        int16_t x = x0 < x1 ? x0 : x1;
+        int16_t y = y0 < y1 ? y0 : y1;
+        oled_fill_rect(x, y, (x0 < x1 ? x1 - x0 : x0 - x1) + 1, (y0 < y1 ? y1 - y0 : y0 - y1) + 1, on);
+        return;
+    }
+
+    // Bresenham's line algorithm
+    int16_t dx  = x0 < x1 ? x1 - x0 : x0 - x1;
+    int16_t dy  = y0 < y1 ? y0 - y1 : y1 - y0;
+    int8_t  sx  = x0 < x1 ? 1 : -1;
+    int8_t  sy  = y0 < y1 ? 1 : -1;
+    int16_t err = dx + dy;
+    while (true) {
+        oled_write_pixel(x0, y0, on);
+        if (x0 == x1 && y0 == y1) {
+            break;
+        }
+        int16_t err2 = 2 * err;
+        if (err2 >= dy) {
+            err += dy;
+            x0 += sx;
+        }
+        if (err2 <= dx) {
+            err += dx;
+            y0 += sy;
+        }
+    }
+}
+
+// Reads a byte of sprite data, from flash on AVR when progmem is set
+static uint8_t oled_sprite_byte(const uint8_t *data, uint16_t index, bool progmem) {
+#if defined(__AVR__)
+    if (progmem) {
+        return pgm_read_byte(&data[index]);
+    }
+#else
+    (void)progmem;
+#endif
+    return data[index];
+}
+
+static void oled_draw_sprite_data(int16_t x, int16_t y, uint8_t width, uint8_t height, const uint8_t *data, bool invert, bool progmem) {
+    int16_t x0 = x < 0 ? 0 : x;
+    int16_t y0 = y < 0 ? 0 : y;
+    int16_t x1 = x + width > oled_pixel_width() ? oled_pixel_width() : x + width;
+    int16_t y1 = y + height > oled_pixel_height() ? oled_pixel_height() : y + height;
+    if (x0 >= x1 || y0 >= y1) {
+        return;
+    }
+
+    int8_t  pages = (height + 7) / 8;
+    uint8_t shift = y & 7;
+    for (uint8_t line = y0 / 8; line * 8 < y1; ++line) {
+        // The line holds the top of a sprite page, shifted down by shift,
+        // and the rest of the page above it
+        int8_t   page  = line - (y >> 3);
+        uint8_t  mask  = oled_line_mask(line, y0, y1);
+        uint8_t *dest  = &oled_buffer[line * oled_rotation_width];
+        uint8_t  first = UINT8_MAX, last = 0;
+        for (uint8_t column = x0; column < x1; ++column) {
+            uint8_t bits = 0;
+            if (page >= 0 && page < pages) {
+                bits = oled_sprite_byte(data, page * width + column - x, progmem) << shift;
+            }
+            if (shift && page > 0 && page <= pages) {
+                bits |= oled_sprite_byte(data, (page - 1) * width + column - x, progmem) >> (8 - shift);
+            }
+            if (invert) {
+                bits = ~bits;
+            }
+            uint8_t value = (dest[column] & ~mask) | (bits & mask);
+            if (value != dest[column]) {
+                dest[column] = value;
+                if (first == UINT8_MAX) {
+                    first = column;
+                }
+                last = column;
+            }
+        }
+        if (first != UINT8_MAX) {
+            oled_dirty_line(line, first, last);
+        }
+    }
+}
+
+void oled_draw_sprite(int16_t x, int16_t y, uint8_t width, uint8_t height, const uint8_t *data, bool invert) { oled_draw_sprite_data(x, y, width, height, data, invert, false); }
+
+#if defined(__AVR__)
+void oled_draw_sprite_P(int16_t x, int16_t y, uint8_t width, uint8_t height, const uint8_t *data, bool invert) { oled_draw_sprite_data(x, y, width, height, data, invert, true); }
+#endif  // defined(__AVR__)
+
 bool oled_on(void) {
 #if OLED_TIMEOUT > 0
     oled_timeout = timer_read32() + OLED_TIMEOUT;
@@ -453,6 +844,10 @@ bool oled_on(void) {
 
     static const uint8_t PROGMEM display_on[] = {I2C_CMD, DISPLAY_ON};
     if (!oled_active) {
+#if defined(OLED_RENDER_THREAD)
+        // The thread may still be sending on the bus
+        oled_render_wait();
+#endif
         if (I2C_TRANSMIT_P(display_on) != I2C_STATUS_SUCCESS) {
             print("oled_on cmd failed\n");
             return oled_active;
@@ -465,6 +860,9 @@ bool oled_on(void) {
 bool oled_off(void) {
     static const uint8_t PROGMEM display_off[] = {I2C_CMD, DISPLAY_OFF};
     if (oled_active) {
+#if defined(OLED_RENDER_THREAD)
+        oled_render_wait();
+#endif
         if (I2C_TRANSMIT_P(display_off) != I2C_STATUS_SUCCESS) {
             print("oled_off cmd failed\n");
             return oled_active;
@@ -478,6 +876,9 @@ bool oled_scroll_right(void) {
     // Dont enable scrolling if we need to update the display
     // This prevents scrolling of bad data from starting the scroll too early after init
     if (!oled_dirty && !oled_scrolling) {
+#if defined(OLED_RENDER_THREAD)
+        oled_render_wait();
+#endif
         static const uint8_t PROGMEM display_scroll_right[] = {I2C_CMD, SCROLL_RIGHT, 0x00, 0x00, 0x00, 0x0F, 0x00, 0xFF, ACTIVATE_SCROLL};
         if (I2C_TRANSMIT_P(display_scroll_right) != I2C_STATUS_SUCCESS) {
             print("oled_scroll_right cmd failed\n");
@@ -492,6 +893,9 @@ bool oled_scroll_left(void) {
     // Dont enable scrolling if we need to update the display
     // This prevents scrolling of bad data from starting the scroll too early after init
     if (!oled_dirty && !oled_scrolling) {
+#if defined(OLED_RENDER_THREAD)
+        oled_render_wait();
+#endif
         static const uint8_t PROGMEM display_scroll_left[] = {I2C_CMD, SCROLL_LEFT, 0x00, 0x00, 0x00, 0x0F, 0x00, 0xFF, ACTIVATE_SCROLL};
         if (I2C_TRANSMIT_P(display_scroll_left) != I2C_STATUS_SUCCESS) {
             print("oled_scroll_left cmd failed\n");
@@ -510,7 +914,7 @@ bool oled_scroll_off(void) {
             return oled_scrolling;
         }
         oled_scrolling = false;
-        oled_dirty     = -1;
+        oled_dirty_all();
     }
     return !oled_scrolling;
 }
@@ -36,38 +36,9 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #    ifndef OLED_MATRIX_SIZE
 #        define OLED_MATRIX_SIZE (OLED_DISPLAY_HEIGHT / 8 * OLED_DISPLAY_WIDTH)  // 1024 (compile time mathed)
 #    endif
-#    ifndef OLED_BLOCK_TYPE
-#        define OLED_BLOCK_TYPE uint16_t
-#    endif
-#    ifndef OLED_BLOCK_COUNT
-#        define OLED_BLOCK_COUNT (sizeof(OLED_BLOCK_TYPE) * 8)  // 32 (compile time mathed)
-#    endif
-#    ifndef OLED_BLOCK_SIZE
-#        define OLED_BLOCK_SIZE (OLED_MATRIX_SIZE / OLED_BLOCK_COUNT)  // 32 (compile time mathed)
-#    endif
 #    ifndef OLED_COM_PINS
 #        define OLED_COM_PINS COM_PINS_ALT
 #    endif
-
-// For 90 degree rotation, we map our internal matrix to oled matrix using fixed arrays
-// The OLED writes to it's memory horizontally, starting top left, but our memory starts bottom left in this mode
-#    ifndef OLED_SOURCE_MAP
-#        define OLED_SOURCE_MAP \
-            { 0, 8, 16, 24, 32, 40, 48, 56 }
-#    endif
-#    ifndef OLED_TARGET_MAP
-#        define OLED_TARGET_MAP \
-            { 56, 48, 40, 32, 24, 16, 8, 0 }
-#    endif
-// If OLED_BLOCK_TYPE is uint32_t, these tables would look like:
-// #define OLED_SOURCE_MAP { 32, 40, 48, 56 }
-// #define OLED_TARGET_MAP { 24, 16, 8, 0 }
-// If OLED_BLOCK_TYPE is uint16_t, these tables would look like:
-// #define OLED_SOURCE_MAP { 0, 8, 16, 24, 32, 40, 48, 56 }
-// #define OLED_TARGET_MAP { 56, 48, 40, 32, 24, 16, 8, 0 }
-// If OLED_BLOCK_TYPE is uint8_t, these tables would look like:
-// #define OLED_SOURCE_MAP { 0, 8, 16, 24, 32, 40, 48, 56, 64, 72, 80, 88, 96, 104, 112, 120 }
-// #define OLED_TARGET_MAP { 56, 120, 48, 112, 40, 104, 32, 96, 24, 88, 16, 80, 8, 72, 0, 64 }
 #else  // defined(OLED_DISPLAY_128X64)
 // Default 128x32
 #    ifndef OLED_DISPLAY_WIDTH
@@ -79,32 +50,9 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #    ifndef OLED_MATRIX_SIZE
 #        define OLED_MATRIX_SIZE (OLED_DISPLAY_HEIGHT / 8 * OLED_DISPLAY_WIDTH)  // 512 (compile time mathed)
 #    endif
-#    ifndef OLED_BLOCK_TYPE
-#        define OLED_BLOCK_TYPE uint16_t  // Type to use for segmenting the oled display for smart rendering, use unsigned types only
-#    endif
-#    ifndef OLED_BLOCK_COUNT
-#        define OLED_BLOCK_COUNT (sizeof(OLED_BLOCK_TYPE) * 8)  // 16 (compile time mathed)
-#    endif
-#    ifndef OLED_BLOCK_SIZE
-#        define OLED_BLOCK_SIZE (OLED_MATRIX_SIZE / OLED_BLOCK_COUNT)  // 32 (compile time mathed)
-#    endif
 #    ifndef OLED_COM_PINS
 #        define OLED_COM_PINS COM_PINS_SEQ
 #    endif
-
-// For 90 degree rotation, we map our internal matrix to oled matrix using fixed arrays
-// The OLED writes to it's memory horizontally, starting top left, but our memory starts bottom left in this mode
-#    ifndef OLED_SOURCE_MAP
-#        define OLED_SOURCE_MAP \
-            { 0, 8, 16, 24 }
-#    endif
-#    ifndef OLED_TARGET_MAP
-#        define OLED_TARGET_MAP \
-            { 24, 16, 8, 0 }
-#    endif
-// If OLED_BLOCK_TYPE is uint8_t, these tables would look like:
-// #define OLED_SOURCE_MAP { 0, 8, 16, 24, 32, 40, 48, 56 }
-// #define OLED_TARGET_MAP { 48, 32, 16, 0, 56, 40, 24, 8 }
 #endif  // defined(OLED_DISPLAY_CUSTOM)
 
 #if !defined(OLED_IC)
@@ -142,6 +90,28 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #    define OLED_FONT_HEIGHT 8
 #endif
 
+// Time in ms which oled_render() may spend sending the changes of the
+// buffer, the rest is sent by the next calls. At least one page of the
+// display is sent each time.
+#if !defined(OLED_RENDER_BUDGET)
+#    define OLED_RENDER_BUDGET 5
+#endif
+
+// Define OLED_RENDER_THREAD on ChibiOS to send the changes from a thread,
+// oled_render() then only copies them and returns. The budget isn't used.
+#if defined(OLED_RENDER_THREAD)
+#    if defined(__AVR__)
+#        error "OLED_RENDER_THREAD needs ChibiOS"
+#    endif
+#    if !defined(OLED_RENDER_THREAD_PRIORITY)
+#        define OLED_RENDER_THREAD_PRIORITY (NORMALPRIO + 1)
+#    endif
+// Holds a page of data on its way to i2c_writeReg()
+#    if !defined(OLED_RENDER_THREAD_STACK_SIZE)
+#        define OLED_RENDER_THREAD_STACK_SIZE 512
+#    endif
+#endif
+
 #if !defined(OLED_TIMEOUT)
 #    if defined(OLED_DISABLE_TIMEOUT)
 #        define OLED_TIMEOUT 0
@@ -170,7 +140,8 @@ oled_rotation_t oled_init_user(oled_rotation_t rotation);
 // Clears the display buffer, resets cursor position to 0, and sets the buffer to dirty for rendering
 void oled_clear(void);
 
-// Renders the dirty chunks of the buffer to oled display
+// Renders the changed parts of the buffer to oled display, for up to
+// OLED_RENDER_BUDGET ms
 void oled_render(void);
 
 // Moves cursor to character position indicated by column and line, wraps if out of bounds
@@ -222,6 +193,43 @@ void oled_write_ln_P(const char *data, bool invert);
 #    define oled_write_ln_P(data, invert) oled_write(data, invert)
 #endif  // defined(__AVR__)
 
+// The drawing functions below work in pixels of the rotated display, x from
+// the left and y from the top. Anything outside of the display is clipped,
+// and only the bytes which change are rendered.
+
+// Turns a single pixel on or off
+void oled_write_pixel(int16_t x, int16_t y, bool on);
+
+// Draws a line between two points, including both of them
+void oled_draw_line(int16_t x0, int16_t y0, int16_t x1, int16_t y1, bool on);
+
+// Draws the outline of a rectangle
+void oled_draw_rect(int16_t x, int16_t y, int16_t width, int16_t height, bool on);
+
+// Fills a rectangle, a byte at a time
+void oled_fill_rect(int16_t x, int16_t y, int16_t width, int16_t height, bool on);
+
+// Draws a 1bpp sprite over the rectangle at x and y, inverts the pixels if true
+// The data is laid out like the buffer, rows of 8 pixels high and width bytes
+// long, the bottom row padded to 8 pixels, see OLED_SPRITE_SIZE
+void oled_draw_sprite(int16_t x, int16_t y, uint8_t width, uint8_t height, const uint8_t *data, bool invert);
+
+#if defined(__AVR__)
+// Draws a 1bpp sprite from PROGMEM over the rectangle at x and y, inverts the pixels if true
+// Remapped to call 'void oled_draw_sprite(...);' on ARM
+void oled_draw_sprite_P(int16_t x, int16_t y, uint8_t width, uint8_t height, const uint8_t *data, bool invert);
+#else
+// Draws a 1bpp sprite over the rectangle at x and y, inverts the pixels if true
+#    define oled_draw_sprite_P(x, y, width, height, data, invert) oled_draw_sprite(x, y, width, height, data, invert)
+#endif  // defined(__AVR__)
+
+// The number of bytes of a sprite, sprite sheets are frames of this size one
+// after the other
+#define OLED_SPRITE_SIZE(width, height) ((width) * (((height) + 7) / 8))
+
+// The data of a frame of a sprite sheet, for oled_draw_sprite(_P)
+#define OLED_SPRITE_FRAME(data, width, height, frame) (&(data)[(frame)*OLED_SPRITE_SIZE(width, height)])
+
 // Can be used to manually turn on the screen if it is off
 // Returns true if the screen was on or turns on
 bool oled_on(void);
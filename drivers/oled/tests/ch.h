@@ -0,0 +1,48 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// /////////////////////////////////////////////////////////////////
+// The ChibiOS calls of the OLED render thread, on top of pthreads
+//
+// All semaphores share one lock, so that ch_sim_wait_idle() can tell when
+// every thread is blocked on a semaphore, which is when the render thread
+// is done with its work.
+// /////////////////////////////////////////////////////////////////
+
+typedef int msg_t;
+typedef int tprio_t;
+typedef int sysinterval_t;
+typedef void (*tfunc_t)(void *arg);
+typedef struct _thread_t thread_t;
+
+#define MSG_OK 0
+#define MSG_TIMEOUT -1
+
+#define TIME_IMMEDIATE 0
+#define TIME_INFINITE -1
+
+#define NORMALPRIO 128
+
+typedef struct {
+    bool    taken;
+    uint8_t waiting;
+} binary_semaphore_t;
+
+#define BSEMAPHORE_DECL(name, taken) binary_semaphore_t name = {taken, 0}
+
+msg_t chBSemWait(binary_semaphore_t *bsp);
+msg_t chBSemWaitTimeout(binary_semaphore_t *bsp, sysinterval_t timeout);
+void  chBSemSignal(binary_semaphore_t *bsp);
+
+#define THD_WORKING_AREA(name, size) char name[size]
+#define THD_FUNCTION(name, arg) void name(void *arg)
+
+#define chRegSetThreadName(name) (void)(name)
+
+thread_t *chThdCreateStatic(void *wsp, size_t size, tprio_t prio, tfunc_t pf, void *arg);
+
+// Waits until all the threads wait for a semaphore
+void ch_sim_wait_idle(void);
@@ -0,0 +1,81 @@
+#include <pthread.h>
+#include <stdlib.h>
+
+#include "ch.h"
+
+#define SIM_THREADS_MAX 4
+
+static pthread_mutex_t sim_lock      = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  sim_condition = PTHREAD_COND_INITIALIZER;
+// The threads created by chThdCreateStatic(), and those of them which
+// wait for a semaphore which isn't signalled yet
+static uint8_t sim_threads;
+static uint8_t sim_waiting;
+
+typedef struct {
+    tfunc_t function;
+    void *  arg;
+} sim_thread_t;
+
+static sim_thread_t sim_thread_table[SIM_THREADS_MAX];
+
+msg_t chBSemWaitTimeout(binary_semaphore_t *bsp, sysinterval_t timeout) {
+    pthread_mutex_lock(&sim_lock);
+    if (bsp->taken && timeout == TIME_IMMEDIATE) {
+        pthread_mutex_unlock(&sim_lock);
+        return MSG_TIMEOUT;
+    }
+    while (bsp->taken) {
+        bsp->waiting++;
+        sim_waiting++;
+        pthread_cond_broadcast(&sim_condition);
+        pthread_cond_wait(&sim_condition, &sim_lock);
+    }
+    bsp->taken = true;
+    pthread_mutex_unlock(&sim_lock);
+    return MSG_OK;
+}
+
+msg_t chBSemWait(binary_semaphore_t *bsp) { return chBSemWaitTimeout(bsp, TIME_INFINITE); }
+
+void chBSemSignal(binary_semaphore_t *bsp) {
+    pthread_mutex_lock(&sim_lock);
+    // The waiting threads count again if another one takes it first
+    sim_waiting -= bsp->waiting;
+    bsp->waiting = 0;
+    bsp->taken   = false;
+    pthread_cond_broadcast(&sim_condition);
+    pthread_mutex_unlock(&sim_lock);
+}
+
+static void *sim_thread(void *arg) {
+    sim_thread_t *thread = arg;
+    thread->function(thread->arg);
+    return NULL;
+}
+
+thread_t *chThdCreateStatic(void *wsp, size_t size, tprio_t prio, tfunc_t pf, void *arg) {
+    pthread_mutex_lock(&sim_lock);
+    if (sim_threads == SIM_THREADS_MAX) {
+        abort();
+    }
+    sim_thread_t *thread = &sim_thread_table[sim_threads++];
+    pthread_mutex_unlock(&sim_lock);
+
+    thread->function = pf;
+    thread->arg      = arg;
+    pthread_t handle;
+    if (pthread_create(&handle, NULL, sim_thread, thread) != 0) {
+        abort();
+    }
+    pthread_detach(handle);
+    return NULL;
+}
+
+void ch_sim_wait_idle(void) {
+    pthread_mutex_lock(&sim_lock);
+    while (sim_waiting < sim_threads) {
+        pthread_cond_wait(&sim_condition, &sim_lock);
+    }
+    pthread_mutex_unlock(&sim_lock);
+}
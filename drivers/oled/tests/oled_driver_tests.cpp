@@ -0,0 +1,495 @@
+#include "gtest/gtest.h"
+#include <string.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+extern "C" {
+#include "oled_driver.h"
+#include "oled_sim.h"
+#if defined(OLED_RENDER_THREAD)
+#    include "ch.h"
+#endif
+void set_time(uint32_t t);
+void advance_time(uint32_t ms);
+
+extern uint8_t oled_buffer[];
+}
+
+#define OLED_PAGES (OLED_DISPLAY_HEIGHT / 8)
+
+static const oled_rotation_t rotations[] = {OLED_ROTATION_0, OLED_ROTATION_90, OLED_ROTATION_180, OLED_ROTATION_270};
+
+class OledDriver : public testing::Test {
+   public:
+    OledDriver() { init(OLED_ROTATION_0); }
+
+    void init(oled_rotation_t new_rotation) {
+        set_time(0);
+        oled_sim_init();
+        rotation = new_rotation;
+        width    = (rotation & OLED_ROTATION_90) ? OLED_DISPLAY_HEIGHT : OLED_DISPLAY_WIDTH;
+        height   = OLED_MATRIX_SIZE / width * 8;
+        pixels.assign(width * height, false);
+        random_state = 1;
+        EXPECT_TRUE(oled_init(rotation));
+        flush();
+        oled_sim_clear_stats();
+    }
+
+    // Renders until everything was sent
+    void flush() {
+        for (int i = 0; i < 64; i++) {
+            oled_render();
+#if defined(OLED_RENDER_THREAD)
+            ch_sim_wait_idle();
+#endif
+        }
+    }
+
+    bool buffer_pixel(int x, int y) { return oled_buffer[(y / 8) * width + x] & (1 << (y & 7)); }
+
+    // The pixel of the rotated buffer on the display
+    bool display_pixel(int x, int y) {
+        switch (rotation) {
+            case OLED_ROTATION_90:
+                return oled_sim_pixel(y, OLED_DISPLAY_HEIGHT - 1 - x);
+            case OLED_ROTATION_180:
+                return oled_sim_pixel(OLED_DISPLAY_WIDTH - 1 - x, OLED_DISPLAY_HEIGHT - 1 - y);
+            case OLED_ROTATION_270:
+                return oled_sim_pixel(OLED_DISPLAY_WIDTH - 1 - y, x);
+            default:
+                return oled_sim_pixel(x, y);
+        }
+    }
+
+    bool display_matches_buffer() {
+        for (int y = 0; y < height; y++) {
+            for (int x = 0; x < width; x++) {
+                if (display_pixel(x, y) != buffer_pixel(x, y)) {
+                    ADD_FAILURE() << "pixel " << x << ", " << y << " of rotation " << rotation;
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    // The drawing functions against a plain model of the pixels
+    void model_pixel(int x, int y, bool on) {
+        if (x >= 0 && y >= 0 && x < width && y < height) {
+            pixels[y * width + x] = on;
+        }
+    }
+
+    void model_fill(int x, int y, int w, int h, bool on) {
+        for (int j = y; j < y + h; j++) {
+            for (int i = x; i < x + w; i++) {
+                model_pixel(i, j, on);
+            }
+        }
+    }
+
+    bool buffer_matches_model() {
+        for (int y = 0; y < height; y++) {
+            for (int x = 0; x < width; x++) {
+                if (buffer_pixel(x, y) != pixels[y * width + x]) {
+                    ADD_FAILURE() << "pixel " << x << ", " << y << " of rotation " << rotation;
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    // xorshift32, so that runs are reproducible on any host
+    int random(int limit) {
+        random_state ^= random_state << 13;
+        random_state ^= random_state >> 17;
+        random_state ^= random_state << 5;
+        return random_state % limit;
+    }
+
+    oled_rotation_t   rotation;
+    int               width;
+    int               height;
+    std::vector<bool> pixels;
+    uint32_t          random_state;
+};
+
+TEST_F(OledDriver, init_clears_the_whole_display) {
+    for (oled_rotation_t r : rotations) {
+        init(r);
+        EXPECT_TRUE(oled_sim_display_on());
+        EXPECT_TRUE(display_matches_buffer());
+        for (int y = 0; y < OLED_DISPLAY_HEIGHT; y++) {
+            for (int x = 0; x < OLED_DISPLAY_WIDTH; x++) {
+                ASSERT_FALSE(oled_sim_pixel(x, y)) << "pixel " << x << ", " << y << " of rotation " << r;
+            }
+        }
+        EXPECT_EQ(oled_sim_get_stats()->errors, 0u);
+    }
+}
+
+TEST_F(OledDriver, sends_only_the_changed_bytes) {
+    oled_set_cursor(2, 1);
+    oled_write_char('A', false);
+    flush();
+    EXPECT_TRUE(display_matches_buffer());
+    EXPECT_EQ(oled_sim_get_stats()->commands, 1u);
+    EXPECT_EQ(oled_sim_get_stats()->data_transfers, 1u);
+    EXPECT_EQ(oled_sim_get_stats()->data_bytes, OLED_FONT_WIDTH);
+
+    // The same character again doesn't change anything
+    oled_sim_clear_stats();
+    oled_set_cursor(2, 1);
+    oled_write_char('A', false);
+    flush();
+    EXPECT_EQ(oled_sim_get_stats()->commands, 0u);
+    EXPECT_EQ(oled_sim_get_stats()->data_bytes, 0u);
+}
+
+TEST_F(OledDriver, merges_changes_on_adjacent_lines) {
+    // The bytes of the two characters touch, so they share one window
+    oled_set_cursor(0, 0);
+    oled_write_char('A', false);
+    oled_set_cursor(1, 1);
+    oled_write_char('B', false);
+    flush();
+    EXPECT_TRUE(display_matches_buffer());
+    EXPECT_EQ(oled_sim_get_stats()->data_bytes, 4 * OLED_FONT_WIDTH);
+#if (OLED_IC == OLED_IC_SH1106)
+    // Page addressing needs a command for each page
+    EXPECT_EQ(oled_sim_get_stats()->commands, 2u);
+#else
+    EXPECT_EQ(oled_sim_get_stats()->commands, 1u);
+#endif
+}
+
+TEST_F(OledDriver, keeps_separate_changes_apart) {
+    // Apart on the same columns of two lines, and on lines apart
+    oled_set_cursor(0, 0);
+    oled_write_char('A', false);
+    oled_set_cursor(5, 1);
+    oled_write_char('B', false);
+    oled_set_cursor(0, 3);
+    oled_write_char('C', false);
+    flush();
+    EXPECT_TRUE(display_matches_buffer());
+    EXPECT_EQ(oled_sim_get_stats()->commands, 3u);
+    EXPECT_EQ(oled_sim_get_stats()->data_bytes, 3 * OLED_FONT_WIDTH);
+}
+
+TEST_F(OledDriver, merges_only_touching_bytes) {
+    // A byte apart, after and before the change of the line above
+    oled_fill_rect(0, 0, 6, 1, true);
+    oled_fill_rect(7, 8, 6, 1, true);
+    flush();
+    EXPECT_TRUE(display_matches_buffer());
+    EXPECT_EQ(oled_sim_get_stats()->commands, 2u);
+    EXPECT_EQ(oled_sim_get_stats()->data_bytes, 12u);
+
+    oled_sim_clear_stats();
+    oled_fill_rect(20, 0, 6, 1, true);
+    oled_fill_rect(13, 8, 6, 1, true);
+    flush();
+    EXPECT_TRUE(display_matches_buffer());
+    EXPECT_EQ(oled_sim_get_stats()->commands, 2u);
+    EXPECT_EQ(oled_sim_get_stats()->data_bytes, 12u);
+
+    // Touching on either side
+    oled_sim_clear_stats();
+    oled_fill_rect(40, 0, 6, 1, true);
+    oled_fill_rect(46, 8, 6, 1, true);
+    oled_fill_rect(34, 16, 6, 1, true);
+    flush();
+    EXPECT_TRUE(display_matches_buffer());
+    EXPECT_EQ(oled_sim_get_stats()->data_bytes, 3u * 18);
+#if (OLED_IC != OLED_IC_SH1106)
+    EXPECT_EQ(oled_sim_get_stats()->commands, 1u);
+#endif
+}
+
+TEST_F(OledDriver, sends_the_tiles_of_a_rotated_change) {
+    init(OLED_ROTATION_90);
+    oled_write_char('A', false);
+    flush();
+    EXPECT_TRUE(display_matches_buffer());
+    // The character lies in the first 8x8 tile of the line, which is one
+    // page of 8 columns
+    EXPECT_EQ(oled_sim_get_stats()->commands, 1u);
+    EXPECT_EQ(oled_sim_get_stats()->data_bytes, 8u);
+}
+
+TEST_F(OledDriver, renders_text_in_every_rotation) {
+    for (oled_rotation_t r : rotations) {
+        init(r);
+        for (int frame = 0; frame < 100; frame++) {
+            for (int count = random(8); count > 0; count--) {
+                oled_set_cursor(random(oled_max_chars()), random(oled_max_lines()));
+                oled_write_char('!' + random(90), random(2));
+            }
+            if (frame % 10 == 0) {
+                oled_set_cursor(0, 0);
+                oled_write("hello world hello world", false);
+            }
+            if (frame % 17 == 0) {
+                oled_clear();
+            }
+            flush();
+            ASSERT_TRUE(display_matches_buffer()) << "frame " << frame;
+        }
+        EXPECT_EQ(oled_sim_get_stats()->errors, 0u);
+    }
+}
+
+#if !defined(OLED_RENDER_THREAD)
+TEST_F(OledDriver, stops_at_the_render_budget) {
+    oled_sim_set_transfer_time(1);
+    oled_set_cursor(0, 0);
+    oled_write("hello world hello world hello world hello world", false);
+    oled_clear();
+
+    // A page is one transfer, which takes a ms
+    oled_render();
+    uint32_t pages = OLED_PAGES < OLED_RENDER_BUDGET ? OLED_PAGES : OLED_RENDER_BUDGET;
+    EXPECT_EQ(oled_sim_get_stats()->data_transfers, pages);
+    flush();
+    EXPECT_TRUE(display_matches_buffer());
+
+    // One page goes out each time, even when it takes longer
+    oled_sim_set_transfer_time(OLED_RENDER_BUDGET + 1);
+    oled_sim_clear_stats();
+    oled_clear();
+    oled_render();
+    EXPECT_EQ(oled_sim_get_stats()->data_transfers, 1u);
+    flush();
+    EXPECT_TRUE(display_matches_buffer());
+}
+
+TEST_F(OledDriver, resends_after_an_i2c_error) {
+    oled_write("hello", false);
+    oled_sim_fail_data(1);
+    oled_render();
+    EXPECT_EQ(oled_sim_get_stats()->data_bytes, 0u);
+    oled_render();
+    EXPECT_TRUE(display_matches_buffer());
+}
+#else
+TEST_F(OledDriver, resends_after_an_i2c_error) {
+    oled_write("hello", false);
+    oled_sim_fail_data(1);
+    oled_render();
+    ch_sim_wait_idle();
+    EXPECT_EQ(oled_sim_get_stats()->data_bytes, 0u);
+
+    // What failed goes out with the next changes
+    oled_write_char('!', false);
+    flush();
+    EXPECT_TRUE(display_matches_buffer());
+}
+
+TEST_F(OledDriver, draws_while_the_thread_sends) {
+    oled_sim_hold(true);
+    oled_write("hello", false);
+    oled_render();
+    std::vector<uint8_t> sent(oled_buffer, oled_buffer + OLED_MATRIX_SIZE);
+    oled_sim_wait_held();
+
+    // The thread is busy, these changes wait for the next render
+    oled_set_cursor(0, 0);
+    oled_write("world", false);
+    oled_set_cursor(0, 1);
+    oled_write("again", true);
+    oled_render();
+
+    oled_sim_hold(false);
+    ch_sim_wait_idle();
+    std::vector<uint8_t> drawn(oled_buffer, oled_buffer + OLED_MATRIX_SIZE);
+    memcpy(oled_buffer, sent.data(), OLED_MATRIX_SIZE);
+    EXPECT_TRUE(display_matches_buffer());
+    memcpy(oled_buffer, drawn.data(), OLED_MATRIX_SIZE);
+
+    flush();
+    EXPECT_TRUE(display_matches_buffer());
+    EXPECT_EQ(oled_sim_get_stats()->errors, 0u);
+}
+
+static std::atomic<bool> thread_released;
+
+// Releases the render thread once it holds in a transfer, a while later
+static void release_held_thread(void) {
+    oled_sim_wait_held();
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    thread_released = true;
+    oled_sim_hold(false);
+}
+
+TEST_F(OledDriver, shares_the_bus_with_the_thread) {
+    // Turning the display off waits for the thread
+    oled_sim_hold(true);
+    oled_write("hello", false);
+    oled_render();
+    oled_sim_wait_held();
+    std::thread release_off(release_held_thread);
+    EXPECT_TRUE(oled_off());
+    release_off.join();
+    EXPECT_FALSE(oled_sim_display_on());
+
+    // Turning it on again doesn't wait for the changes the thread sends
+    oled_sim_hold(true);
+    thread_released = false;
+    std::thread release_on(release_held_thread);
+    oled_write("world", false);
+    oled_render();
+    EXPECT_FALSE(thread_released);
+    EXPECT_TRUE(oled_sim_display_on());
+    release_on.join();
+    ch_sim_wait_idle();
+    EXPECT_TRUE(display_matches_buffer());
+    EXPECT_EQ(oled_sim_get_stats()->errors, 0u);
+}
+#endif
+
+TEST_F(OledDriver, draws_like_the_pixel_model) {
+    uint8_t sprite[4 * 32];
+    for (uint8_t &data : sprite) {
+        data = random(256);
+    }
+
+    for (oled_rotation_t r : rotations) {
+        init(r);
+        for (int i = 0; i < 1000; i++) {
+            // Around the display, to clip at each edge
+            int  x  = random(width + 40) - 20;
+            int  y  = random(height + 40) - 20;
+            int  w  = random(30) - 2;
+            int  h  = random(30) - 2;
+            bool on = random(2);
+            switch (random(5)) {
+                case 0:
+                    oled_write_pixel(x, y, on);
+                    model_pixel(x, y, on);
+                    break;
+                case 1:
+                    oled_fill_rect(x, y, w, h, on);
+                    model_fill(x, y, w, h, on);
+                    break;
+                case 2:
+                    oled_draw_rect(x, y, w, h, on);
+                    if (w > 0 && h > 0) {
+                        model_fill(x, y, w, 1, on);
+                        model_fill(x, y + h - 1, w, 1, on);
+                        model_fill(x, y, 1, h, on);
+                        model_fill(x + w - 1, y, 1, h, on);
+                    }
+                    break;
+                case 3: {
+                    // Straight lines too, which are filled as rectangles
+                    int x1 = x + w * (random(3) - 1);
+                    int y1 = y + h * (random(3) - 1);
+                    oled_draw_line(x, y, x1, y1, on);
+                    int dx  = abs(x1 - x);
+                    int dy  = -abs(y1 - y);
+                    int err = dx + dy;
+                    while (true) {
+                        model_pixel(x, y, on);
+                        if (x == x1 && y == y1) {
+                            break;
+                        }
+                        int err2 = 2 * err;
+                        if (err2 >= dy) {
+                            err += dy;
+                            x += x < x1 ? 1 : -1;
+                        }
+                        if (err2 <= dx) {
+                            err += dx;
+                            y += y < y1 ? 1 : -1;
+                        }
+                    }
+                    break;
+                }
+                default: {
+                    uint8_t sw     = 1 + random(32);
+                    uint8_t sh     = 1 + random(32);
+                    bool    invert = random(2);
+                    oled_draw_sprite(x, y, sw, sh, sprite, invert);
+                    for (int j = 0; j < sh; j++) {
+                        for (int k = 0; k < sw; k++) {
+                            bool bit = sprite[(j / 8) * sw + k] & (1 << (j & 7));
+                            model_pixel(x + k, y + j, bit != invert);
+                        }
+                    }
+                    break;
+                }
+            }
+            ASSERT_TRUE(buffer_matches_model()) << "step " << i;
+        }
+        flush();
+        EXPECT_TRUE(display_matches_buffer());
+        EXPECT_EQ(oled_sim_get_stats()->errors, 0u);
+    }
+}
+
+TEST_F(OledDriver, clips_at_the_edges) {
+    for (oled_rotation_t r : rotations) {
+        init(r);
+
+        // Nothing of these is on the display
+        oled_write_pixel(-1, 0, true);
+        oled_write_pixel(0, -1, true);
+        oled_write_pixel(width, 0, true);
+        oled_write_pixel(0, height, true);
+        oled_fill_rect(width, 0, 10, 10, true);
+        oled_fill_rect(-10, 0, 10, 10, true);
+        oled_fill_rect(0, height, 10, 10, true);
+        oled_fill_rect(0, -10, 10, 10, true);
+        oled_fill_rect(5, 5, -3, 4, true);
+        oled_fill_rect(5, 5, 4, 0, true);
+        oled_draw_rect(5, 5, 0, 0, true);
+        oled_draw_line(-10, -10, -1, -20, true);
+        oled_draw_sprite(width, 0, 8, 8, oled_buffer, false);
+        oled_draw_sprite(-8, -8, 8, 8, oled_buffer, false);
+        flush();
+        EXPECT_EQ(oled_sim_get_stats()->data_bytes, 0u);
+        ASSERT_TRUE(buffer_matches_model());
+
+        // Across each edge and corner
+        oled_fill_rect(-5, -5, 10, 10, true);
+        model_fill(-5, -5, 10, 10, true);
+        oled_fill_rect(width - 3, height - 11, 10, 10, true);
+        model_fill(width - 3, height - 11, 10, 10, true);
+        oled_draw_rect(-1, 12, width + 2, 5, true);
+        model_fill(0, 12, width, 1, true);
+        model_fill(0, 16, width, 1, true);
+        oled_draw_line(-20, 30, width + 20, 30, true);
+        model_fill(0, 30, width, 1, true);
+        oled_draw_line(width - 1, -8, width - 1, height + 8, true);
+        model_fill(width - 1, 0, 1, height, true);
+
+        // Sprites cut off above and below, shifted within the bytes
+        static const uint8_t sprite[OLED_SPRITE_SIZE(3, 12)] = {0xFF, 0x81, 0xFF, 0x0F, 0x09, 0x0F};
+        for (int y : {-5, height - 7}) {
+            oled_draw_sprite(7, y, 3, 12, sprite, false);
+            for (int j = 0; j < 12; j++) {
+                for (int k = 0; k < 3; k++) {
+                    model_pixel(7 + k, y + j, sprite[(j / 8) * 3 + k] & (1 << (j & 7)));
+                }
+            }
+        }
+
+        EXPECT_TRUE(buffer_matches_model());
+        flush();
+        EXPECT_TRUE(display_matches_buffer());
+        EXPECT_EQ(oled_sim_get_stats()->errors, 0u);
+    }
+}
+
+TEST_F(OledDriver, draws_sprite_sheet_frames) {
+    static const uint8_t sheet[OLED_SPRITE_SIZE(2, 9) * 3] = {0x01, 0x02, 0x00, 0x01, 0x03, 0x04, 0x01, 0x00, 0x05, 0x06, 0x00, 0x01};
+    oled_draw_sprite(0, 0, 2, 9, OLED_SPRITE_FRAME(sheet, 2, 9, 1), false);
+    EXPECT_EQ(oled_buffer[0], 0x03);
+    EXPECT_EQ(oled_buffer[1], 0x04);
+    EXPECT_EQ(oled_buffer[width], 0x01);
+    EXPECT_EQ(oled_buffer[width + 1], 0x00);
+}
@@ -0,0 +1,259 @@
+#include <string.h>
+
+#include "i2c_master.h"
+#include "oled_driver.h"
+#include "oled_sim.h"
+
+#if defined(OLED_RENDER_THREAD)
+#    include <pthread.h>
+#endif
+
+// From the test timer
+void advance_time(uint32_t ms);
+
+#define SIM_ADDRESS (OLED_DISPLAY_ADDRESS << 1)
+#define SIM_CONTROL_COMMAND 0x00
+#define SIM_CONTROL_DATA 0x40
+
+#if (OLED_IC == OLED_IC_SH1106)
+#    define SIM_COLUMNS OLED_SIM_COLUMNS
+#    define SIM_COLUMN_OFFSET OLED_COLUMN_OFFSET
+#else
+#    define SIM_COLUMNS 128
+#    define SIM_COLUMN_OFFSET 0
+#endif
+
+#define SIM_PAGE_ADDRESSING 0x02
+
+static uint8_t          sim_ram[OLED_SIM_PAGES][OLED_SIM_COLUMNS];
+static oled_sim_stats_t sim_stats;
+static uint16_t         sim_transfer_ms;
+static uint8_t          sim_failures;
+static bool             sim_in_transfer;
+
+static uint8_t sim_addressing;
+static uint8_t sim_column, sim_column_start, sim_column_end;
+static uint8_t sim_page, sim_page_start, sim_page_end;
+static bool    sim_segment_remap;
+static bool    sim_com_scan_dec;
+static bool    sim_display_on;
+static bool    sim_scrolling;
+
+#if defined(OLED_RENDER_THREAD)
+static pthread_mutex_t sim_lock      = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  sim_condition = PTHREAD_COND_INITIALIZER;
+static bool            sim_hold;
+static bool            sim_held;
+
+void oled_sim_hold(bool hold) {
+    pthread_mutex_lock(&sim_lock);
+    sim_hold = hold;
+    pthread_cond_broadcast(&sim_condition);
+    pthread_mutex_unlock(&sim_lock);
+}
+
+void oled_sim_wait_held(void) {
+    pthread_mutex_lock(&sim_lock);
+    while (!sim_held) {
+        pthread_cond_wait(&sim_condition, &sim_lock);
+    }
+    pthread_mutex_unlock(&sim_lock);
+}
+
+static void sim_wait_hold(void) {
+    pthread_mutex_lock(&sim_lock);
+    while (sim_hold) {
+        sim_held = true;
+        pthread_cond_broadcast(&sim_condition);
+        pthread_cond_wait(&sim_condition, &sim_lock);
+    }
+    sim_held = false;
+    pthread_mutex_unlock(&sim_lock);
+}
+#endif
+
+void oled_sim_init(void) {
+    memset(sim_ram, OLED_SIM_PATTERN, sizeof(sim_ram));
+    oled_sim_clear_stats();
+    sim_transfer_ms   = 0;
+    sim_failures      = 0;
+    sim_in_transfer   = false;
+    sim_addressing    = SIM_PAGE_ADDRESSING;
+    sim_column        = 0;
+    sim_column_start  = 0;
+    sim_column_end    = SIM_COLUMNS - 1;
+    sim_page          = 0;
+    sim_page_start    = 0;
+    sim_page_end      = OLED_SIM_PAGES - 1;
+    sim_segment_remap = false;
+    sim_com_scan_dec  = false;
+    sim_display_on    = false;
+    sim_scrolling     = false;
+}
+
+void oled_sim_set_transfer_time(uint16_t ms) { sim_transfer_ms = ms; }
+
+void oled_sim_fail_data(uint8_t count) { sim_failures = count; }
+
+uint8_t oled_sim_ram(uint8_t page, uint8_t column) { return sim_ram[page][column]; }
+
+bool oled_sim_pixel(uint8_t x, uint8_t y) {
+    uint8_t column = sim_segment_remap ? x : OLED_DISPLAY_WIDTH - 1 - x;
+    uint8_t row    = sim_com_scan_dec ? y : OLED_DISPLAY_HEIGHT - 1 - y;
+    return sim_ram[row / 8][SIM_COLUMN_OFFSET + column] & (1 << (row & 7));
+}
+
+bool oled_sim_display_on(void) { return sim_display_on; }
+
+bool oled_sim_scrolling(void) { return sim_scrolling; }
+
+const oled_sim_stats_t *oled_sim_get_stats(void) { return &sim_stats; }
+
+void oled_sim_clear_stats(void) { memset(&sim_stats, 0, sizeof(sim_stats)); }
+
+// Returns the count of parameter bytes of a command
+static uint8_t sim_command(const uint8_t *data, uint16_t length) {
+    uint8_t command = data[0];
+    switch (command) {
+        case 0xAE:
+        case 0xAF:
+            sim_display_on = command == 0xAF;
+            return 0;
+        case 0xA0:
+        case 0xA1:
+            sim_segment_remap = command == 0xA1;
+            return 0;
+        case 0xC0:
+        case 0xC8:
+            sim_com_scan_dec = command == 0xC8;
+            return 0;
+        case 0xA4:
+        case 0xA6:
+        case 0xE3:
+        case 0x40 ... 0x7F:
+            return 0;
+        case 0x2E:
+        case 0x2F:
+            sim_scrolling = command == 0x2F;
+            return 0;
+        case 0x81:
+        case 0xA8:
+        case 0xD3:
+        case 0xD5:
+        case 0xD9:
+        case 0xDA:
+        case 0xDB:
+        case 0x8D:
+            return 1;
+#if (OLED_IC == OLED_IC_SH1106)
+        case 0xB0 ... 0xB7:
+            sim_page = command & 0x07;
+            return 0;
+        case 0x00 ... 0x0F:
+            sim_column = (sim_column & 0xF0) | (command & 0x0F);
+            return 0;
+        case 0x10 ... 0x1F:
+            sim_column = (sim_column & 0x0F) | (command & 0x0F) << 4;
+            return 0;
+#else
+        case 0x20:
+            if (length > 1) {
+                sim_addressing = data[1];
+            }
+            return 1;
+        case 0x21:
+            if (length > 2) {
+                sim_column_start = sim_column = data[1];
+                sim_column_end                = data[2];
+            }
+            return 2;
+        case 0x22:
+            if (length > 2) {
+                sim_page_start = sim_page = data[1];
+                sim_page_end              = data[2];
+            }
+            return 2;
+        case 0x26:
+        case 0x27:
+            return 6;
+#endif
+        default:
+            sim_stats.errors++;
+            return 0;
+    }
+}
+
+static void sim_data(uint8_t data) {
+    if (sim_page >= OLED_SIM_PAGES || sim_column >= SIM_COLUMNS) {
+        sim_stats.errors++;
+        return;
+    }
+    sim_ram[sim_page][sim_column] = data;
+
+    if (sim_addressing == SIM_PAGE_ADDRESSING) {
+        // The column stops at the end of the page
+        if (sim_column < SIM_COLUMNS - 1) {
+            sim_column++;
+        }
+    } else if (sim_column++ == sim_column_end) {
+        sim_column = sim_column_start;
+        if (sim_page++ == sim_page_end) {
+            sim_page = sim_page_start;
+        }
+    }
+}
+
+static bool sim_begin_transfer(uint8_t address) {
+    if (address != SIM_ADDRESS || sim_in_transfer) {
+        sim_stats.errors++;
+        return false;
+    }
+    sim_in_transfer = true;
+    return true;
+}
+
+void i2c_init(void) {}
+
+i2c_status_t i2c_transmit(uint8_t address, const uint8_t *data, uint16_t length, uint16_t timeout) {
+    if (!sim_begin_transfer(address)) {
+        return I2C_STATUS_ERROR;
+    }
+    sim_stats.commands++;
+    if (length == 0 || data[0] != SIM_CONTROL_COMMAND) {
+        sim_stats.errors++;
+    } else {
+        for (uint16_t i = 1; i < length; i += 1 + sim_command(&data[i], length - i)) {
+        }
+    }
+    sim_in_transfer = false;
+    return I2C_STATUS_SUCCESS;
+}
+
+i2c_status_t i2c_writeReg(uint8_t devaddr, uint8_t regaddr, const uint8_t *data, uint16_t length, uint16_t timeout) {
+    if (!sim_begin_transfer(devaddr)) {
+        return I2C_STATUS_ERROR;
+    }
+#if defined(OLED_RENDER_THREAD)
+    sim_wait_hold();
+#endif
+
+    i2c_status_t status = I2C_STATUS_SUCCESS;
+    if (sim_failures > 0) {
+        sim_failures--;
+        status = I2C_STATUS_TIMEOUT;
+    } else if (regaddr != SIM_CONTROL_DATA) {
+        sim_stats.errors++;
+    } else {
+        sim_stats.data_transfers++;
+        sim_stats.data_bytes += length;
+        for (uint16_t i = 0; i < length; i++) {
+            sim_data(data[i]);
+        }
+    }
+
+    if (sim_transfer_ms) {
+        advance_time(sim_transfer_ms);
+    }
+    sim_in_transfer = false;
+    return status;
+}
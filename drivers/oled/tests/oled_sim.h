@@ -0,0 +1,62 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// /////////////////////////////////////////////////////////////////
+// Host simulation of the OLED controller
+//
+// Implements the i2c_master.h calls of oled_driver.c on top of the display
+// RAM of an SSD1306, or of an SH1106 when OLED_IC is OLED_IC_SH1106. The
+// commands are decoded like the controller does: SSD1306 data wraps around
+// the window of COLUMN_ADDR and PAGE_ADDR in horizontal addressing mode,
+// and SH1106 data goes along the page and column set in page addressing
+// mode. Commands the controller doesn't know count as errors.
+//
+// The RAM starts out with a pattern the tests never draw, so bytes the
+// driver didn't send show up. Each data transfer takes transfer_ms of the
+// test timer, for the render budget.
+// /////////////////////////////////////////////////////////////////
+
+// The RAM of the SH1106, the SSD1306 uses the first 128 columns
+#define OLED_SIM_COLUMNS 132
+#define OLED_SIM_PAGES 8
+
+#define OLED_SIM_PATTERN 0xA5
+
+typedef struct _oled_sim_stats_t {
+    uint32_t commands;
+    uint32_t data_transfers;
+    uint32_t data_bytes;
+    uint32_t errors;
+} oled_sim_stats_t;
+
+void oled_sim_init(void);
+
+// Each data transfer advances the test timer by this much, 0 by default
+void oled_sim_set_transfer_time(uint16_t ms);
+
+// The next count data transfers fail, without changing the RAM
+void oled_sim_fail_data(uint8_t count);
+
+uint8_t oled_sim_ram(uint8_t page, uint8_t column);
+
+// A pixel as seen on the display, in the coordinates of OLED_ROTATION_0.
+// The driver mirrors both the segments and the COM scan for it.
+bool oled_sim_pixel(uint8_t x, uint8_t y);
+
+bool oled_sim_display_on(void);
+bool oled_sim_scrolling(void);
+
+const oled_sim_stats_t *oled_sim_get_stats(void);
+void                    oled_sim_clear_stats(void);
+
+#if defined(OLED_RENDER_THREAD)
+// Holds the render thread in its next data transfer until released, so
+// the tests can draw while the thread is busy. A transfer while another
+// one is in progress counts as an error.
+void oled_sim_hold(bool hold);
+
+// Waits until the render thread holds in a transfer
+void oled_sim_wait_held(void);
+#endif
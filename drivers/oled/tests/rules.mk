@@ -0,0 +1,20 @@
+oled_driver_SRC := \
+	$(DRIVER_PATH)/oled/tests/oled_driver_tests.cpp \
+	$(DRIVER_PATH)/oled/tests/oled_sim.c \
+	$(DRIVER_PATH)/oled/oled_driver.c \
+	$(TMK_PATH)/common/test/timer.c
+
+oled_driver_INC := $(DRIVER_PATH)/oled/tests $(DRIVER_PATH)/oled
+oled_driver_DEFS := -DNO_PRINT
+
+oled_driver_128x64_SRC := $(oled_driver_SRC)
+oled_driver_128x64_INC := $(oled_driver_INC)
+oled_driver_128x64_DEFS := $(oled_driver_DEFS) -DOLED_DISPLAY_128X64
+
+oled_driver_sh1106_SRC := $(oled_driver_SRC)
+oled_driver_sh1106_INC := $(oled_driver_INC)
+oled_driver_sh1106_DEFS := $(oled_driver_DEFS) -DOLED_DISPLAY_128X64 -DOLED_IC=OLED_IC_SH1106 -DOLED_COLUMN_OFFSET=2
+
+oled_driver_thread_SRC := $(oled_driver_SRC) $(DRIVER_PATH)/oled/tests/ch_sim.c
+oled_driver_thread_INC := $(oled_driver_INC)
+oled_driver_thread_DEFS := $(oled_driver_DEFS) -DOLED_RENDER_THREAD
@@ -0,0 +1,5 @@
+TEST_LIST +=\
+	oled_driver\
+	oled_driver_128x64\
+	oled_driver_sh1106\
+	oled_driver_thread
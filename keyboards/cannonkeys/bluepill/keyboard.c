@@ -18,7 +18,7 @@ void matrix_init_kb(void){
     LED_OFF();
 
 #ifdef RGBLIGHT_ENABLE
-    leds_init();
+    ws2812_init();
 #endif
 }
 
@@ -90,7 +90,7 @@ void matrix_init_kb(void){
     wait_ms(500);
 
 #ifdef RGBLIGHT_ENABLE
-    leds_init();
+    ws2812_init();
 #endif
     backlight_init_ports();
 
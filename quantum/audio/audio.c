@@ -24,13 +24,12 @@
 #endif
 #include "print.h"
 #include "audio.h"
+#include "audio_synth.h"
 #include "keymap.h"
 #include "wait.h"
 
 #include "eeconfig.h"
 
-#define CPU_PRESCALER 8
-
 // -----------------------------------------------------------------------------
 // Timer Abstractions
 // -----------------------------------------------------------------------------
@@ -112,41 +111,39 @@
 #endif
 // -----------------------------------------------------------------------------
 
-int   voices        = 0;
-int   voice_place   = 0;
-float frequency     = 0;
-float frequency_alt = 0;
-int   volume        = 0;
-long  position      = 0;
+int      voices             = 0;
+int      voice_place        = 0;
+uint32_t current_period     = 0;
+uint32_t current_period_alt = 0;
+int      volume             = 0;
+long     position           = 0;
 
 float frequencies[8] = {0, 0, 0, 0, 0, 0, 0, 0};
-int   volumes[8]     = {0, 0, 0, 0, 0, 0, 0, 0};
-bool  sliding        = false;
+// The timer periods of the frequencies, see audio_synth.h
+uint32_t periods[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+int      volumes[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+bool     sliding    = false;
 
 float place = 0;
 
 uint8_t* sample;
 uint16_t sample_length = 0;
 
-bool     playing_notes  = false;
-bool     playing_note   = false;
-float    note_frequency = 0;
-float    note_length    = 0;
-uint8_t  note_tempo     = TEMPO_DEFAULT;
-float    note_timbre    = TIMBRE_DEFAULT;
-uint16_t note_position  = 0;
-float (*notes_pointer)[][2];
-uint16_t notes_count;
-bool     notes_repeat;
-bool     note_resting = false;
-
-uint16_t current_note = 0;
-uint8_t  rest_counter = 0;
+bool         playing_notes     = false;
+bool         playing_note      = false;
+uint8_t      note_tempo        = TEMPO_DEFAULT;
+float        note_timbre       = TIMBRE_DEFAULT;
+uint16_t     note_timbre_fixed = AUDIO_TIMBRE_FIXED(TIMBRE_DEFAULT);
+audio_song_t song;
+
+uint8_t rest_counter = 0;
 
 #ifdef VIBRATO_ENABLE
-float vibrato_counter  = 0;
 float vibrato_strength = .5;
 float vibrato_rate     = 0.125;
+
+static audio_vibrato_t vibrato_state;
+static bool            vibrato_enabled;
 #endif
 
 float polyphony_rate = 0;
@@ -171,6 +168,14 @@ float startup_song[][2]   = STARTUP_SONG;
 float audio_on_song[][2]  = AUDIO_ON_SONG;
 float audio_off_song[][2] = AUDIO_OFF_SONG;
 
+#ifdef VIBRATO_ENABLE
+static void update_vibrato(void) {
+    audio_vibrato_init(&vibrato_state, vibrato_rate, vibrato_strength);
+    vibrato_enabled = vibrato_strength > 0;
+    song.vibrato    = vibrato_enabled ? &vibrato_state : NULL;
+}
+#endif
+
 void audio_init() {
     // Check EEPROM
     if (!eeconfig_is_enabled()) {
@@ -220,6 +225,10 @@ void audio_init() {
         TIMER_1_DUTY_CYCLE = (uint16_t)((((float)F_CPU) / (440 * CPU_PRESCALER)) * note_timbre);
 #endif
 
+#ifdef VIBRATO_ENABLE
+        update_vibrato();
+#endif
+
         audio_initialized = true;
     }
 
@@ -246,14 +255,15 @@ void stop_all_notes() {
     DISABLE_AUDIO_COUNTER_1_OUTPUT;
 #endif
 
-    playing_notes = false;
-    playing_note  = false;
-    frequency     = 0;
-    frequency_alt = 0;
-    volume        = 0;
+    playing_notes      = false;
+    playing_note       = false;
+    current_period     = 0;
+    current_period_alt = 0;
+    volume             = 0;
 
     for (uint8_t i = 0; i < 8; i++) {
         frequencies[i] = 0;
+        periods[i]     = 0;
         volumes[i]     = 0;
     }
 }
@@ -268,10 +278,13 @@ void stop_note(float freq) {
         for (int i = 7; i >= 0; i--) {
             if (frequencies[i] == freq) {
                 frequencies[i] = 0;
+                periods[i]     = 0;
                 volumes[i]     = 0;
                 for (int j = i; (j < 7); j++) {
                     frequencies[j]     = frequencies[j + 1];
                     frequencies[j + 1] = 0;
+                    periods[j]         = periods[j + 1];
+                    periods[j + 1]     = 0;
                     volumes[j]         = volumes[j + 1];
                     volumes[j + 1]     = 0;
                 }
@@ -292,78 +305,53 @@ void stop_note(float freq) {
             DISABLE_AUDIO_COUNTER_1_ISR;
             DISABLE_AUDIO_COUNTER_1_OUTPUT;
 #endif
-            frequency     = 0;
-            frequency_alt = 0;
-            volume        = 0;
-            playing_note  = false;
+            current_period     = 0;
+            current_period_alt = 0;
+            volume             = 0;
+            playing_note       = false;
         }
     }
 }
 
+static inline uint32_t vibrato(uint32_t period) {
 #ifdef VIBRATO_ENABLE
-
-float mod(float a, int b) {
-    float r = fmod(a, b);
-    return r < 0 ? r + b : r;
+    if (vibrato_enabled) {
+        return audio_vibrato(&vibrato_state, period);
+    }
+#endif
+    return period;
 }
 
-float vibrato(float average_freq) {
-#    ifdef VIBRATO_STRENGTH_ENABLE
-    float vibrated_freq = average_freq * pow(vibrato_lut[(int)vibrato_counter], vibrato_strength);
-#    else
-    float vibrated_freq = average_freq * vibrato_lut[(int)vibrato_counter];
-#    endif
-    vibrato_counter = mod((vibrato_counter + vibrato_rate * (1.0 + 440.0 / average_freq)), VIBRATO_LUT_LENGTH);
-    return vibrated_freq;
-}
+static inline uint32_t envelope(uint32_t period) { return audio_envelope(period, &note_timbre_fixed); }
 
-#endif
+static inline uint32_t clamp_period(uint32_t period) { return (period == 0 || period >= AUDIO_PERIOD_LIMIT) ? AUDIO_PERIOD_CLAMP : period; }
 
 #ifdef CPIN_AUDIO
 ISR(TIMER3_AUDIO_vect) {
-    float freq;
+    uint32_t period;
 
     if (playing_note) {
         if (voices > 0) {
 #    ifdef BPIN_AUDIO
-            float freq_alt = 0;
+            uint32_t period_alt = 0;
             if (voices > 1) {
                 if (polyphony_rate == 0) {
                     if (glissando) {
-                        if (frequency_alt != 0 && frequency_alt < frequencies[voices - 2] && frequency_alt < frequencies[voices - 2] * pow(2, -440 / frequencies[voices - 2] / 12 / 2)) {
-                            frequency_alt = frequency_alt * pow(2, 440 / frequency_alt / 12 / 2);
-                        } else if (frequency_alt != 0 && frequency_alt > frequencies[voices - 2] && frequency_alt > frequencies[voices - 2] * pow(2, 440 / frequencies[voices - 2] / 12 / 2)) {
-                            frequency_alt = frequency_alt * pow(2, -440 / frequency_alt / 12 / 2);
-                        } else {
-                            frequency_alt = frequencies[voices - 2];
-                        }
+                        current_period_alt = audio_glide(current_period_alt, periods[voices - 2]);
                     } else {
-                        frequency_alt = frequencies[voices - 2];
+                        current_period_alt = periods[voices - 2];
                     }
-
-#        ifdef VIBRATO_ENABLE
-                    if (vibrato_strength > 0) {
-                        freq_alt = vibrato(frequency_alt);
-                    } else {
-                        freq_alt = frequency_alt;
-                    }
-#        else
-                    freq_alt = frequency_alt;
-#        endif
+                    period_alt = vibrato(current_period_alt);
                 }
 
                 if (envelope_index < 65535) {
                     envelope_index++;
                 }
 
-                freq_alt = voice_envelope(freq_alt);
+                period_alt = clamp_period(envelope(period_alt));
 
-                if (freq_alt < 30.517578125) {
-                    freq_alt = 30.52;
-                }
-
-                TIMER_1_PERIOD     = (uint16_t)(((float)F_CPU) / (freq_alt * CPU_PRESCALER));
-                TIMER_1_DUTY_CYCLE = (uint16_t)((((float)F_CPU) / (freq_alt * CPU_PRESCALER)) * note_timbre);
+                TIMER_1_PERIOD     = audio_period_ticks(period_alt);
+                TIMER_1_DUTY_CYCLE = audio_duty_ticks(period_alt, note_timbre_fixed);
             }
 #    endif
 
@@ -376,120 +364,38 @@ ISR(TIMER3_AUDIO_vect) {
                     }
                 }
 
-#    ifdef VIBRATO_ENABLE
-                if (vibrato_strength > 0) {
-                    freq = vibrato(frequencies[voice_place]);
-                } else {
-                    freq = frequencies[voice_place];
-                }
-#    else
-                freq = frequencies[voice_place];
-#    endif
+                period = vibrato(periods[voice_place]);
             } else {
                 if (glissando) {
-                    if (frequency != 0 && frequency < frequencies[voices - 1] && frequency < frequencies[voices - 1] * pow(2, -440 / frequencies[voices - 1] / 12 / 2)) {
-                        frequency = frequency * pow(2, 440 / frequency / 12 / 2);
-                    } else if (frequency != 0 && frequency > frequencies[voices - 1] && frequency > frequencies[voices - 1] * pow(2, 440 / frequencies[voices - 1] / 12 / 2)) {
-                        frequency = frequency * pow(2, -440 / frequency / 12 / 2);
-                    } else {
-                        frequency = frequencies[voices - 1];
-                    }
+                    current_period = audio_glide(current_period, periods[voices - 1]);
                 } else {
-                    frequency = frequencies[voices - 1];
+                    current_period = periods[voices - 1];
                 }
 
-#    ifdef VIBRATO_ENABLE
-                if (vibrato_strength > 0) {
-                    freq = vibrato(frequency);
-                } else {
-                    freq = frequency;
-                }
-#    else
-                freq = frequency;
-#    endif
+                period = vibrato(current_period);
             }
 
             if (envelope_index < 65535) {
                 envelope_index++;
             }
 
-            freq = voice_envelope(freq);
+            period = clamp_period(envelope(period));
 
-            if (freq < 30.517578125) {
-                freq = 30.52;
-            }
-
-            TIMER_3_PERIOD     = (uint16_t)(((float)F_CPU) / (freq * CPU_PRESCALER));
-            TIMER_3_DUTY_CYCLE = (uint16_t)((((float)F_CPU) / (freq * CPU_PRESCALER)) * note_timbre);
+            TIMER_3_PERIOD     = audio_period_ticks(period);
+            TIMER_3_DUTY_CYCLE = audio_duty_ticks(period, note_timbre_fixed);
         }
     }
 
     if (playing_notes) {
-        if (note_frequency > 0) {
-#    ifdef VIBRATO_ENABLE
-            if (vibrato_strength > 0) {
-                freq = vibrato(note_frequency);
-            } else {
-                freq = note_frequency;
-            }
-#    else
-            freq = note_frequency;
-#    endif
-
-            if (envelope_index < 65535) {
-                envelope_index++;
-            }
-            freq = voice_envelope(freq);
-
-            TIMER_3_PERIOD     = (uint16_t)(((float)F_CPU) / (freq * CPU_PRESCALER));
-            TIMER_3_DUTY_CYCLE = (uint16_t)((((float)F_CPU) / (freq * CPU_PRESCALER)) * note_timbre);
-        } else {
-            TIMER_3_PERIOD     = 0;
-            TIMER_3_DUTY_CYCLE = 0;
-        }
-
-        note_position++;
-        bool end_of_note = false;
-        if (TIMER_3_PERIOD > 0) {
-            if (!note_resting)
-                end_of_note = (note_position >= (note_length / TIMER_3_PERIOD * 0xFFFF - 1));
-            else
-                end_of_note = (note_position >= (note_length));
-        } else {
-            end_of_note = (note_position >= (note_length));
-        }
-
-        if (end_of_note) {
-            current_note++;
-            if (current_note >= notes_count) {
-                if (notes_repeat) {
-                    current_note = 0;
-                } else {
-                    DISABLE_AUDIO_COUNTER_3_ISR;
-                    DISABLE_AUDIO_COUNTER_3_OUTPUT;
-                    playing_notes = false;
-                    return;
-                }
-            }
-            if (!note_resting) {
-                note_resting = true;
-                current_note--;
-                if ((*notes_pointer)[current_note][0] == (*notes_pointer)[current_note + 1][0]) {
-                    note_frequency = 0;
-                    note_length    = 1;
-                } else {
-                    note_frequency = (*notes_pointer)[current_note][0];
-                    note_length    = 1;
-                }
-            } else {
-                note_resting   = false;
-                envelope_index = 0;
-                note_frequency = (*notes_pointer)[current_note][0];
-                note_length    = ((*notes_pointer)[current_note][1] / 4) * (((float)note_tempo) / 100);
-            }
-
-            note_position = 0;
+        audio_timer_t timer;
+        if (audio_song_period(&song, note_tempo, &timer) == AUDIO_SONG_OVER) {
+            DISABLE_AUDIO_COUNTER_3_ISR;
+            DISABLE_AUDIO_COUNTER_3_OUTPUT;
+            playing_notes = false;
+            return;
         }
+        TIMER_3_PERIOD     = timer.period;
+        TIMER_3_DUTY_CYCLE = timer.duty;
     }
 
     if (!audio_config.enable) {
@@ -502,7 +408,7 @@ ISR(TIMER3_AUDIO_vect) {
 #ifdef BPIN_AUDIO
 ISR(TIMER1_AUDIO_vect) {
 #    if defined(BPIN_AUDIO) && !defined(CPIN_AUDIO)
-    float freq = 0;
+    uint32_t period = 0;
 
     if (playing_note) {
         if (voices > 0) {
@@ -515,120 +421,38 @@ ISR(TIMER1_AUDIO_vect) {
                     }
                 }
 
-#        ifdef VIBRATO_ENABLE
-                if (vibrato_strength > 0) {
-                    freq = vibrato(frequencies[voice_place]);
-                } else {
-                    freq = frequencies[voice_place];
-                }
-#        else
-                freq = frequencies[voice_place];
-#        endif
+                period = vibrato(periods[voice_place]);
             } else {
                 if (glissando) {
-                    if (frequency != 0 && frequency < frequencies[voices - 1] && frequency < frequencies[voices - 1] * pow(2, -440 / frequencies[voices - 1] / 12 / 2)) {
-                        frequency = frequency * pow(2, 440 / frequency / 12 / 2);
-                    } else if (frequency != 0 && frequency > frequencies[voices - 1] && frequency > frequencies[voices - 1] * pow(2, 440 / frequencies[voices - 1] / 12 / 2)) {
-                        frequency = frequency * pow(2, -440 / frequency / 12 / 2);
-                    } else {
-                        frequency = frequencies[voices - 1];
-                    }
+                    current_period = audio_glide(current_period, periods[voices - 1]);
                 } else {
-                    frequency = frequencies[voices - 1];
+                    current_period = periods[voices - 1];
                 }
 
-#        ifdef VIBRATO_ENABLE
-                if (vibrato_strength > 0) {
-                    freq = vibrato(frequency);
-                } else {
-                    freq = frequency;
-                }
-#        else
-                freq = frequency;
-#        endif
+                period = vibrato(current_period);
             }
 
             if (envelope_index < 65535) {
                 envelope_index++;
             }
 
-            freq = voice_envelope(freq);
-
-            if (freq < 30.517578125) {
-                freq = 30.52;
-            }
+            period = clamp_period(envelope(period));
 
-            TIMER_1_PERIOD     = (uint16_t)(((float)F_CPU) / (freq * CPU_PRESCALER));
-            TIMER_1_DUTY_CYCLE = (uint16_t)((((float)F_CPU) / (freq * CPU_PRESCALER)) * note_timbre);
+            TIMER_1_PERIOD     = audio_period_ticks(period);
+            TIMER_1_DUTY_CYCLE = audio_duty_ticks(period, note_timbre_fixed);
         }
     }
 
     if (playing_notes) {
-        if (note_frequency > 0) {
-#        ifdef VIBRATO_ENABLE
-            if (vibrato_strength > 0) {
-                freq = vibrato(note_frequency);
-            } else {
-                freq = note_frequency;
-            }
-#        else
-            freq = note_frequency;
-#        endif
-
-            if (envelope_index < 65535) {
-                envelope_index++;
-            }
-            freq = voice_envelope(freq);
-
-            TIMER_1_PERIOD     = (uint16_t)(((float)F_CPU) / (freq * CPU_PRESCALER));
-            TIMER_1_DUTY_CYCLE = (uint16_t)((((float)F_CPU) / (freq * CPU_PRESCALER)) * note_timbre);
-        } else {
-            TIMER_1_PERIOD     = 0;
-            TIMER_1_DUTY_CYCLE = 0;
-        }
-
-        note_position++;
-        bool end_of_note = false;
-        if (TIMER_1_PERIOD > 0) {
-            if (!note_resting)
-                end_of_note = (note_position >= (note_length / TIMER_1_PERIOD * 0xFFFF - 1));
-            else
-                end_of_note = (note_position >= (note_length));
-        } else {
-            end_of_note = (note_position >= (note_length));
-        }
-
-        if (end_of_note) {
-            current_note++;
-            if (current_note >= notes_count) {
-                if (notes_repeat) {
-                    current_note = 0;
-                } else {
-                    DISABLE_AUDIO_COUNTER_1_ISR;
-                    DISABLE_AUDIO_COUNTER_1_OUTPUT;
-                    playing_notes = false;
-                    return;
-                }
-            }
-            if (!note_resting) {
-                note_resting = true;
-                current_note--;
-                if ((*notes_pointer)[current_note][0] == (*notes_pointer)[current_note + 1][0]) {
-                    note_frequency = 0;
-                    note_length    = 1;
-                } else {
-                    note_frequency = (*notes_pointer)[current_note][0];
-                    note_length    = 1;
-                }
-            } else {
-                note_resting   = false;
-                envelope_index = 0;
-                note_frequency = (*notes_pointer)[current_note][0];
-                note_length    = ((*notes_pointer)[current_note][1] / 4) * (((float)note_tempo) / 100);
-            }
-
-            note_position = 0;
+        audio_timer_t timer;
+        if (audio_song_period(&song, note_tempo, &timer) == AUDIO_SONG_OVER) {
+            DISABLE_AUDIO_COUNTER_1_ISR;
+            DISABLE_AUDIO_COUNTER_1_OUTPUT;
+            playing_notes = false;
+            return;
         }
+        TIMER_1_PERIOD     = timer.period;
+        TIMER_1_DUTY_CYCLE = timer.duty;
     }
 
     if (!audio_config.enable) {
@@ -663,6 +487,7 @@ void play_note(float freq, int vol) {
 
         if (freq > 0) {
             frequencies[voices] = freq;
+            periods[voices]     = audio_freq_to_period(freq);
             volumes[voices]     = vol;
             voices++;
         }
@@ -703,16 +528,12 @@ void play_notes(float (*np)[][2], uint16_t n_count, bool n_repeat) {
 
         playing_notes = true;
 
-        notes_pointer = np;
-        notes_count   = n_count;
-        notes_repeat  = n_repeat;
+        place = 0;
 
-        place        = 0;
-        current_note = 0;
-
-        note_frequency = (*notes_pointer)[current_note][0];
-        note_length    = ((*notes_pointer)[current_note][1] / 4) * (((float)note_tempo) / 100);
-        note_position  = 0;
+        audio_song_start(&song, np, n_count, n_repeat, note_tempo);
+#ifdef VIBRATO_ENABLE
+        song.vibrato = vibrato_enabled ? &vibrato_state : NULL;
+#endif
 
 #ifdef CPIN_AUDIO
         ENABLE_AUDIO_COUNTER_3_ISR;
@@ -756,19 +577,37 @@ void audio_off(void) {
 
 // Vibrato rate functions
 
-void set_vibrato_rate(float rate) { vibrato_rate = rate; }
+void set_vibrato_rate(float rate) {
+    vibrato_rate = rate;
+    update_vibrato();
+}
 
-void increase_vibrato_rate(float change) { vibrato_rate *= change; }
+void increase_vibrato_rate(float change) {
+    vibrato_rate *= change;
+    update_vibrato();
+}
 
-void decrease_vibrato_rate(float change) { vibrato_rate /= change; }
+void decrease_vibrato_rate(float change) {
+    vibrato_rate /= change;
+    update_vibrato();
+}
 
 #    ifdef VIBRATO_STRENGTH_ENABLE
 
-void set_vibrato_strength(float strength) { vibrato_strength = strength; }
+void set_vibrato_strength(float strength) {
+    vibrato_strength = strength;
+    update_vibrato();
+}
 
-void increase_vibrato_strength(float change) { vibrato_strength *= change; }
+void increase_vibrato_strength(float change) {
+    vibrato_strength *= change;
+    update_vibrato();
+}
 
-void decrease_vibrato_strength(float change) { vibrato_strength /= change; }
+void decrease_vibrato_strength(float change) {
+    vibrato_strength /= change;
+    update_vibrato();
+}
 
 #    endif /* VIBRATO_STRENGTH_ENABLE */
 
@@ -33,7 +33,8 @@
 
 // #define VIBRATO_ENABLE
 
-// Enable vibrato strength/amplitude - slows down ISR too much
+// Enable vibrato strength/amplitude, the vibrato is recomputed with pow() on
+// every change of the strength
 // #define VIBRATO_STRENGTH_ENABLE
 
 typedef union {
@@ -15,6 +15,7 @@
  */
 
 #include "audio.h"
+#include "audio_mixer.h"
 #include "ch.h"
 #include "hal.h"
 
@@ -79,158 +80,56 @@ float startup_song[][2] = STARTUP_SONG;
 
 static void gpt_cb8(GPTDriver *gptp);
 
-#define DAC_BUFFER_SIZE 100
 #ifndef DAC_SAMPLE_MAX
 #    define DAC_SAMPLE_MAX 65535U
 #endif
 
-#define START_CHANNEL_1()        \
-    gptStart(&GPTD6, &gpt6cfg1); \
-    gptStartContinuous(&GPTD6, 2U)
-#define START_CHANNEL_2()        \
-    gptStart(&GPTD7, &gpt7cfg1); \
-    gptStartContinuous(&GPTD7, 2U)
-#define STOP_CHANNEL_1() gptStopTimer(&GPTD6)
-#define STOP_CHANNEL_2() gptStopTimer(&GPTD7)
-#define RESTART_CHANNEL_1() \
-    STOP_CHANNEL_1();       \
-    START_CHANNEL_1()
-#define RESTART_CHANNEL_2() \
-    STOP_CHANNEL_2();       \
-    START_CHANNEL_2()
-#define UPDATE_CHANNEL_1_FREQ(freq)              \
-    gpt6cfg1.frequency = freq * DAC_BUFFER_SIZE; \
-    RESTART_CHANNEL_1()
-#define UPDATE_CHANNEL_2_FREQ(freq)              \
-    gpt7cfg1.frequency = freq * DAC_BUFFER_SIZE; \
-    RESTART_CHANNEL_2()
-#define GET_CHANNEL_1_FREQ (uint16_t)(gpt6cfg1.frequency * DAC_BUFFER_SIZE)
-#define GET_CHANNEL_2_FREQ (uint16_t)(gpt7cfg1.frequency * DAC_BUFFER_SIZE)
+#ifndef AUDIO_DAC_SAMPLE_RATE
+#    define AUDIO_DAC_SAMPLE_RATE 44100U
+#endif
 
-/*
- * GPT6 configuration.
- */
-// static const GPTConfig gpt6cfg1 = {
-//   .frequency    = 1000000U,
-//   .callback     = NULL,
-//   .cr2          = TIM_CR2_MMS_1,    /* MMS = 010 = TRGO on Update Event.    */
-//   .dier         = 0U
-// };
-
-GPTConfig gpt6cfg1 = {.frequency = 440U * DAC_BUFFER_SIZE,
-                      .callback  = NULL,
-                      .cr2       = TIM_CR2_MMS_1, /* MMS = 010 = TRGO on Update Event.    */
-                      .dier      = 0U};
+// The DAC plays one half of the buffer while the mixer renders the other
+#ifndef AUDIO_DAC_BUFFER_SIZE
+#    define AUDIO_DAC_BUFFER_SIZE 256U
+#endif
 
-GPTConfig gpt7cfg1 = {.frequency = 440U * DAC_BUFFER_SIZE,
-                      .callback  = NULL,
-                      .cr2       = TIM_CR2_MMS_1, /* MMS = 010 = TRGO on Update Event.    */
-                      .dier      = 0U};
+// Square waves with the note timbre by default, or a wavetable from luts.c
+#ifndef AUDIO_DAC_WAVETABLE
+#    define AUDIO_DAC_WAVETABLE NULL
+#endif
+
+// GPT6 counts at 1MHz and triggers both DAC channels on each update event,
+// the sample rate is the closest one to a whole number of its ticks
+#define AUDIO_DAC_TIMER_FREQUENCY 1000000U
+#define AUDIO_DAC_TIMER_INTERVAL ((AUDIO_DAC_TIMER_FREQUENCY + AUDIO_DAC_SAMPLE_RATE / 2) / AUDIO_DAC_SAMPLE_RATE)
+
+static const GPTConfig gpt6cfg1 = {.frequency = AUDIO_DAC_TIMER_FREQUENCY,
+                                   .callback  = NULL,
+                                   .cr2       = TIM_CR2_MMS_1, /* MMS = 010 = TRGO on Update Event.    */
+                                   .dier      = 0U};
 
 GPTConfig gpt8cfg1 = {.frequency = 10,
                       .callback  = gpt_cb8,
                       .cr2       = TIM_CR2_MMS_1, /* MMS = 010 = TRGO on Update Event.    */
                       .dier      = 0U};
 
-/*
- * DAC test buffer (sine wave).
- */
-// static const dacsample_t dac_buffer[DAC_BUFFER_SIZE] = {
-//   2047, 2082, 2118, 2154, 2189, 2225, 2260, 2296, 2331, 2367, 2402, 2437,
-//   2472, 2507, 2542, 2576, 2611, 2645, 2679, 2713, 2747, 2780, 2813, 2846,
-//   2879, 2912, 2944, 2976, 3008, 3039, 3070, 3101, 3131, 3161, 3191, 3221,
-//   3250, 3278, 3307, 3335, 3362, 3389, 3416, 3443, 3468, 3494, 3519, 3544,
-//   3568, 3591, 3615, 3637, 3660, 3681, 3703, 3723, 3744, 3763, 3782, 3801,
-//   3819, 3837, 3854, 3870, 3886, 3902, 3917, 3931, 3944, 3958, 3970, 3982,
-//   3993, 4004, 4014, 4024, 4033, 4041, 4049, 4056, 4062, 4068, 4074, 4078,
-//   4082, 4086, 4089, 4091, 4092, 4093, 4094, 4093, 4092, 4091, 4089, 4086,
-//   4082, 4078, 4074, 4068, 4062, 4056, 4049, 4041, 4033, 4024, 4014, 4004,
-//   3993, 3982, 3970, 3958, 3944, 3931, 3917, 3902, 3886, 3870, 3854, 3837,
-//   3819, 3801, 3782, 3763, 3744, 3723, 3703, 3681, 3660, 3637, 3615, 3591,
-//   3568, 3544, 3519, 3494, 3468, 3443, 3416, 3389, 3362, 3335, 3307, 3278,
-//   3250, 3221, 3191, 3161, 3131, 3101, 3070, 3039, 3008, 2976, 2944, 2912,
-//   2879, 2846, 2813, 2780, 2747, 2713, 2679, 2645, 2611, 2576, 2542, 2507,
-//   2472, 2437, 2402, 2367, 2331, 2296, 2260, 2225, 2189, 2154, 2118, 2082,
-//   2047, 2012, 1976, 1940, 1905, 1869, 1834, 1798, 1763, 1727, 1692, 1657,
-//   1622, 1587, 1552, 1518, 1483, 1449, 1415, 1381, 1347, 1314, 1281, 1248,
-//   1215, 1182, 1150, 1118, 1086, 1055, 1024,  993,  963,  933,  903,  873,
-//    844,  816,  787,  759,  732,  705,  678,  651,  626,  600,  575,  550,
-//    526,  503,  479,  457,  434,  413,  391,  371,  350,  331,  312,  293,
-//    275,  257,  240,  224,  208,  192,  177,  163,  150,  136,  124,  112,
-//    101,   90,   80,   70,   61,   53,   45,   38,   32,   26,   20,   16,
-//     12,    8,    5,    3,    2,    1,    0,    1,    2,    3,    5,    8,
-//     12,   16,   20,   26,   32,   38,   45,   53,   61,   70,   80,   90,
-//    101,  112,  124,  136,  150,  163,  177,  192,  208,  224,  240,  257,
-//    275,  293,  312,  331,  350,  371,  391,  413,  434,  457,  479,  503,
-//    526,  550,  575,  600,  626,  651,  678,  705,  732,  759,  787,  816,
-//    844,  873,  903,  933,  963,  993, 1024, 1055, 1086, 1118, 1150, 1182,
-//   1215, 1248, 1281, 1314, 1347, 1381, 1415, 1449, 1483, 1518, 1552, 1587,
-//   1622, 1657, 1692, 1727, 1763, 1798, 1834, 1869, 1905, 1940, 1976, 2012
-// };
-
-// static const dacsample_t dac_buffer_2[DAC_BUFFER_SIZE] = {
-//     12,    8,    5,    3,    2,    1,    0,    1,    2,    3,    5,    8,
-//     12,   16,   20,   26,   32,   38,   45,   53,   61,   70,   80,   90,
-//    101,  112,  124,  136,  150,  163,  177,  192,  208,  224,  240,  257,
-//    275,  293,  312,  331,  350,  371,  391,  413,  434,  457,  479,  503,
-//    526,  550,  575,  600,  626,  651,  678,  705,  732,  759,  787,  816,
-//    844,  873,  903,  933,  963,  993, 1024, 1055, 1086, 1118, 1150, 1182,
-//   1215, 1248, 1281, 1314, 1347, 1381, 1415, 1449, 1483, 1518, 1552, 1587,
-//   1622, 1657, 1692, 1727, 1763, 1798, 1834, 1869, 1905, 1940, 1976, 2012,
-//   2047, 2082, 2118, 2154, 2189, 2225, 2260, 2296, 2331, 2367, 2402, 2437,
-//   2472, 2507, 2542, 2576, 2611, 2645, 2679, 2713, 2747, 2780, 2813, 2846,
-//   2879, 2912, 2944, 2976, 3008, 3039, 3070, 3101, 3131, 3161, 3191, 3221,
-//   3250, 3278, 3307, 3335, 3362, 3389, 3416, 3443, 3468, 3494, 3519, 3544,
-//   3568, 3591, 3615, 3637, 3660, 3681, 3703, 3723, 3744, 3763, 3782, 3801,
-//   3819, 3837, 3854, 3870, 3886, 3902, 3917, 3931, 3944, 3958, 3970, 3982,
-//   3993, 4004, 4014, 4024, 4033, 4041, 4049, 4056, 4062, 4068, 4074, 4078,
-//   4082, 4086, 4089, 4091, 4092, 4093, 4094, 4093, 4092, 4091, 4089, 4086,
-//   4082, 4078, 4074, 4068, 4062, 4056, 4049, 4041, 4033, 4024, 4014, 4004,
-//   3993, 3982, 3970, 3958, 3944, 3931, 3917, 3902, 3886, 3870, 3854, 3837,
-//   3819, 3801, 3782, 3763, 3744, 3723, 3703, 3681, 3660, 3637, 3615, 3591,
-//   3568, 3544, 3519, 3494, 3468, 3443, 3416, 3389, 3362, 3335, 3307, 3278,
-//   3250, 3221, 3191, 3161, 3131, 3101, 3070, 3039, 3008, 2976, 2944, 2912,
-//   2879, 2846, 2813, 2780, 2747, 2713, 2679, 2645, 2611, 2576, 2542, 2507,
-//   2472, 2437, 2402, 2367, 2331, 2296, 2260, 2225, 2189, 2154, 2118, 2082,
-//   2047, 2012, 1976, 1940, 1905, 1869, 1834, 1798, 1763, 1727, 1692, 1657,
-//   1622, 1587, 1552, 1518, 1483, 1449, 1415, 1381, 1347, 1314, 1281, 1248,
-//   1215, 1182, 1150, 1118, 1086, 1055, 1024,  993,  963,  933,  903,  873,
-//    844,  816,  787,  759,  732,  705,  678,  651,  626,  600,  575,  550,
-//    526,  503,  479,  457,  434,  413,  391,  371,  350,  331,  312,  293,
-//    275,  257,  240,  224,  208,  192,  177,  163,  150,  136,  124,  112,
-//    101,   90,   80,   70,   61,   53,   45,   38,   32,   26,   20,   16
-// };
-
-// squarewave
-static const dacsample_t dac_buffer[DAC_BUFFER_SIZE] = {
-    // First half is max, second half is 0
-    [0 ... DAC_BUFFER_SIZE / 2 - 1]               = DAC_SAMPLE_MAX,
-    [DAC_BUFFER_SIZE / 2 ... DAC_BUFFER_SIZE - 1] = 0,
-};
-
-// squarewave
-static const dacsample_t dac_buffer_2[DAC_BUFFER_SIZE] = {
-    // opposite of dac_buffer above
-    [0 ... DAC_BUFFER_SIZE / 2 - 1]               = 0,
-    [DAC_BUFFER_SIZE / 2 ... DAC_BUFFER_SIZE - 1] = DAC_SAMPLE_MAX,
-};
+static audio_mixer_t mixer;
+
+// The speaker sits between the two DAC channels, the second one gets the
+// inverted samples
+static dacsample_t dac_buffer[AUDIO_DAC_BUFFER_SIZE];
+static dacsample_t dac_buffer_2[AUDIO_DAC_BUFFER_SIZE];
 
 /*
- * DAC streaming callback.
+ * DAC streaming callback, called when either half of the buffer was played.
  */
-size_t      nx = 0, ny = 0, nz = 0;
 static void end_cb1(DACDriver *dacp, dacsample_t *buffer, size_t n) {
     (void)dacp;
 
-    nz++;
-    if (dac_buffer == buffer) {
-        nx += n;
-    } else {
-        ny += n;
-    }
-
-    if ((nz % 1000) == 0) {
-        // palTogglePad(GPIOD, GPIOD_LED3);
+    size_t offset = buffer - dac_buffer;
+    audio_mixer_render(&mixer, buffer, n);
+    for (size_t i = 0; i < n; i++) {
+        dac_buffer_2[offset + i] = DAC_SAMPLE_MAX - buffer[i];
     }
 }
 
@@ -244,13 +143,34 @@ static void error_cb1(DACDriver *dacp, dacerror_t err) {
     chSysHalt("DAC failure");
 }
 
-static const DACConfig dac1cfg1 = {.init = DAC_SAMPLE_MAX, .datamode = DAC_DHRM_12BIT_RIGHT};
+// The left aligned data register takes the top 12 bits of 16 bit samples
+#if DAC_SAMPLE_MAX > 4095U
+#    define AUDIO_DAC_DATA_MODE DAC_DHRM_12BIT_LEFT
+#else
+#    define AUDIO_DAC_DATA_MODE DAC_DHRM_12BIT_RIGHT
+#endif
+
+static const DACConfig dac1cfg1 = {.init = DAC_SAMPLE_MAX / 2, .datamode = AUDIO_DAC_DATA_MODE};
 
 static const DACConversionGroup dacgrpcfg1 = {.num_channels = 1U, .end_cb = end_cb1, .error_cb = error_cb1, .trigger = DAC_TRG(0)};
 
-static const DACConfig dac1cfg2 = {.init = DAC_SAMPLE_MAX, .datamode = DAC_DHRM_12BIT_RIGHT};
+static const DACConfig dac1cfg2 = {.init = DAC_SAMPLE_MAX / 2, .datamode = AUDIO_DAC_DATA_MODE};
+
+static const DACConversionGroup dacgrpcfg2 = {.num_channels = 1U, .end_cb = NULL, .error_cb = error_cb1, .trigger = DAC_TRG(0)};
 
-static const DACConversionGroup dacgrpcfg2 = {.num_channels = 1U, .end_cb = end_cb1, .error_cb = error_cb1, .trigger = DAC_TRG(0)};
+// Hands the held notes to the mixer right away, the control timer adds the
+// glissando, the vibrato and the envelope
+static void update_mixer_voices(void) {
+    chSysLock();
+    for (uint8_t i = 0; i < AUDIO_MIXER_VOICES; i++) {
+        if (i < voices) {
+            audio_mixer_set_voice(&mixer, i, frequencies[i], note_timbre);
+        } else {
+            audio_mixer_stop_voice(&mixer, i);
+        }
+    }
+    chSysUnlock();
+}
 
 void audio_init() {
     if (audio_initialized) {
@@ -280,16 +200,21 @@ void audio_init() {
     dacStart(&DACD2, &dac1cfg2);
 
     /*
-     * Starting GPT6/7 driver, it is used for triggering the DAC.
+     * Starting continuous conversions of silence, the mixer fills in the
+     * buffers from then on.
      */
-    START_CHANNEL_1();
-    START_CHANNEL_2();
+    audio_mixer_init(&mixer, AUDIO_DAC_TIMER_FREQUENCY / AUDIO_DAC_TIMER_INTERVAL, DAC_SAMPLE_MAX, AUDIO_DAC_WAVETABLE);
+    audio_mixer_render(&mixer, dac_buffer, AUDIO_DAC_BUFFER_SIZE);
+    audio_mixer_render(&mixer, dac_buffer_2, AUDIO_DAC_BUFFER_SIZE);
+    dacStartConversion(&DACD1, &dacgrpcfg1, dac_buffer, AUDIO_DAC_BUFFER_SIZE);
+    dacStartConversion(&DACD2, &dacgrpcfg2, dac_buffer_2, AUDIO_DAC_BUFFER_SIZE);
 
     /*
-     * Starting a continuous conversion.
+     * Starting GPT6 driver, it is used for triggering the DAC. The channels
+     * only start with it, so they stay in step.
      */
-    dacStartConversion(&DACD1, &dacgrpcfg1, (dacsample_t *)dac_buffer, DAC_BUFFER_SIZE);
-    dacStartConversion(&DACD2, &dacgrpcfg2, (dacsample_t *)dac_buffer_2, DAC_BUFFER_SIZE);
+    gptStart(&GPTD6, &gpt6cfg1);
+    gptStartContinuous(&GPTD6, AUDIO_DAC_TIMER_INTERVAL);
 
     audio_initialized = true;
 
@@ -308,8 +233,7 @@ void stop_all_notes() {
     }
     voices = 0;
 
-    gptStopTimer(&GPTD6);
-    gptStopTimer(&GPTD7);
+    audio_mixer_stop_all(&mixer);
     gptStopTimer(&GPTD8);
 
     playing_notes = false;
@@ -351,9 +275,8 @@ void stop_note(float freq) {
         if (voice_place >= voices) {
             voice_place = 0;
         }
+        update_mixer_voices();
         if (voices == 0) {
-            STOP_CHANNEL_1();
-            STOP_CHANNEL_2();
             gptStopTimer(&GPTD8);
             frequency     = 0;
             frequency_alt = 0;
@@ -387,108 +310,39 @@ static void gpt_cb8(GPTDriver *gptp) {
 
     if (playing_note) {
         if (voices > 0) {
-            float freq_alt = 0;
-            if (voices > 1) {
-                if (polyphony_rate == 0) {
-                    if (glissando) {
-                        if (frequency_alt != 0 && frequency_alt < frequencies[voices - 2] && frequency_alt < frequencies[voices - 2] * pow(2, -440 / frequencies[voices - 2] / 12 / 2)) {
-                            frequency_alt = frequency_alt * pow(2, 440 / frequency_alt / 12 / 2);
-                        } else if (frequency_alt != 0 && frequency_alt > frequencies[voices - 2] && frequency_alt > frequencies[voices - 2] * pow(2, 440 / frequencies[voices - 2] / 12 / 2)) {
-                            frequency_alt = frequency_alt * pow(2, -440 / frequency_alt / 12 / 2);
-                        } else {
-                            frequency_alt = frequencies[voices - 2];
-                        }
-                    } else {
-                        frequency_alt = frequencies[voices - 2];
-                    }
-
-#ifdef VIBRATO_ENABLE
-                    if (vibrato_strength > 0) {
-                        freq_alt = vibrato(frequency_alt);
-                    } else {
-                        freq_alt = frequency_alt;
-                    }
-#else
-                    freq_alt = frequency_alt;
-#endif
-                }
-
-                if (envelope_index < 65535) {
-                    envelope_index++;
-                }
-
-                freq_alt = voice_envelope(freq_alt);
-
-                if (freq_alt < 30.517578125) {
-                    freq_alt = 30.52;
-                }
-
-                if (GET_CHANNEL_2_FREQ != (uint16_t)freq_alt) {
-                    UPDATE_CHANNEL_2_FREQ(freq_alt);
-                } else {
-                    RESTART_CHANNEL_2();
-                }
-                // note_timbre;
-            }
-
-            if (polyphony_rate > 0) {
-                if (voices > 1) {
-                    voice_place %= voices;
-                    if (place++ > (frequencies[voice_place] / polyphony_rate)) {
-                        voice_place = (voice_place + 1) % voices;
-                        place       = 0.0;
-                    }
-                }
-
-#ifdef VIBRATO_ENABLE
-                if (vibrato_strength > 0) {
-                    freq = vibrato(frequencies[voice_place]);
-                } else {
-                    freq = frequencies[voice_place];
-                }
-#else
-                freq = frequencies[voice_place];
-#endif
-            } else {
-                if (glissando) {
-                    if (frequency != 0 && frequency < frequencies[voices - 1] && frequency < frequencies[voices - 1] * pow(2, -440 / frequencies[voices - 1] / 12 / 2)) {
-                        frequency = frequency * pow(2, 440 / frequency / 12 / 2);
-                    } else if (frequency != 0 && frequency > frequencies[voices - 1] && frequency > frequencies[voices - 1] * pow(2, 440 / frequencies[voices - 1] / 12 / 2)) {
-                        frequency = frequency * pow(2, -440 / frequency / 12 / 2);
-                    } else {
-                        frequency = frequencies[voices - 1];
-                    }
+            // The last note glides, the others are played as they are
+            if (glissando) {
+                if (frequency != 0 && frequency < frequencies[voices - 1] && frequency < frequencies[voices - 1] * pow(2, -440 / frequencies[voices - 1] / 12 / 2)) {
+                    frequency = frequency * pow(2, 440 / frequency / 12 / 2);
+                } else if (frequency != 0 && frequency > frequencies[voices - 1] && frequency > frequencies[voices - 1] * pow(2, 440 / frequencies[voices - 1] / 12 / 2)) {
+                    frequency = frequency * pow(2, -440 / frequency / 12 / 2);
                 } else {
                     frequency = frequencies[voices - 1];
                 }
+            } else {
+                frequency = frequencies[voices - 1];
+            }
 
+            // One vibrato for all of the voices, following the last note
+            float vibrato_factor = 1;
 #ifdef VIBRATO_ENABLE
-                if (vibrato_strength > 0) {
-                    freq = vibrato(frequency);
-                } else {
-                    freq = frequency;
-                }
-#else
-                freq = frequency;
-#endif
+            if (vibrato_strength > 0) {
+                vibrato_factor = vibrato(frequency) / frequency;
             }
+#endif
 
             if (envelope_index < 65535) {
                 envelope_index++;
             }
 
-            freq = voice_envelope(freq);
-
-            if (freq < 30.517578125) {
-                freq = 30.52;
-            }
-
-            if (GET_CHANNEL_1_FREQ != (uint16_t)freq) {
-                UPDATE_CHANNEL_1_FREQ(freq);
-            } else {
-                RESTART_CHANNEL_1();
+            for (uint8_t i = 0; i < AUDIO_MIXER_VOICES; i++) {
+                if (i < voices) {
+                    freq = voice_envelope((i == voices - 1 ? frequency : frequencies[i]) * vibrato_factor);
+                    audio_mixer_set_voice(&mixer, i, freq, note_timbre);
+                } else {
+                    audio_mixer_stop_voice(&mixer, i);
+                }
             }
-            // note_timbre;
         }
     }
 
@@ -509,23 +363,15 @@ static void gpt_cb8(GPTDriver *gptp) {
             }
             freq = voice_envelope(freq);
 
-            if (GET_CHANNEL_1_FREQ != (uint16_t)freq) {
-                UPDATE_CHANNEL_1_FREQ(freq);
-                UPDATE_CHANNEL_2_FREQ(freq);
-            }
-            // note_timbre;
+            audio_mixer_set_voice(&mixer, 0, freq, note_timbre);
         } else {
-            // gptStopTimer(&GPTD6);
-            // gptStopTimer(&GPTD7);
+            audio_mixer_stop_voice(&mixer, 0);
         }
 
         note_position++;
         bool end_of_note = false;
-        if (GET_CHANNEL_1_FREQ > 0) {
-            if (!note_resting)
-                end_of_note = (note_position >= (note_length * 8 - 1));
-            else
-                end_of_note = (note_position >= (note_length * 8));
+        if (!note_resting) {
+            end_of_note = (note_position >= (note_length * 8 - 1));
         } else {
             end_of_note = (note_position >= (note_length * 8));
         }
@@ -536,8 +382,7 @@ static void gpt_cb8(GPTDriver *gptp) {
                 if (notes_repeat) {
                     current_note = 0;
                 } else {
-                    STOP_CHANNEL_1();
-                    STOP_CHANNEL_2();
+                    audio_mixer_stop_all(&mixer);
                     // gptStopTimer(&GPTD8);
                     playing_notes = false;
                     return;
@@ -565,6 +410,7 @@ static void gpt_cb8(GPTDriver *gptp) {
     }
 
     if (!audio_config.enable) {
+        audio_mixer_stop_all(&mixer);
         playing_notes = false;
         playing_note  = false;
     }
@@ -593,10 +439,10 @@ void play_note(float freq, int vol) {
             voices++;
         }
 
+        update_mixer_voices();
+
         gptStart(&GPTD8, &gpt8cfg1);
         gptStartContinuous(&GPTD8, 2U);
-        RESTART_CHANNEL_1();
-        RESTART_CHANNEL_2();
     }
 }
 
@@ -626,8 +472,6 @@ void play_notes(float (*np)[][2], uint16_t n_count, bool n_repeat) {
 
         gptStart(&GPTD8, &gpt8cfg1);
         gptStartContinuous(&GPTD8, 2U);
-        RESTART_CHANNEL_1();
-        RESTART_CHANNEL_2();
     }
 }
 
@@ -0,0 +1,95 @@
+/* Copyright 2019 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "audio_mixer.h"
+
+void audio_mixer_init(audio_mixer_t *mixer, uint32_t sample_rate, uint16_t sample_max, const int16_t *wavetable) {
+    mixer->sample_rate = sample_rate;
+    mixer->sample_max  = sample_max;
+    mixer->wavetable   = wavetable;
+    audio_mixer_stop_all(mixer);
+}
+
+void audio_mixer_set_voice(audio_mixer_t *mixer, uint8_t index, float freq, float timbre) {
+    if (index >= AUDIO_MIXER_VOICES) {
+        return;
+    }
+    // Frequencies from half the sample rate up would only alias
+    if (freq <= 0 || freq >= mixer->sample_rate / 2) {
+        audio_mixer_stop_voice(mixer, index);
+        return;
+    }
+    audio_mixer_voice_t *voice = &mixer->voices[index];
+    voice->phase_step          = freq * 4294967296.0f / mixer->sample_rate;
+    voice->duty                = timbre >= 1 ? UINT32_MAX : timbre <= 0 ? 0 : (uint32_t)(timbre * 4294967296.0f);
+    if (!voice->playing) {
+        voice->phase   = 0;
+        voice->playing = true;
+    }
+}
+
+void audio_mixer_stop_voice(audio_mixer_t *mixer, uint8_t index) {
+    if (index < AUDIO_MIXER_VOICES) {
+        mixer->voices[index].playing = false;
+    }
+}
+
+void audio_mixer_stop_all(audio_mixer_t *mixer) {
+    for (uint8_t i = 0; i < AUDIO_MIXER_VOICES; i++) {
+        mixer->voices[i].playing = false;
+    }
+}
+
+static inline int16_t voice_sample(const audio_mixer_t *mixer, const audio_mixer_voice_t *voice) {
+    if (!mixer->wavetable) {
+        return voice->phase < voice->duty ? 32767 : -32767;
+    }
+    // Interpolated between the entries, with 16 bits of the phase between
+    // two entries
+    uint8_t index = voice->phase >> 24;
+    int32_t low   = mixer->wavetable[index];
+    int32_t high  = mixer->wavetable[(uint8_t)(index + 1)];
+    return low + (((high - low) * (int32_t)((voice->phase >> 8) & 0xFFFF)) >> 16);
+}
+
+void audio_mixer_render(audio_mixer_t *mixer, uint16_t *samples, uint16_t count) {
+    audio_mixer_voice_t *playing[AUDIO_MIXER_VOICES];
+    uint8_t              playing_count = 0;
+    for (uint8_t i = 0; i < AUDIO_MIXER_VOICES; i++) {
+        if (mixer->voices[i].playing) {
+            playing[playing_count++] = &mixer->voices[i];
+        }
+    }
+
+    uint16_t middle = mixer->sample_max / 2;
+    if (playing_count == 0) {
+        for (uint16_t i = 0; i < count; i++) {
+            samples[i] = middle;
+        }
+        return;
+    }
+
+    // Each voice gets its share of the range, so chords don't clip
+    int32_t gain = middle / playing_count;
+    for (uint16_t i = 0; i < count; i++) {
+        int32_t sum = 0;
+        for (uint8_t v = 0; v < playing_count; v++) {
+            sum += (voice_sample(mixer, playing[v]) * gain) >> 15;
+            playing[v]->phase += playing[v]->phase_step;
+        }
+        samples[i] = middle + sum;
+    }
+}
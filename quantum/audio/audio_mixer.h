@@ -0,0 +1,62 @@
+/* Copyright 2019 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "luts.h"
+
+/* Mixer for the DAC of audio_arm.c.
+ *
+ * The voices are summed into blocks of samples, which the DMA of the DAC
+ * plays from a circular buffer while the next block is rendered. Each voice
+ * plays a wavetable from luts.c, or a square wave with the duty cycle of
+ * the timbre when there is no wavetable.
+ */
+
+#ifndef AUDIO_MIXER_VOICES
+#    define AUDIO_MIXER_VOICES 8
+#endif
+
+typedef struct {
+    bool playing;
+    // Position in the period of the wave, a full period is 2^32
+    uint32_t phase;
+    uint32_t phase_step;
+    // Phase at which the square wave goes low
+    uint32_t duty;
+} audio_mixer_voice_t;
+
+typedef struct {
+    audio_mixer_voice_t voices[AUDIO_MIXER_VOICES];
+    uint32_t            sample_rate;
+    // The samples go from 0 to sample_max, silence is half of it
+    uint16_t sample_max;
+    // NULL for square waves
+    const int16_t *wavetable;
+} audio_mixer_t;
+
+void audio_mixer_init(audio_mixer_t *mixer, uint32_t sample_rate, uint16_t sample_max, const int16_t *wavetable);
+
+// Plays the frequency on a voice, changing the frequency of a playing voice
+// carries on from where its wave is
+void audio_mixer_set_voice(audio_mixer_t *mixer, uint8_t index, float freq, float timbre);
+void audio_mixer_stop_voice(audio_mixer_t *mixer, uint8_t index);
+void audio_mixer_stop_all(audio_mixer_t *mixer);
+
+// Renders the next count samples, the voices which are playing share the
+// range of the samples
+void audio_mixer_render(audio_mixer_t *mixer, uint16_t *samples, uint16_t count);
@@ -0,0 +1,231 @@
+/* Copyright 2019 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <math.h>
+#include <stddef.h>
+#include "audio_synth.h"
+#include "musical_notes.h"
+#include "voices.h"
+
+// these are imported from audio.c
+extern uint16_t envelope_index;
+extern float    note_timbre;
+extern float    polyphony_rate;
+extern bool     glissando;
+
+#ifdef AUDIO_VOICES
+extern voice_type voice;
+#endif
+
+// -----------------------------------------------------------------------------
+// Glissando
+// -----------------------------------------------------------------------------
+
+// The glissando moves the frequency f by 2^(440 / f / 24) per period, which
+// is 2^(period / (24 * period of 440Hz)) on the period. This is the index
+// into exp2_lut for it, with 16 fractional bits, per timer tick of the
+// period, with another 10 fractional bits.
+#define GLIDE_INDEX_SCALE ((uint32_t)(440.0f * 64 * 67108864 / (24 * AUDIO_TIMER_FREQUENCY)))
+// The period of a full octave per step, beyond the end of exp2_lut
+#define GLIDE_TICKS_LIMIT ((uint32_t)(24 * AUDIO_TIMER_FREQUENCY / 440) - 1)
+
+static uint16_t glide_factor(const uint16_t *lut, uint32_t period) {
+    uint32_t ticks = period >> 8;
+    uint32_t index = UINT32_MAX;
+    if (ticks < GLIDE_TICKS_LIMIT) {
+        index = ((ticks * GLIDE_INDEX_SCALE) >> 10) + (((period & 0xFF) * GLIDE_INDEX_SCALE) >> 18);
+    }
+    if (index >= (uint32_t)(EXP2_LUT_LENGTH - 1) << 16) {
+        index = ((uint32_t)(EXP2_LUT_LENGTH - 1) << 16) - 1;
+    }
+    uint8_t  i    = index >> 16;
+    uint16_t low  = pgm_read_word(&lut[i]);
+    uint16_t high = pgm_read_word(&lut[i + 1]);
+    return low + (((int32_t)high - low) * (int32_t)(index & 0xFFFF)) / 65536;
+}
+
+uint32_t audio_glide(uint32_t period, uint32_t target) {
+    if (period != 0 && period > target && period > audio_scale_period(target, glide_factor(exp2_lut, target))) {
+        // Below the target, the pitch goes up
+        return audio_scale_period(period, glide_factor(exp2_neg_lut, period));
+    } else if (period != 0 && period < target && period < audio_scale_period(target, glide_factor(exp2_neg_lut, target))) {
+        return audio_scale_period(period, glide_factor(exp2_lut, period));
+    }
+    return target;
+}
+
+// -----------------------------------------------------------------------------
+// Vibrato
+// -----------------------------------------------------------------------------
+
+#ifdef VIBRATO_ENABLE
+
+// The vibrato advances by rate * (1 + 440 / f) per period, this is
+// 440 / f per timer tick of the period, with 26 fractional bits
+#    define VIBRATO_RATE_SCALE ((uint32_t)(440.0f * 67108864 / AUDIO_TIMER_FREQUENCY + 0.5f))
+
+#    define VIBRATO_COUNTER_END ((uint32_t)VIBRATO_LUT_LENGTH << 16)
+
+void audio_vibrato_init(audio_vibrato_t *vibrato, float rate, float strength) {
+    // More than 4 steps per period wouldn't be a vibrato anymore
+    vibrato->rate = rate >= 4 ? 4UL << 16 : (uint32_t)(rate * 65536);
+    for (uint8_t i = 0; i < VIBRATO_LUT_LENGTH; i++) {
+#    ifdef VIBRATO_STRENGTH_ENABLE
+        float factor = pow(vibrato_lut[i], strength);
+#    else
+        float factor = vibrato_lut[i];
+#    endif
+        // A higher frequency is a shorter period
+        float period_factor = EXP2_LUT_ONE / factor + 0.5f;
+        vibrato->factors[i] = period_factor >= 0xFFFF ? 0xFFFF : period_factor;
+    }
+}
+
+uint32_t audio_vibrato(audio_vibrato_t *vibrato, uint32_t period) {
+    uint32_t vibrated = audio_scale_period(period, vibrato->factors[vibrato->counter >> 16]);
+    // The rate times the period in timer ticks, with 16 fractional bits
+    // in all, split up to keep the precision within 32 bits
+    uint32_t rate_ticks = (vibrato->rate >> 4) * (period >> 6);
+    vibrato->counter += vibrato->rate + (((rate_ticks >> 16) * VIBRATO_RATE_SCALE + (((rate_ticks & 0xFFFF) * VIBRATO_RATE_SCALE) >> 16) + 0x80) >> 8);
+    while (vibrato->counter >= VIBRATO_COUNTER_END) {
+        vibrato->counter -= VIBRATO_COUNTER_END;
+    }
+    return vibrated;
+}
+
+#endif
+
+// -----------------------------------------------------------------------------
+// Song player
+// -----------------------------------------------------------------------------
+
+// Converts a note length in beats to the counts for audio_song_step(), the
+// length in timer ticks is compared against the position times the period
+static void set_note_length(audio_song_t *song, float length) {
+    float    ticks   = length * 0xFFFF;
+    uint32_t rounded = ticks;
+
+    song->length_ticks = rounded < ticks ? rounded + 1 : rounded;
+
+    rounded              = length >= 0xFFFF ? 0xFFFF : (uint32_t)length;
+    song->length_periods = rounded < length ? rounded + 1 : rounded;
+}
+
+static void set_note(audio_song_t *song, float freq, float length) {
+    song->period = audio_freq_to_period(freq);
+    set_note_length(song, length);
+}
+
+void audio_song_start(audio_song_t *song, float (*notes)[][2], uint16_t count, bool repeat, uint8_t tempo) {
+    song->notes    = notes;
+    song->count    = count;
+    song->repeat   = repeat;
+    song->current  = 0;
+    song->position = 0;
+    song->resting  = false;
+#ifdef VIBRATO_ENABLE
+    song->vibrato = NULL;
+#endif
+    set_note(song, (*notes)[0][0], ((*notes)[0][1] / 4) * (((float)tempo) / 100));
+}
+
+audio_song_status_t audio_song_step(audio_song_t *song, uint16_t timer_period, uint8_t tempo) {
+    song->position++;
+    bool end_of_note;
+    if (timer_period > 0 && !song->resting) {
+        end_of_note = (uint32_t)(song->position + 1) * timer_period >= song->length_ticks;
+    } else {
+        end_of_note = song->position >= song->length_periods;
+    }
+    if (!end_of_note) {
+        return AUDIO_SONG_PLAYING;
+    }
+
+    audio_song_status_t status = AUDIO_SONG_PLAYING;
+    uint16_t            next   = song->current + 1;
+    if (next >= song->count) {
+        if (song->repeat) {
+            next = 0;
+        } else {
+            return AUDIO_SONG_OVER;
+        }
+    }
+    if (!song->resting) {
+        // A period of rest after each note, silent between equal notes
+        song->resting = true;
+        if ((*song->notes)[song->current][0] == (*song->notes)[next][0]) {
+            set_note(song, 0, 1);
+        } else {
+            set_note(song, (*song->notes)[song->current][0], 1);
+        }
+    } else {
+        song->resting = false;
+        song->current = next;
+        status        = AUDIO_SONG_NEW_NOTE;
+        set_note(song, (*song->notes)[next][0], ((*song->notes)[next][1] / 4) * (((float)tempo) / 100));
+    }
+
+    song->position = 0;
+    return status;
+}
+
+// -----------------------------------------------------------------------------
+// Timer interrupt
+// -----------------------------------------------------------------------------
+
+// The default voice sets the same timbre for every period, which doesn't
+// need the float math of voice_envelope()
+uint32_t audio_envelope(uint32_t period, uint16_t *timbre) {
+#ifdef AUDIO_VOICES
+    if (voice != default_voice) {
+        float freq = voice_envelope(audio_period_to_freq(period));
+        *timbre    = AUDIO_TIMBRE_FIXED(note_timbre);
+        return audio_freq_to_period(freq);
+    }
+#endif
+    glissando      = false;
+    note_timbre    = TIMBRE_50;
+    *timbre        = AUDIO_TIMBRE_FIXED(TIMBRE_50);
+    polyphony_rate = 0;
+    return period;
+}
+
+audio_song_status_t audio_song_period(audio_song_t *song, uint8_t tempo, audio_timer_t *timer) {
+    timer->period = 0;
+    timer->duty   = 0;
+    if (song->period > 0) {
+        uint32_t period = song->period;
+#ifdef VIBRATO_ENABLE
+        if (song->vibrato) {
+            period = audio_vibrato(song->vibrato, period);
+        }
+#endif
+        if (envelope_index < 65535) {
+            envelope_index++;
+        }
+
+        uint16_t timbre;
+        period        = audio_envelope(period, &timbre);
+        timer->period = audio_period_ticks(period);
+        timer->duty   = audio_duty_ticks(period, timbre);
+    }
+
+    audio_song_status_t status = audio_song_step(song, timer->period, tempo);
+    if (status == AUDIO_SONG_NEW_NOTE) {
+        envelope_index = 0;
+    }
+    return status;
+}
@@ -0,0 +1,134 @@
+/* Copyright 2019 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "luts.h"
+
+/* Fixed point note generation for the timer interrupts of audio.c.
+ *
+ * Pitches are kept as periods of the audio timer, in timer ticks with 8
+ * fractional bits, so the interrupts only need integer math. The float
+ * frequencies of the songs and of play_note() are converted once for each
+ * note, outside of the per period work.
+ */
+
+#define CPU_PRESCALER 8
+
+// Ticks of the audio timer per second
+#define AUDIO_TIMER_FREQUENCY ((float)F_CPU / CPU_PRESCALER)
+
+// The lowest note the timer can play, lower notes are clamped to it
+#define AUDIO_PERIOD_LIMIT ((uint32_t)(AUDIO_TIMER_FREQUENCY * 256 / 30.517578125f))
+#define AUDIO_PERIOD_CLAMP ((uint32_t)(AUDIO_TIMER_FREQUENCY * 256 / 30.52f))
+
+#define AUDIO_PERIOD_MAX 0xFFFFFF
+
+// Duty cycles are a fraction of the period, in Q0.16
+#define AUDIO_TIMBRE_FIXED(timbre) ((uint16_t)((timbre) >= 1 ? 0xFFFF : (timbre)*65536))
+
+static inline uint32_t audio_freq_to_period(float freq) {
+    if (freq <= 0) {
+        return 0;
+    }
+    float period = AUDIO_TIMER_FREQUENCY * 256 / freq;
+    return period >= AUDIO_PERIOD_MAX ? AUDIO_PERIOD_MAX : (uint32_t)period;
+}
+
+static inline float audio_period_to_freq(uint32_t period) { return period ? AUDIO_TIMER_FREQUENCY * 256 / period : 0; }
+
+// The value for the period register of the timer
+static inline uint16_t audio_period_ticks(uint32_t period) { return period >> 8; }
+
+// The value for the duty cycle register of the timer
+static inline uint16_t audio_duty_ticks(uint32_t period, uint16_t timbre) { return ((period >> 8) * timbre + (((period & 0xFF) * timbre) >> 8)) >> 16; }
+
+// Multiplies a period by a Q1.15 factor
+static inline uint32_t audio_scale_period(uint32_t period, uint16_t factor) {
+    uint32_t scaled = (((period >> 8) * factor) >> 7) + (((period & 0xFF) * factor) >> 15);
+    return scaled > AUDIO_PERIOD_MAX ? AUDIO_PERIOD_MAX : scaled;
+}
+
+// Moves the period one step towards the target period, the glissando of
+// audio.c
+uint32_t audio_glide(uint32_t period, uint32_t target);
+
+#ifdef VIBRATO_ENABLE
+typedef struct {
+    // Position in vibrato_lut, with 16 fractional bits
+    uint32_t counter;
+    // Steps through vibrato_lut per period, with 16 fractional bits
+    uint32_t rate;
+    // The period factors for vibrato_lut, in Q1.15
+    uint16_t factors[VIBRATO_LUT_LENGTH];
+} audio_vibrato_t;
+
+// Sets the rate and the strength, the strength isn't used without
+// VIBRATO_STRENGTH_ENABLE
+void audio_vibrato_init(audio_vibrato_t *vibrato, float rate, float strength);
+
+// Returns the period with the vibrato applied, and advances the vibrato
+uint32_t audio_vibrato(audio_vibrato_t *vibrato, uint32_t period);
+#endif
+
+typedef enum {
+    AUDIO_SONG_PLAYING,
+    // The rest after a note is over, the envelope restarts
+    AUDIO_SONG_NEW_NOTE,
+    AUDIO_SONG_OVER,
+} audio_song_status_t;
+
+// The song player of play_notes()
+typedef struct {
+    float (*notes)[][2];
+    uint16_t count;
+    bool     repeat;
+    uint16_t current;
+    uint16_t position;
+    bool     resting;
+    // Period of the current note, 0 when silent
+    uint32_t period;
+    // Length of the current note in timer ticks times 0xFFFF, and in timer
+    // periods when resting or silent
+    uint32_t length_ticks;
+    uint16_t length_periods;
+#ifdef VIBRATO_ENABLE
+    // The vibrato of the notes, NULL without one
+    audio_vibrato_t *vibrato;
+#endif
+} audio_song_t;
+
+void audio_song_start(audio_song_t *song, float (*notes)[][2], uint16_t count, bool repeat, uint8_t tempo);
+
+// Advances the song by one period of the timer, timer_period being what
+// the timer was set to for it
+audio_song_status_t audio_song_step(audio_song_t *song, uint16_t timer_period, uint8_t tempo);
+
+// The registers of the timer for one period
+typedef struct {
+    uint16_t period;
+    uint16_t duty;
+} audio_timer_t;
+
+// Applies the envelope of the voice of voices.c to a period, and sets the
+// timbre for it in Q0.16
+uint32_t audio_envelope(uint32_t period, uint16_t *timbre);
+
+// The song part of the timer interrupts of audio.c: sets the timer for the
+// note with the vibrato and the envelope, and advances the song by it. The
+// envelope_index of audio.c counts the periods of each note.
+audio_song_status_t audio_song_period(audio_song_t *song, uint8_t tempo, audio_timer_t *timer);
@@ -25,3 +25,55 @@ const uint16_t frequency_lut[FREQUENCY_LUT_LENGTH] = {
     0x1A38, 0x19D8, 0x1979, 0x191C, 0x18C0, 0x1865, 0x180B, 0x17B3, 0x175C, 0x1706, 0x16B2, 0x165E, 0x160C, 0x15BB, 0x156C, 0x151D, 0x14CF, 0x1483, 0x1438, 0x13EE, 0x13A4, 0x135C, 0x1315, 0x12CF, 0x128A, 0x1246, 0x1203, 0x11C1, 0x1180, 0x1140, 0x1100, 0x10C2, 0x1084, 0x1048, 0x100C, 0xFD1,  0xF97,  0xF5E,  0xF25,  0xEEE,  0xEB7,  0xE81,  0xE4C,  0xE17,  0xDE4,  0xDB1,  0xD7E,  0xD4D,  0xD1C,  0xCEC,  0xCBC,  0xC8E,  0xC60,  0xC32,  0xC05,  0xBD9,  0xBAE,  0xB83,  0xB59,  0xB2F,  0xB06,  0xADD,  0xAB6,  0xA8E,  0xA67,  0xA41,  0xA1C,  0x9F7,  0x9D2,  0x9AE,  0x98A,  0x967,  0x945,  0x923,  0x901,  0x8E0,  0x8C0,  0x8A0,  0x880,  0x861,  0x842,  0x824,  0x806,  0x7E8,  0x7CB,  0x7AF,  0x792,  0x777,  0x75B,  0x740,  0x726,  0x70B,  0x6F2,  0x6D8,  0x6BF,  0x6A6,  0x68E,  0x676,  0x65E,  0x647,  0x630,  0x619,  0x602,  0x5EC,  0x5D7,  0x5C1,  0x5AC,  0x597,  0x583,  0x56E,  0x55B,  0x547,  0x533,  0x520,  0x50E,  0x4FB,  0x4E9,
     0x4D7,  0x4C5,  0x4B3,  0x4A2,  0x491,  0x480,  0x470,  0x460,  0x450,  0x440,  0x430,  0x421,  0x412,  0x403,  0x3F4,  0x3E5,  0x3D7,  0x3C9,  0x3BB,  0x3AD,  0x3A0,  0x393,  0x385,  0x379,  0x36C,  0x35F,  0x353,  0x347,  0x33B,  0x32F,  0x323,  0x318,  0x30C,  0x301,  0x2F6,  0x2EB,  0x2E0,  0x2D6,  0x2CB,  0x2C1,  0x2B7,  0x2AD,  0x2A3,  0x299,  0x290,  0x287,  0x27D,  0x274,  0x26B,  0x262,  0x259,  0x251,  0x248,  0x240,  0x238,  0x230,  0x228,  0x220,  0x218,  0x210,  0x209,  0x201,  0x1FA,  0x1F2,  0x1EB,  0x1E4,  0x1DD,  0x1D6,  0x1D0,  0x1C9,  0x1C2,  0x1BC,  0x1B6,  0x1AF,  0x1A9,  0x1A3,  0x19D,  0x197,  0x191,  0x18C,  0x186,  0x180,  0x17B,  0x175,  0x170,  0x16B,  0x165,  0x160,  0x15B,  0x156,  0x151,  0x14C,  0x148,  0x143,  0x13E,  0x13A,  0x135,  0x131,  0x12C,  0x128,  0x124,  0x120,  0x11C,  0x118,  0x114,  0x110,  0x10C,  0x108,  0x104,  0x100,  0xFD,   0xF9,   0xF5,   0xF2,   0xEE,
 };
+
+const uint16_t exp2_lut[EXP2_LUT_LENGTH] PROGMEM = {
+    0x8000, 0x8165, 0x82CE, 0x843A, 0x85AB, 0x871F, 0x8898, 0x8A15, 0x8B96, 0x8D1B, 0x8EA4, 0x9032, 0x91C4, 0x935A, 0x94F5, 0x9694,
+    0x9838, 0x99E0, 0x9B8D, 0x9D3F, 0x9EF5, 0xA0B0, 0xA270, 0xA435, 0xA5FF, 0xA7CE, 0xA9A1, 0xAB7A, 0xAD58, 0xAF3B, 0xB124, 0xB312,
+    0xB505, 0xB6FE, 0xB8FC, 0xBAFF, 0xBD09, 0xBF18, 0xC12C, 0xC347, 0xC567, 0xC78D, 0xC9BA, 0xCBEC, 0xCE25, 0xD063, 0xD2A8, 0xD4F3,
+    0xD745, 0xD99D, 0xDBFC, 0xDE61, 0xE0CD, 0xE340, 0xE5B9, 0xE839, 0xEAC1, 0xED4F, 0xEFE5, 0xF281, 0xF525, 0xF7D1, 0xFA84, 0xFD3E,
+};
+
+const uint16_t exp2_neg_lut[EXP2_LUT_LENGTH] PROGMEM = {
+    0x8000, 0x7E9F, 0x7D42, 0x7BE8, 0x7A93, 0x7941, 0x77F2, 0x76A8, 0x7560, 0x741D, 0x72DD, 0x71A0, 0x7066, 0x6F30, 0x6DFE, 0x6CCF,
+    0x6BA2, 0x6A7A, 0x6954, 0x6832, 0x6712, 0x65F6, 0x64DD, 0x63C7, 0x62B4, 0x61A3, 0x6096, 0x5F8C, 0x5E84, 0x5D80, 0x5C7E, 0x5B7F,
+    0x5A82, 0x5989, 0x5892, 0x579E, 0x56AC, 0x55BD, 0x54D1, 0x53E7, 0x52FF, 0x521B, 0x5138, 0x5058, 0x4F7B, 0x4E9F, 0x4DC7, 0x4CF0,
+    0x4C1C, 0x4B4A, 0x4A7A, 0x49AD, 0x48E2, 0x4819, 0x4752, 0x468D, 0x45CB, 0x450A, 0x444C, 0x4390, 0x42D5, 0x421D, 0x4167, 0x40B2,
+};
+
+const int16_t sine_wavetable[AUDIO_WAVETABLE_LENGTH] = {
+    0, 804, 1608, 2410, 3212, 4011, 4808, 5602, 6393, 7179, 7962, 8739, 9512, 10278, 11039, 11793,
+    12539, 13279, 14010, 14732, 15446, 16151, 16846, 17530, 18204, 18868, 19519, 20159, 20787, 21403, 22005, 22594,
+    23170, 23731, 24279, 24811, 25329, 25832, 26319, 26790, 27245, 27683, 28105, 28510, 28898, 29268, 29621, 29956,
+    30273, 30571, 30852, 31113, 31356, 31580, 31785, 31971, 32137, 32285, 32412, 32521, 32609, 32678, 32728, 32757,
+    32767, 32757, 32728, 32678, 32609, 32521, 32412, 32285, 32137, 31971, 31785, 31580, 31356, 31113, 30852, 30571,
+    30273, 29956, 29621, 29268, 28898, 28510, 28105, 27683, 27245, 26790, 26319, 25832, 25329, 24811, 24279, 23731,
+    23170, 22594, 22005, 21403, 20787, 20159, 19519, 18868, 18204, 17530, 16846, 16151, 15446, 14732, 14010, 13279,
+    12539, 11793, 11039, 10278, 9512, 8739, 7962, 7179, 6393, 5602, 4808, 4011, 3212, 2410, 1608, 804,
+    0, -804, -1608, -2410, -3212, -4011, -4808, -5602, -6393, -7179, -7962, -8739, -9512, -10278, -11039, -11793,
+    -12539, -13279, -14010, -14732, -15446, -16151, -16846, -17530, -18204, -18868, -19519, -20159, -20787, -21403, -22005, -22594,
+    -23170, -23731, -24279, -24811, -25329, -25832, -26319, -26790, -27245, -27683, -28105, -28510, -28898, -29268, -29621, -29956,
+    -30273, -30571, -30852, -31113, -31356, -31580, -31785, -31971, -32137, -32285, -32412, -32521, -32609, -32678, -32728, -32757,
+    -32767, -32757, -32728, -32678, -32609, -32521, -32412, -32285, -32137, -31971, -31785, -31580, -31356, -31113, -30852, -30571,
+    -30273, -29956, -29621, -29268, -28898, -28510, -28105, -27683, -27245, -26790, -26319, -25832, -25329, -24811, -24279, -23731,
+    -23170, -22594, -22005, -21403, -20787, -20159, -19519, -18868, -18204, -17530, -16846, -16151, -15446, -14732, -14010, -13279,
+    -12539, -11793, -11039, -10278, -9512, -8739, -7962, -7179, -6393, -5602, -4808, -4011, -3212, -2410, -1608, -804,
+};
+
+const int16_t triangle_wavetable[AUDIO_WAVETABLE_LENGTH] = {
+    0, 512, 1024, 1536, 2048, 2560, 3072, 3584, 4096, 4608, 5120, 5632, 6144, 6656, 7168, 7680,
+    8192, 8704, 9216, 9728, 10240, 10752, 11264, 11776, 12288, 12800, 13312, 13824, 14336, 14848, 15360, 15872,
+    16384, 16895, 17407, 17919, 18431, 18943, 19455, 19967, 20479, 20991, 21503, 22015, 22527, 23039, 23551, 24063,
+    24575, 25087, 25599, 26111, 26623, 27135, 27647, 28159, 28671, 29183, 29695, 30207, 30719, 31231, 31743, 32255,
+    32767, 32255, 31743, 31231, 30719, 30207, 29695, 29183, 28671, 28159, 27647, 27135, 26623, 26111, 25599, 25087,
+    24575, 24063, 23551, 23039, 22527, 22015, 21503, 20991, 20479, 19967, 19455, 18943, 18431, 17919, 17407, 16895,
+    16384, 15872, 15360, 14848, 14336, 13824, 13312, 12800, 12288, 11776, 11264, 10752, 10240, 9728, 9216, 8704,
+    8192, 7680, 7168, 6656, 6144, 5632, 5120, 4608, 4096, 3584, 3072, 2560, 2048, 1536, 1024, 512,
+    0, -512, -1024, -1536, -2048, -2560, -3072, -3584, -4096, -4608, -5120, -5632, -6144, -6656, -7168, -7680,
+    -8192, -8704, -9216, -9728, -10240, -10752, -11264, -11776, -12288, -12800, -13312, -13824, -14336, -14848, -15360, -15872,
+    -16384, -16895, -17407, -17919, -18431, -18943, -19455, -19967, -20479, -20991, -21503, -22015, -22527, -23039, -23551, -24063,
+    -24575, -25087, -25599, -26111, -26623, -27135, -27647, -28159, -28671, -29183, -29695, -30207, -30719, -31231, -31743, -32255,
+    -32767, -32255, -31743, -31231, -30719, -30207, -29695, -29183, -28671, -28159, -27647, -27135, -26623, -26111, -25599, -25087,
+    -24575, -24063, -23551, -23039, -22527, -22015, -21503, -20991, -20479, -19967, -19455, -18943, -18431, -17919, -17407, -16895,
+    -16384, -15872, -15360, -14848, -14336, -13824, -13312, -12800, -12288, -11776, -11264, -10752, -10240, -9728, -9216, -8704,
+    -8192, -7680, -7168, -6656, -6144, -5632, -5120, -4608, -4096, -3584, -3072, -2560, -2048, -1536, -1024, -512,
+};
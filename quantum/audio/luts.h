@@ -18,10 +18,13 @@
 #    include <avr/io.h>
 #    include <avr/interrupt.h>
 #    include <avr/pgmspace.h>
-#else
+#elif defined(PROTOCOL_CHIBIOS)
 #    include "ch.h"
 #    include "hal.h"
+#else
+#    include <stdint.h>
 #endif
+#include "progmem.h"
 
 #ifndef LUTS_H
 #    define LUTS_H
@@ -30,7 +33,19 @@
 
 #    define FREQUENCY_LUT_LENGTH 349
 
+// 2^(i/64) and 2^(-i/64) in Q1.15, for the glissando
+#    define EXP2_LUT_LENGTH 64
+#    define EXP2_LUT_ONE 0x8000
+
 extern const float    vibrato_lut[VIBRATO_LUT_LENGTH];
 extern const uint16_t frequency_lut[FREQUENCY_LUT_LENGTH];
+extern const uint16_t exp2_lut[EXP2_LUT_LENGTH] PROGMEM;
+extern const uint16_t exp2_neg_lut[EXP2_LUT_LENGTH] PROGMEM;
+
+// One period of a wave, from -32767 to 32767, for the DAC mixer
+#    define AUDIO_WAVETABLE_LENGTH 256
+
+extern const int16_t sine_wavetable[AUDIO_WAVETABLE_LENGTH];
+extern const int16_t triangle_wavetable[AUDIO_WAVETABLE_LENGTH];
 
 #endif /* LUTS_H */
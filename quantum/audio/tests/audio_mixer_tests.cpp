@@ -0,0 +1,157 @@
+#include "gtest/gtest.h"
+#include <math.h>
+#include <vector>
+extern "C" {
+#include "audio/audio_mixer.h"
+}
+
+#define SAMPLE_RATE 44100
+#define SAMPLE_MAX 65535
+#define MIDDLE (SAMPLE_MAX / 2)
+// The share of each voice is rounded down
+#define LOUDNESS_LOSS (SAMPLE_MAX / 256)
+
+class AudioMixer : public ::testing::Test {
+   protected:
+    audio_mixer_t mixer;
+
+    std::vector<uint16_t> render(uint16_t count) {
+        std::vector<uint16_t> samples(count);
+        audio_mixer_render(&mixer, samples.data(), count);
+        return samples;
+    }
+};
+
+// Counts the upward crossings of the middle
+static int crossings(const std::vector<uint16_t>& samples) {
+    int count = 0;
+    for (size_t i = 1; i < samples.size(); i++) {
+        if (samples[i - 1] < MIDDLE && samples[i] >= MIDDLE) {
+            count++;
+        }
+    }
+    return count;
+}
+
+TEST_F(AudioMixer, SilenceIsTheMiddle) {
+    audio_mixer_init(&mixer, SAMPLE_RATE, SAMPLE_MAX, NULL);
+    for (uint16_t sample : render(100)) {
+        EXPECT_EQ(sample, MIDDLE);
+    }
+    audio_mixer_set_voice(&mixer, 0, 440, 0.5f);
+    audio_mixer_stop_voice(&mixer, 0);
+    for (uint16_t sample : render(100)) {
+        EXPECT_EQ(sample, MIDDLE);
+    }
+}
+
+TEST_F(AudioMixer, SquareWave) {
+    audio_mixer_init(&mixer, SAMPLE_RATE, SAMPLE_MAX, NULL);
+    // 100 samples for each period
+    audio_mixer_set_voice(&mixer, 0, SAMPLE_RATE / 100.0f, 0.5f);
+    std::vector<uint16_t> samples = render(1000);
+    for (size_t i = 0; i < samples.size(); i++) {
+        // The phase step is rounded, the edges can land either way
+        if (i % 50 == 0) {
+            continue;
+        }
+        if (i % 100 < 50) {
+            EXPECT_GT(samples[i], SAMPLE_MAX - LOUDNESS_LOSS) << "sample " << i;
+        } else {
+            EXPECT_LT(samples[i], LOUDNESS_LOSS) << "sample " << i;
+        }
+    }
+}
+
+TEST_F(AudioMixer, SquareWaveDuty) {
+    audio_mixer_init(&mixer, SAMPLE_RATE, SAMPLE_MAX, NULL);
+    audio_mixer_set_voice(&mixer, 0, SAMPLE_RATE / 100.0f, 0.25f);
+    std::vector<uint16_t> samples = render(1000);
+    int                   high    = 0;
+    for (uint16_t sample : samples) {
+        high += sample > MIDDLE;
+    }
+    EXPECT_NEAR(high, 250, 10);
+}
+
+TEST_F(AudioMixer, ChordsDontClip) {
+    audio_mixer_init(&mixer, SAMPLE_RATE, SAMPLE_MAX, NULL);
+    audio_mixer_set_voice(&mixer, 0, 261.63f, 0.5f);
+    audio_mixer_set_voice(&mixer, 1, 329.63f, 0.5f);
+    audio_mixer_set_voice(&mixer, 2, 392.00f, 0.5f);
+    std::vector<uint16_t> samples = render(SAMPLE_RATE / 10);
+    uint16_t              low     = SAMPLE_MAX;
+    uint16_t              high    = 0;
+    for (uint16_t sample : samples) {
+        low  = sample < low ? sample : low;
+        high = sample > high ? sample : high;
+    }
+    // All three voices are high at the start, and low together later on
+    EXPECT_GT(high, SAMPLE_MAX - LOUDNESS_LOSS);
+    EXPECT_LT(low, LOUDNESS_LOSS);
+}
+
+TEST_F(AudioMixer, AllVoices) {
+    audio_mixer_init(&mixer, SAMPLE_RATE, SAMPLE_MAX, NULL);
+    for (uint8_t i = 0; i < AUDIO_MIXER_VOICES; i++) {
+        audio_mixer_set_voice(&mixer, i, 100.0f * (i + 1), 0.5f);
+    }
+    EXPECT_GT(render(1)[0], SAMPLE_MAX - LOUDNESS_LOSS);
+    // Out of range voices and frequencies are ignored or stop the voice
+    audio_mixer_set_voice(&mixer, AUDIO_MIXER_VOICES, 100.0f, 0.5f);
+    audio_mixer_set_voice(&mixer, 0, SAMPLE_RATE, 0.5f);
+    EXPECT_FALSE(mixer.voices[0].playing);
+}
+
+TEST_F(AudioMixer, SineWave) {
+    audio_mixer_init(&mixer, SAMPLE_RATE, SAMPLE_MAX, sine_wavetable);
+    audio_mixer_set_voice(&mixer, 0, 440, 0.5f);
+    std::vector<uint16_t> samples = render(SAMPLE_RATE);
+    EXPECT_NEAR(crossings(samples), 440, 1);
+    for (size_t i = 0; i < 1000; i++) {
+        double expected = MIDDLE + MIDDLE * sin(2 * M_PI * 440 * i / SAMPLE_RATE);
+        EXPECT_NEAR(samples[i], expected, 20) << "sample " << i;
+    }
+}
+
+TEST_F(AudioMixer, TriangleWave) {
+    audio_mixer_init(&mixer, SAMPLE_RATE, SAMPLE_MAX, triangle_wavetable);
+    audio_mixer_set_voice(&mixer, 0, 1000, 0.5f);
+    std::vector<uint16_t> samples = render(SAMPLE_RATE);
+    EXPECT_NEAR(crossings(samples), 1000, 1);
+    uint16_t high = 0;
+    for (uint16_t sample : samples) {
+        high = sample > high ? sample : high;
+    }
+    EXPECT_GT(high, SAMPLE_MAX - 1000);
+}
+
+TEST_F(AudioMixer, BlocksMatchOneRender) {
+    audio_mixer_init(&mixer, SAMPLE_RATE, SAMPLE_MAX, sine_wavetable);
+    audio_mixer_set_voice(&mixer, 0, 440, 0.5f);
+    audio_mixer_set_voice(&mixer, 1, 554.37f, 0.5f);
+    std::vector<uint16_t> whole = render(1024);
+
+    audio_mixer_init(&mixer, SAMPLE_RATE, SAMPLE_MAX, sine_wavetable);
+    audio_mixer_set_voice(&mixer, 0, 440, 0.5f);
+    audio_mixer_set_voice(&mixer, 1, 554.37f, 0.5f);
+    for (size_t i = 0; i < whole.size(); i += 128) {
+        std::vector<uint16_t> block = render(128);
+        for (size_t j = 0; j < block.size(); j++) {
+            EXPECT_EQ(block[j], whole[i + j]) << "sample " << i + j;
+        }
+    }
+}
+
+TEST_F(AudioMixer, FrequencyChangesKeepThePhase) {
+    audio_mixer_init(&mixer, SAMPLE_RATE, SAMPLE_MAX, sine_wavetable);
+    audio_mixer_set_voice(&mixer, 0, 440, 0.5f);
+    render(37);
+    uint32_t phase = mixer.voices[0].phase;
+    audio_mixer_set_voice(&mixer, 0, 450, 0.5f);
+    EXPECT_EQ(mixer.voices[0].phase, phase);
+    // The wave carries on without a jump
+    std::vector<uint16_t> samples = render(2);
+    double                step    = 2 * M_PI * 450.0 / SAMPLE_RATE * MIDDLE;
+    EXPECT_LT(abs(samples[1] - samples[0]), step + 20);
+}
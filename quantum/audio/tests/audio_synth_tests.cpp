@@ -0,0 +1,278 @@
+#include "gtest/gtest.h"
+#include <math.h>
+#include <vector>
+extern "C" {
+#include "audio/audio_synth.h"
+#include "audio/song_list.h"
+
+// The globals of audio.c which audio_synth.c and voices.c use
+uint16_t envelope_index = 0;
+float    note_timbre    = TIMBRE_DEFAULT;
+float    polyphony_rate = 0;
+bool     glissando      = true;
+}
+
+// What the timer was set to for one period
+struct timer_period_t {
+    uint16_t period;
+    uint16_t duty;
+};
+
+typedef std::vector<timer_period_t> timer_log_t;
+
+// The float math which audio.c used in its interrupts, with the default
+// voice, as the reference for the fixed point version
+static timer_period_t reference_timer(float freq) {
+    timer_period_t timer = {0, 0};
+    if (freq > 0) {
+        timer.period = (uint16_t)(((float)F_CPU) / (freq * CPU_PRESCALER));
+        timer.duty   = (uint16_t)((((float)F_CPU) / (freq * CPU_PRESCALER)) * TIMBRE_50);
+    }
+    return timer;
+}
+
+static float reference_glide(float frequency, float target) {
+    if (frequency != 0 && frequency < target && frequency < target * pow(2, -440 / target / 12 / 2)) {
+        return frequency * pow(2, 440 / frequency / 12 / 2);
+    } else if (frequency != 0 && frequency > target && frequency > target * pow(2, 440 / target / 12 / 2)) {
+        return frequency * pow(2, -440 / frequency / 12 / 2);
+    }
+    return target;
+}
+
+static timer_log_t reference_song(float (*notes)[][2], uint16_t count, uint8_t tempo) {
+    timer_log_t log;
+    uint16_t    current  = 0;
+    uint16_t    position = 0;
+    bool        resting  = false;
+    float       freq     = (*notes)[0][0];
+    float       length   = ((*notes)[0][1] / 4) * (((float)tempo) / 100);
+    while (true) {
+        timer_period_t timer = reference_timer(freq);
+        log.push_back(timer);
+
+        position++;
+        bool end_of_note = false;
+        if (timer.period > 0) {
+            if (!resting)
+                end_of_note = (position >= (length / timer.period * 0xFFFF - 1));
+            else
+                end_of_note = (position >= (length));
+        } else {
+            end_of_note = (position >= (length));
+        }
+
+        if (end_of_note) {
+            current++;
+            if (current >= count) {
+                return log;
+            }
+            if (!resting) {
+                resting = true;
+                current--;
+                if ((*notes)[current][0] == (*notes)[current + 1][0]) {
+                    freq   = 0;
+                    length = 1;
+                } else {
+                    freq   = (*notes)[current][0];
+                    length = 1;
+                }
+            } else {
+                resting = false;
+                freq    = (*notes)[current][0];
+                length  = ((*notes)[current][1] / 4) * (((float)tempo) / 100);
+            }
+            position = 0;
+        }
+    }
+}
+
+static timer_log_t fixed_song(float (*notes)[][2], uint16_t count, uint8_t tempo) {
+    timer_log_t  log;
+    audio_song_t song;
+    audio_song_start(&song, notes, count, false, tempo);
+    while (true) {
+        timer_period_t timer = {audio_period_ticks(song.period), audio_duty_ticks(song.period, AUDIO_TIMBRE_FIXED(TIMBRE_50))};
+        log.push_back(timer);
+        if (audio_song_step(&song, timer.period, tempo) == AUDIO_SONG_OVER) {
+            return log;
+        }
+    }
+}
+
+// Renders the square wave of the timer output at 8 bits and 44.1kHz
+static std::vector<uint8_t> render_pcm(const timer_log_t& log) {
+    const double         tick_seconds = CPU_PRESCALER / (double)F_CPU;
+    std::vector<uint8_t> pcm;
+    double               start = 0;
+    double               next_sample = 0;
+    for (const timer_period_t& timer : log) {
+        // The timer counts at least one tick with a period of 0
+        double end  = start + (timer.period ? timer.period : 1) * tick_seconds;
+        double high = start + timer.duty * tick_seconds;
+        for (; next_sample < end; next_sample += 1.0 / 44100) {
+            pcm.push_back(next_sample < high ? 0xFF : 0x00);
+        }
+        start = end;
+    }
+    return pcm;
+}
+
+static void expect_same_song(float (*notes)[][2], uint16_t count, uint8_t tempo) {
+    timer_log_t reference = reference_song(notes, count, tempo);
+    timer_log_t fixed     = fixed_song(notes, count, tempo);
+
+    // The same periods, up to the rounding of the float math
+    ASSERT_EQ(reference.size(), fixed.size());
+    for (size_t i = 0; i < reference.size(); i++) {
+        EXPECT_NEAR(reference[i].period, fixed[i].period, 1) << "period " << i;
+        EXPECT_NEAR(reference[i].duty, fixed[i].duty, 1) << "period " << i;
+    }
+
+    std::vector<uint8_t> reference_pcm = render_pcm(reference);
+    std::vector<uint8_t> fixed_pcm     = render_pcm(fixed);
+    ASSERT_NEAR(reference_pcm.size(), fixed_pcm.size(), 1);
+    size_t size       = std::min(reference_pcm.size(), fixed_pcm.size());
+    size_t mismatches = 0;
+    for (size_t i = 0; i < size; i++) {
+        mismatches += reference_pcm[i] != fixed_pcm[i];
+    }
+    EXPECT_LT(mismatches, size / 1000);
+}
+
+#define EXPECT_SAME_SONG(song, tempo) expect_same_song(&song, sizeof(song) / (2 * sizeof(float)), tempo)
+
+TEST(AudioSynth, ConvertsFrequencies) {
+    for (float freq = 40; freq < 8000; freq *= 1.01f) {
+        timer_period_t reference = reference_timer(freq);
+        uint32_t       period    = audio_freq_to_period(freq);
+        EXPECT_NEAR(reference.period, audio_period_ticks(period), 1);
+        EXPECT_NEAR(reference.duty, audio_duty_ticks(period, AUDIO_TIMBRE_FIXED(TIMBRE_50)), 1);
+    }
+    EXPECT_EQ(audio_freq_to_period(0), 0);
+    EXPECT_EQ(audio_period_ticks(audio_freq_to_period(440)), F_CPU / CPU_PRESCALER / 440);
+}
+
+TEST(AudioSynth, PlaysTheStartupSong) {
+    float song[][2] = SONG(STARTUP_SOUND);
+    EXPECT_SAME_SONG(song, TEMPO_DEFAULT);
+}
+
+TEST(AudioSynth, PlaysSongsWithRests) {
+    float song[][2] = SONG(DVORAK_SOUND);
+    EXPECT_SAME_SONG(song, TEMPO_DEFAULT);
+}
+
+TEST(AudioSynth, PlaysRepeatedNotes) {
+    float song[][2] = SONG(ODE_TO_JOY);
+    EXPECT_SAME_SONG(song, TEMPO_DEFAULT);
+}
+
+TEST(AudioSynth, PlaysLowNotes) {
+    float song[][2] = SONG(CLUEBOARD_SOUND);
+    EXPECT_SAME_SONG(song, TEMPO_DEFAULT);
+}
+
+TEST(AudioSynth, PlaysAtOtherTempos) {
+    float song[][2] = SONG(MUSIC_ON_SOUND);
+    EXPECT_SAME_SONG(song, 10);
+    EXPECT_SAME_SONG(song, 60);
+    EXPECT_SAME_SONG(song, 255);
+}
+
+TEST(AudioSynth, RepeatsSongs) {
+    float        song[][2] = SONG(AUDIO_ON_SOUND);
+    audio_song_t state;
+    audio_song_start(&state, &song, 2, true, TEMPO_DEFAULT);
+    uint32_t periods = 0;
+    uint8_t  notes   = 0;
+    while (notes < 5 && periods < 100000) {
+        periods++;
+        if (audio_song_step(&state, audio_period_ticks(state.period), TEMPO_DEFAULT) == AUDIO_SONG_NEW_NOTE) {
+            notes++;
+        }
+        ASSERT_LT(state.current, 2);
+    }
+    EXPECT_EQ(notes, 5);
+}
+
+TEST(AudioSynth, GlidesLikeTheFloatMath) {
+    const float pairs[][2] = {{NOTE_A4, NOTE_A5}, {NOTE_A5, NOTE_A4}, {NOTE_C4, NOTE_E6}, {NOTE_E7, NOTE_C3}, {NOTE_A4, NOTE_AS4}, {NOTE_C2, NOTE_C3}};
+    for (auto& pair : pairs) {
+        float    frequency = pair[0];
+        uint32_t period    = audio_freq_to_period(pair[0]);
+        uint32_t target    = audio_freq_to_period(pair[1]);
+        int      reference_steps = 0;
+        int      steps           = 0;
+        while (frequency != pair[1]) {
+            ASSERT_LT(reference_steps++, 10000);
+            // Each step from the same pitch lands on the same period
+            uint32_t fixed = audio_glide(audio_freq_to_period(frequency), target);
+            frequency      = reference_glide(frequency, pair[1]);
+            EXPECT_NEAR(reference_timer(frequency).period, audio_period_ticks(fixed), 1) << pair[0] << " to " << pair[1] << " step " << reference_steps;
+        }
+        while (period != target) {
+            ASSERT_LT(steps++, 10000);
+            period = audio_glide(period, target);
+        }
+        // And the whole glissando takes as long, give or take a period
+        EXPECT_NEAR(reference_steps, steps, 1) << pair[0] << " to " << pair[1];
+    }
+}
+
+#ifdef VIBRATO_ENABLE
+TEST(AudioSynth, VibratesLikeTheFloatMath) {
+    const float rates[] = {0.125, 0.5, 1.5, 3};
+    for (float rate : rates) {
+        for (float freq : {NOTE_A3, NOTE_A4, NOTE_E6}) {
+            audio_vibrato_t vibrato = {};
+            audio_vibrato_init(&vibrato, rate, 0.5);
+            uint32_t period  = audio_freq_to_period(freq);
+            float    counter = 0;
+            for (int i = 0; i < 2000; i++) {
+                int index = (int)counter;
+                counter   = fmod(counter + rate * (1.0 + 440.0 / freq), VIBRATO_LUT_LENGTH);
+                float vibrated = audio_period_to_freq(audio_vibrato(&vibrato, period)) / freq;
+                // The counters may fall on either side of a step of the
+                // vibrato, but they don't drift apart
+                bool in_step = false;
+                for (int j = index - 1; j <= index + 1; j++) {
+                    float step = vibrato_lut[(j + VIBRATO_LUT_LENGTH) % VIBRATO_LUT_LENGTH];
+#    ifdef VIBRATO_STRENGTH_ENABLE
+                    step = pow(step, 0.5);
+#    endif
+                    in_step |= fabs(vibrated / step - 1) < 0.0002;
+                }
+                ASSERT_TRUE(in_step) << "rate " << rate << " at " << freq << " period " << i;
+            }
+        }
+    }
+}
+#endif
+
+TEST(AudioSynth, PlaysPeriodsOfTheInterrupt) {
+    float       song[][2] = SONG(DVORAK_SOUND);
+    uint16_t    count     = sizeof(song) / (2 * sizeof(float));
+    timer_log_t expected  = fixed_song(&song, count, TEMPO_DEFAULT);
+
+    audio_song_t state;
+    audio_song_start(&state, &song, count, false, TEMPO_DEFAULT);
+    envelope_index = 0;
+    size_t              i = 0;
+    audio_timer_t       timer;
+    audio_song_status_t status;
+    do {
+        ASSERT_LT(i, expected.size());
+        uint16_t index = envelope_index;
+        status         = audio_song_period(&state, TEMPO_DEFAULT, &timer);
+        EXPECT_EQ(timer.period, expected[i].period) << "period " << i;
+        EXPECT_EQ(timer.duty, expected[i].duty) << "period " << i;
+        if (status == AUDIO_SONG_NEW_NOTE) {
+            EXPECT_EQ(envelope_index, 0);
+        } else if (timer.period > 0) {
+            EXPECT_EQ(envelope_index, index + 1);
+        }
+        i++;
+    } while (status != AUDIO_SONG_OVER);
+    EXPECT_EQ(i, expected.size());
+}
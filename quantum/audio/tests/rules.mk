@@ -0,0 +1,14 @@
+audio_synth_SRC := \
+	$(QUANTUM_PATH)/audio/tests/audio_synth_tests.cpp \
+	$(QUANTUM_PATH)/audio/audio_synth.c \
+	$(QUANTUM_PATH)/audio/luts.c
+
+audio_synth_DEFS := -DF_CPU=16000000 -DVIBRATO_ENABLE
+
+audio_synth_8mhz_SRC := $(audio_synth_SRC)
+audio_synth_8mhz_DEFS := -DF_CPU=8000000 -DVIBRATO_ENABLE -DVIBRATO_STRENGTH_ENABLE
+
+audio_mixer_SRC := \
+	$(QUANTUM_PATH)/audio/tests/audio_mixer_tests.cpp \
+	$(QUANTUM_PATH)/audio/audio_mixer.c \
+	$(QUANTUM_PATH)/audio/luts.c
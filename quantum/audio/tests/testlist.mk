@@ -0,0 +1,4 @@
+TEST_LIST +=\
+	audio_synth\
+	audio_synth_8mhz\
+	audio_mixer
@@ -18,7 +18,16 @@
 #include "led_tables.h"
 #include "progmem.h"
 
-RGB hsv_to_rgb(HSV hsv) {
+// The region is h * 6 / 255, compared instead of divided as AVR and
+// Cortex-M0 have no divide instruction
+static inline uint8_t hsv_region(uint8_t h) {
+    if (h < 128) {
+        return h < 43 ? 0 : h < 85 ? 1 : 2;
+    }
+    return h < 170 ? 3 : h < 213 ? 4 : h < 255 ? 5 : 6;
+}
+
+static inline RGB hsv_to_rgb_impl(HSV hsv) {
     RGB      rgb;
     uint8_t  region, remainder, p, q, t;
     uint16_t h, s, v;
@@ -38,7 +47,7 @@ RGB hsv_to_rgb(HSV hsv) {
     s = hsv.s;
     v = hsv.v;
 
-    region    = h * 6 / 255;
+    region    = hsv_region(h);
     remainder = (h * 2 - region * 85) * 3;
 
     p = (v * (255 - s)) >> 8;
@@ -87,3 +96,18 @@ RGB hsv_to_rgb(HSV hsv) {
 
     return rgb;
 }
+
+RGB hsv_to_rgb(HSV hsv) { return hsv_to_rgb_impl(hsv); }
+
+void hsv_to_rgb_batch(const HSV *hsv, RGB *rgb, uint8_t count) {
+    // Two at a time, so that the loads of the next colour overlap with
+    // the multiplies of the previous one
+    uint8_t i = 0;
+    for (; i + 1 < count; i += 2) {
+        rgb[i]     = hsv_to_rgb_impl(hsv[i]);
+        rgb[i + 1] = hsv_to_rgb_impl(hsv[i + 1]);
+    }
+    if (i < count) {
+        rgb[i] = hsv_to_rgb_impl(hsv[i]);
+    }
+}
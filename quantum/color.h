@@ -64,5 +64,7 @@ typedef struct PACKED {
 #endif
 
 RGB hsv_to_rgb(HSV hsv);
+// Converts count colours, cheaper than calling hsv_to_rgb() for each one
+void hsv_to_rgb_batch(const HSV *hsv, RGB *rgb, uint8_t count);
 
 #endif  // COLOR_H
@@ -34,6 +34,7 @@ const point_t k_rgb_matrix_center = RGB_MATRIX_CENTER;
 // Generic effect runners
 #include "rgb_matrix_runners/effect_runner_dx_dy_dist.h"
 #include "rgb_matrix_runners/effect_runner_dx_dy.h"
+#include "rgb_matrix_runners/effect_runner_polar.h"
 #include "rgb_matrix_runners/effect_runner_i.h"
 #include "rgb_matrix_runners/effect_runner_sin_cos_i.h"
 #include "rgb_matrix_runners/effect_runner_reactive.h"
@@ -57,6 +58,11 @@ const point_t k_rgb_matrix_center = RGB_MATRIX_CENTER;
 // -----End rgb effect includes macros-------
 // ------------------------------------------
 
+#ifndef RGB_MATRIX_HIT_EXPIRY
+// The splash effects reach 255 past the farthest LED
+#    define RGB_MATRIX_HIT_EXPIRY 512
+#endif
+
 #ifndef RGB_DISABLE_AFTER_TIMEOUT
 #    define RGB_DISABLE_AFTER_TIMEOUT 0
 #endif
@@ -102,6 +108,11 @@ rgb_config_t rgb_matrix_config;
 rgb_counters_t  g_rgb_counters;
 static uint32_t rgb_counters_buffer;
 
+// Distance and angle of each LED from k_rgb_matrix_center, they only depend
+// on g_led_config so they are computed once instead of on every frame
+uint8_t g_rgb_led_dist[DRIVER_LED_TOTAL];
+uint8_t g_rgb_led_angle[DRIVER_LED_TOTAL];
+
 #ifdef RGB_MATRIX_FRAMEBUFFER_EFFECTS
 uint8_t rgb_frame_buffer[MATRIX_ROWS][MATRIX_COLS] = {{0}};
 #endif
@@ -152,6 +163,19 @@ void rgb_matrix_set_color(int index, uint8_t red, uint8_t green, uint8_t blue) {
 
 void rgb_matrix_set_color_all(uint8_t red, uint8_t green, uint8_t blue) { rgb_matrix_driver.set_color_all(red, green, blue); }
 
+void rgb_matrix_batch_flush(rgb_matrix_batch_t *batch) {
+    RGB rgb[RGB_MATRIX_BATCH_SIZE];
+    hsv_to_rgb_batch(batch->hsv, rgb, batch->count);
+    if (rgb_matrix_driver.set_color_batch) {
+        rgb_matrix_driver.set_color_batch(batch->start, rgb, batch->count);
+    } else {
+        for (uint8_t i = 0; i < batch->count; i++) {
+            rgb_matrix_driver.set_color(batch->start + i, rgb[i].r, rgb[i].g, rgb[i].b);
+        }
+    }
+    batch->count = 0;
+}
+
 bool process_rgb_matrix(uint16_t keycode, keyrecord_t *record) {
 #ifdef RGB_MATRIX_KEYREACTIVE_ENABLED
     uint8_t led[LED_HITS_TO_REMEMBER];
@@ -237,9 +261,23 @@ static uint8_t         rgb_last_effect   = UINT8_MAX;
 static effect_params_t rgb_effect_params = {0, 0xFF};
 static rgb_task_states rgb_task_state    = SYNCING;
 
+#ifdef RGB_MATRIX_RENDER_BUDGET_US
+#    if RGB_MATRIX_LED_PROCESS_LIMIT > 0 && RGB_MATRIX_LED_PROCESS_LIMIT < DRIVER_LED_TOTAL
+uint8_t g_rgb_led_process_limit = RGB_MATRIX_LED_PROCESS_LIMIT;
+#    else
+uint8_t g_rgb_led_process_limit = DRIVER_LED_TOTAL;
+#    endif
+// The timer only counts milliseconds, so a task run usually takes 0 ms and
+// sometimes 1 ms. Added up over a frame this averages out to the real time
+// it took to render the frame.
+static uint16_t rgb_frame_render_ms = 0;
+// Moving average of the time it takes to render a whole frame
+static uint32_t rgb_render_time_us = 0;
+#endif  // RGB_MATRIX_RENDER_BUDGET_US
+
 static void rgb_task_timers(void) {
     // Update double buffer timers
-    uint16_t deltaTime  = timer_elapsed32(rgb_counters_buffer);
+    uint32_t deltaTime  = timer_elapsed32(rgb_counters_buffer);
     rgb_counters_buffer = timer_read32();
     if (g_rgb_counters.any_key_hit < UINT32_MAX) {
         if (UINT32_MAX - deltaTime < g_rgb_counters.any_key_hit) {
@@ -251,14 +289,29 @@ static void rgb_task_timers(void) {
 
     // Update double buffer last hit timers
 #ifdef RGB_MATRIX_KEYREACTIVE_ENABLED
-    uint8_t count = last_hit_buffer.count;
-    for (uint8_t i = 0; i < count; ++i) {
-        if (UINT16_MAX - deltaTime < last_hit_buffer.tick[i]) {
-            last_hit_buffer.count--;
+    // The effects scale the ticks by the speed, and no effect shows a hit
+    // after the scaled tick passed RGB_MATRIX_HIT_EXPIRY
+    uint32_t expiry = rgb_matrix_config.speed ? ((uint32_t)RGB_MATRIX_HIT_EXPIRY << 8) / rgb_matrix_config.speed : UINT16_MAX;
+    if (expiry > UINT16_MAX) expiry = UINT16_MAX;
+
+    // The hits are stored oldest first, so the expired ones are at the start
+    uint8_t expired = 0;
+    for (uint8_t i = 0; i < last_hit_buffer.count; ++i) {
+        if (deltaTime >= expiry || last_hit_buffer.tick[i] >= expiry - deltaTime) {
+            expired++;
             continue;
         }
+        // Stays below the expiry, which fits the 16 bit tick
         last_hit_buffer.tick[i] += deltaTime;
     }
+    if (expired) {
+        uint8_t count = last_hit_buffer.count - expired;
+        memmove(&last_hit_buffer.x[0], &last_hit_buffer.x[expired], count);
+        memmove(&last_hit_buffer.y[0], &last_hit_buffer.y[expired], count);
+        memmove(&last_hit_buffer.tick[0], &last_hit_buffer.tick[expired], count * sizeof(last_hit_buffer.tick[0]));
+        memmove(&last_hit_buffer.index[0], &last_hit_buffer.index[expired], count);
+        last_hit_buffer.count = count;
+    }
 #endif  // RGB_MATRIX_KEYREACTIVE_ENABLED
 }
 
@@ -270,6 +323,9 @@ static void rgb_task_sync(void) {
 static void rgb_task_start(void) {
     // reset iter
     rgb_effect_params.iter = 0;
+#ifdef RGB_MATRIX_RENDER_BUDGET_US
+    rgb_frame_render_ms = 0;
+#endif  // RGB_MATRIX_RENDER_BUDGET_US
 
     // update double buffers
     g_rgb_counters.tick = rgb_counters_buffer;
@@ -337,6 +393,32 @@ static void rgb_task_render(uint8_t effect) {
     }
 }
 
+#ifdef RGB_MATRIX_RENDER_BUDGET_US
+static void rgb_task_measure_render(uint32_t start) {
+    rgb_frame_render_ms += timer_elapsed32(start);
+    if (rgb_task_state == RENDERING) {
+        return;
+    }
+
+    // The frame is rendered, pick the number of LEDs for the next one so
+    // that a task run stays within the budget
+    uint32_t frame_us = (uint32_t)rgb_frame_render_ms * 1000;
+    if (rgb_effect_params.init) {
+        // a new effect, the old average doesn't apply
+        rgb_render_time_us = frame_us;
+    } else {
+        rgb_render_time_us = rgb_render_time_us - rgb_render_time_us / 8 + frame_us / 8;
+    }
+
+    uint32_t limit = DRIVER_LED_TOTAL;
+    if (rgb_render_time_us > RGB_MATRIX_RENDER_BUDGET_US) {
+        limit = (uint32_t)RGB_MATRIX_RENDER_BUDGET_US * DRIVER_LED_TOTAL / rgb_render_time_us;
+        if (limit < 1) limit = 1;
+    }
+    g_rgb_led_process_limit = limit;
+}
+#endif  // RGB_MATRIX_RENDER_BUDGET_US
+
 static void rgb_task_flush(uint8_t effect) {
     // update last trackers after the first full render so we can init over several frames
     rgb_last_effect = effect;
@@ -356,6 +438,9 @@ void rgb_matrix_task(void) {
     // while suspended and just do a software shutdown. This is a cheap hack for now.
     bool    suspend_backlight = ((g_suspend_state && RGB_DISABLE_WHEN_USB_SUSPENDED) || (RGB_DISABLE_AFTER_TIMEOUT > 0 && g_rgb_counters.any_key_hit > RGB_DISABLE_AFTER_TIMEOUT * 60 * 20));
     uint8_t effect            = suspend_backlight || !rgb_matrix_config.enable ? 0 : rgb_matrix_config.mode;
+#ifdef RGB_MATRIX_RENDER_BUDGET_US
+    uint32_t task_start = timer_read32();
+#endif  // RGB_MATRIX_RENDER_BUDGET_US
 
     switch (rgb_task_state) {
         case STARTING:
@@ -363,6 +448,9 @@ void rgb_matrix_task(void) {
             break;
         case RENDERING:
             rgb_task_render(effect);
+#ifdef RGB_MATRIX_RENDER_BUDGET_US
+            rgb_task_measure_render(task_start);
+#endif  // RGB_MATRIX_RENDER_BUDGET_US
             break;
         case FLUSHING:
             rgb_task_flush(effect);
@@ -386,8 +474,18 @@ __attribute__((weak)) void rgb_matrix_indicators_kb(void) {}
 
 __attribute__((weak)) void rgb_matrix_indicators_user(void) {}
 
+static void rgb_matrix_init_geometry(void) {
+    for (uint8_t i = 0; i < DRIVER_LED_TOTAL; i++) {
+        int16_t dx         = g_led_config.point[i].x - k_rgb_matrix_center.x;
+        int16_t dy         = g_led_config.point[i].y - k_rgb_matrix_center.y;
+        g_rgb_led_dist[i]  = sqrt16(dx * dx + dy * dy);
+        g_rgb_led_angle[i] = atan2_8(dy, dx);
+    }
+}
+
 void rgb_matrix_init(void) {
     rgb_matrix_driver.init();
+    rgb_matrix_init_geometry();
 
     // TODO: put the 1 second startup delay here?
 
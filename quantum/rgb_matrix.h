@@ -37,14 +37,26 @@
 #endif
 
 #ifndef RGB_MATRIX_LED_FLUSH_LIMIT
-#    define RGB_MATRIX_LED_FLUSH_LIMIT 16
+#    ifdef RGB_MATRIX_TARGET_FPS
+#        define RGB_MATRIX_LED_FLUSH_LIMIT (1000 / RGB_MATRIX_TARGET_FPS)
+#    else
+#        define RGB_MATRIX_LED_FLUSH_LIMIT 16
+#    endif
 #endif
 
 #ifndef RGB_MATRIX_LED_PROCESS_LIMIT
 #    define RGB_MATRIX_LED_PROCESS_LIMIT (DRIVER_LED_TOTAL + 4) / 5
 #endif
 
-#if defined(RGB_MATRIX_LED_PROCESS_LIMIT) && RGB_MATRIX_LED_PROCESS_LIMIT > 0 && RGB_MATRIX_LED_PROCESS_LIMIT < DRIVER_LED_TOTAL
+#if defined(RGB_MATRIX_RENDER_BUDGET_US)
+// The number of LEDs per task run is adapted to the measured render time,
+// it only changes between frames
+extern uint8_t g_rgb_led_process_limit;
+#    define RGB_MATRIX_USE_LIMITS(min, max)                             \
+        uint8_t min = (uint16_t)g_rgb_led_process_limit * params->iter; \
+        uint8_t max = DRIVER_LED_TOTAL;                                 \
+        if ((uint16_t)min + g_rgb_led_process_limit < DRIVER_LED_TOTAL) max = min + g_rgb_led_process_limit;
+#elif defined(RGB_MATRIX_LED_PROCESS_LIMIT) && RGB_MATRIX_LED_PROCESS_LIMIT > 0 && RGB_MATRIX_LED_PROCESS_LIMIT < DRIVER_LED_TOTAL
 #    define RGB_MATRIX_USE_LIMITS(min, max)                        \
         uint8_t min = RGB_MATRIX_LED_PROCESS_LIMIT * params->iter; \
         uint8_t max = min + RGB_MATRIX_LED_PROCESS_LIMIT;          \
@@ -159,15 +171,42 @@ typedef struct {
     void (*set_color_all)(uint8_t r, uint8_t g, uint8_t b);
     /* Flush any buffered changes to the hardware. */
     void (*flush)(void);
+    /* Set the colours of count LEDs starting at index, optional. */
+    void (*set_color_batch)(int index, const RGB *colors, uint8_t count);
 } rgb_matrix_driver_t;
 
 extern const rgb_matrix_driver_t rgb_matrix_driver;
 
+#ifndef RGB_MATRIX_BATCH_SIZE
+#    define RGB_MATRIX_BATCH_SIZE 16
+#endif
+
+// Colours of consecutive LEDs, converted and handed to the driver together
+typedef struct {
+    uint8_t start;
+    uint8_t count;
+    HSV     hsv[RGB_MATRIX_BATCH_SIZE];
+} rgb_matrix_batch_t;
+
+void rgb_matrix_batch_flush(rgb_matrix_batch_t *batch);
+
+static inline void rgb_matrix_batch_add(rgb_matrix_batch_t *batch, uint8_t index, HSV hsv) {
+    if (batch->count && (batch->count == RGB_MATRIX_BATCH_SIZE || batch->start + batch->count != index)) {
+        rgb_matrix_batch_flush(batch);
+    }
+    if (!batch->count) {
+        batch->start = index;
+    }
+    batch->hsv[batch->count++] = hsv;
+}
+
 extern rgb_config_t rgb_matrix_config;
 
 extern bool           g_suspend_state;
 extern rgb_counters_t g_rgb_counters;
 extern led_config_t   g_led_config;
+extern uint8_t        g_rgb_led_dist[DRIVER_LED_TOTAL];
+extern uint8_t        g_rgb_led_angle[DRIVER_LED_TOTAL];
 #ifdef RGB_MATRIX_KEYREACTIVE_ENABLED
 extern last_hit_t g_last_hit_tracker;
 #endif
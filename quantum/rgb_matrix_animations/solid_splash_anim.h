@@ -18,12 +18,20 @@ HSV SOLID_SPLASH_math(HSV hsv, int16_t dx, int16_t dy, uint8_t dist, uint16_t ti
     return hsv;
 }
 
+// The wavefront moves out from the hit and leaves a 255 wide trail
+static bool SOLID_SPLASH_range(uint16_t tick, uint8_t* min_dist, uint8_t* max_dist) {
+    if (tick > 255 + 254) return false;
+    *min_dist = tick > 254 ? tick - 254 : 0;
+    *max_dist = tick < 255 ? tick : 255;
+    return true;
+}
+
 #            ifndef DISABLE_RGB_MATRIX_SOLID_SPLASH
-bool SOLID_SPLASH(effect_params_t* params) { return effect_runner_reactive_splash(qsub8(g_last_hit_tracker.count, 1), params, &SOLID_SPLASH_math); }
+bool SOLID_SPLASH(effect_params_t* params) { return effect_runner_reactive_splash_range(qsub8(g_last_hit_tracker.count, 1), params, &SOLID_SPLASH_range, &SOLID_SPLASH_math); }
 #            endif
 
 #            ifndef DISABLE_RGB_MATRIX_SOLID_MULTISPLASH
-bool SOLID_MULTISPLASH(effect_params_t* params) { return effect_runner_reactive_splash(0, params, &SOLID_SPLASH_math); }
+bool SOLID_MULTISPLASH(effect_params_t* params) { return effect_runner_reactive_splash_range(0, params, &SOLID_SPLASH_range, &SOLID_SPLASH_math); }
 #            endif
 
 #        endif  // RGB_MATRIX_CUSTOM_EFFECT_IMPLS
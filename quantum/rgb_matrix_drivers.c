@@ -60,6 +60,18 @@ static void init(void) {
 #    endif
 }
 
+static void set_color_batch(int index, const RGB *colors, uint8_t count) {
+    for (uint8_t i = 0; i < count; i++) {
+#    ifdef IS31FL3731
+        IS31FL3731_set_color(index + i, colors[i].r, colors[i].g, colors[i].b);
+#    elif defined(IS31FL3733)
+        IS31FL3733_set_color(index + i, colors[i].r, colors[i].g, colors[i].b);
+#    else
+        IS31FL3737_set_color(index + i, colors[i].r, colors[i].g, colors[i].b);
+#    endif
+    }
+}
+
 #    ifdef IS31FL3731
 static void flush(void) {
     IS31FL3731_update_pwm_buffers(DRIVER_ADDR_1, 0);
@@ -67,10 +79,11 @@ static void flush(void) {
 }
 
 const rgb_matrix_driver_t rgb_matrix_driver = {
-    .init          = init,
-    .flush         = flush,
-    .set_color     = IS31FL3731_set_color,
-    .set_color_all = IS31FL3731_set_color_all,
+    .init            = init,
+    .flush           = flush,
+    .set_color       = IS31FL3731_set_color,
+    .set_color_all   = IS31FL3731_set_color_all,
+    .set_color_batch = set_color_batch,
 };
 #    elif defined(IS31FL3733)
 static void flush(void) {
@@ -83,6 +96,7 @@ const rgb_matrix_driver_t rgb_matrix_driver = {
     .flush = flush,
     .set_color = IS31FL3733_set_color,
     .set_color_all = IS31FL3733_set_color_all,
+    .set_color_batch = set_color_batch,
 };
 #    else
 static void flush(void) { IS31FL3737_update_pwm_buffers(DRIVER_ADDR_1, DRIVER_ADDR_2); }
@@ -92,6 +106,7 @@ const rgb_matrix_driver_t rgb_matrix_driver = {
     .flush = flush,
     .set_color = IS31FL3737_set_color,
     .set_color_all = IS31FL3737_set_color_all,
+    .set_color_batch = set_color_batch,
 };
 #    endif
 
@@ -106,10 +121,19 @@ static void flush(void) {
 
 static void init(void) {}
 
+static void set_color_batch(int index, const RGB *colors, uint8_t count) {
+    for (uint8_t i = 0; i < count; i++) {
+        led[index + i].r = colors[i].r;
+        led[index + i].g = colors[i].g;
+        led[index + i].b = colors[i].b;
+    }
+}
+
 const rgb_matrix_driver_t rgb_matrix_driver = {
-    .init          = init,
-    .flush         = flush,
-    .set_color     = ws2812_setled,
-    .set_color_all = ws2812_setled_all,
+    .init            = init,
+    .flush           = flush,
+    .set_color       = ws2812_setled,
+    .set_color_all   = ws2812_setled_all,
+    .set_color_batch = set_color_batch,
 };
 #endif
@@ -0,0 +1,18 @@
+#pragma once
+
+typedef HSV (*polar_f)(HSV hsv, uint8_t dist, uint8_t angle, uint8_t time);
+
+bool effect_runner_polar(effect_params_t* params, polar_f effect_func) {
+    RGB_MATRIX_USE_LIMITS(led_min, led_max);
+
+    rgb_matrix_batch_t batch;
+    batch.count = 0;
+
+    uint8_t time = scale16by8(g_rgb_counters.tick, rgb_matrix_config.speed / 2);
+    for (uint8_t i = led_min; i < led_max; i++) {
+        RGB_MATRIX_TEST_LED_FLAGS();
+        rgb_matrix_batch_add(&batch, i, effect_func(rgb_matrix_config.hsv, g_rgb_led_dist[i], g_rgb_led_angle[i], time));
+    }
+    rgb_matrix_batch_flush(&batch);
+    return led_max < DRIVER_LED_TOTAL;
+}
@@ -4,26 +4,62 @@
 
 typedef HSV (*reactive_splash_f)(HSV hsv, int16_t dx, int16_t dy, uint8_t dist, uint16_t tick);
 
-bool effect_runner_reactive_splash(uint8_t start, effect_params_t* params, reactive_splash_f effect_func) {
+// Sets the distances from the hit at which the effect can still change an
+// LED, returns false if the hit can't change any LED anymore
+typedef bool (*reactive_splash_range_f)(uint16_t tick, uint8_t* min_dist, uint8_t* max_dist);
+
+bool effect_runner_reactive_splash_range(uint8_t start, effect_params_t* params, reactive_splash_range_f range_func, reactive_splash_f effect_func) {
     RGB_MATRIX_USE_LIMITS(led_min, led_max);
 
-    uint8_t count = g_last_hit_tracker.count;
+    rgb_matrix_batch_t batch;
+    batch.count = 0;
+
+    // The ticks and the reach of the hits are the same for every LED
+    uint8_t  count = 0;
+    uint8_t  hit[LED_HITS_TO_REMEMBER];
+    uint16_t tick[LED_HITS_TO_REMEMBER];
+    uint8_t  min_dist[LED_HITS_TO_REMEMBER];
+    uint8_t  max_dist[LED_HITS_TO_REMEMBER];
+    for (uint8_t j = start; j < g_last_hit_tracker.count; j++) {
+        tick[count]     = scale16by8(g_last_hit_tracker.tick[j], rgb_matrix_config.speed);
+        min_dist[count] = 0;
+        max_dist[count] = UINT8_MAX;
+        if (range_func && !range_func(tick[count], &min_dist[count], &max_dist[count])) {
+            continue;
+        }
+        hit[count] = j;
+        count++;
+    }
+
     for (uint8_t i = led_min; i < led_max; i++) {
         RGB_MATRIX_TEST_LED_FLAGS();
         HSV hsv = rgb_matrix_config.hsv;
         hsv.v   = 0;
-        for (uint8_t j = start; j < count; j++) {
-            int16_t  dx   = g_led_config.point[i].x - g_last_hit_tracker.x[j];
-            int16_t  dy   = g_led_config.point[i].y - g_last_hit_tracker.y[j];
-            uint8_t  dist = sqrt16(dx * dx + dy * dy);
-            uint16_t tick = scale16by8(g_last_hit_tracker.tick[j], rgb_matrix_config.speed);
-            hsv           = effect_func(hsv, dx, dy, dist, tick);
+        for (uint8_t k = 0; k < count; k++) {
+            uint8_t j  = hit[k];
+            int16_t dx = g_led_config.point[i].x - g_last_hit_tracker.x[j];
+            int16_t dy = g_led_config.point[i].y - g_last_hit_tracker.y[j];
+
+            // The distance lies between the larger of |dx| and |dy| and
+            // their sum, most LEDs are out of reach without the sqrt
+            uint16_t abs_dx = dx < 0 ? -dx : dx;
+            uint16_t abs_dy = dy < 0 ? -dy : dy;
+            if ((abs_dx > abs_dy ? abs_dx : abs_dy) > max_dist[k] || abs_dx + abs_dy < min_dist[k]) {
+                continue;
+            }
+            uint8_t dist = sqrt16(dx * dx + dy * dy);
+            if (dist < min_dist[k] || dist > max_dist[k]) {
+                continue;
+            }
+            hsv = effect_func(hsv, dx, dy, dist, tick[k]);
         }
-        hsv.v   = scale8(hsv.v, rgb_matrix_config.hsv.v);
-        RGB rgb = hsv_to_rgb(hsv);
-        rgb_matrix_set_color(i, rgb.r, rgb.g, rgb.b);
+        hsv.v = scale8(hsv.v, rgb_matrix_config.hsv.v);
+        rgb_matrix_batch_add(&batch, i, hsv);
     }
+    rgb_matrix_batch_flush(&batch);
     return led_max < DRIVER_LED_TOTAL;
 }
 
+bool effect_runner_reactive_splash(uint8_t start, effect_params_t* params, reactive_splash_f effect_func) { return effect_runner_reactive_splash_range(start, params, NULL, effect_func); }
+
 #endif  // RGB_MATRIX_KEYREACTIVE_ENABLED
@@ -586,6 +586,25 @@ void rgblight_sethsv_slave(uint8_t hue, uint8_t sat, uint8_t val) { rgblight_set
 #endif  // ifndef RGBLIGHT_SPLIT
 
 #ifndef RGBLIGHT_CUSTOM_DRIVER
+// The last frame sent, the animations and the layer indicators call
+// rgblight_set() on every step whether the colors changed or not
+static bool     frame_sent = false;
+static LED_TYPE frame_last[RGBLED_NUM];
+static uint8_t  frame_start_pos;
+static uint8_t  frame_num_leds;
+
+// Returns false if the frame is the same as the last one sent
+static bool rgblight_frame_changed(void) {
+    if (frame_sent && clipping_start_pos == frame_start_pos && clipping_num_leds == frame_num_leds && memcmp(frame_last, led, sizeof(led)) == 0) {
+        return false;
+    }
+    frame_sent = true;
+    memcpy(frame_last, led, sizeof(led));
+    frame_start_pos = clipping_start_pos;
+    frame_num_leds  = clipping_num_leds;
+    return true;
+}
+
 void rgblight_set(void) {
     LED_TYPE *start_led;
     uint16_t  num_leds = clipping_num_leds;
@@ -597,6 +616,9 @@ void rgblight_set(void) {
             led[i].b = 0;
         }
     }
+    if (!rgblight_frame_changed()) {
+        return;
+    }
 #    ifdef RGBLIGHT_LED_MAP
     LED_TYPE led0[RGBLED_NUM];
     for (uint8_t i = 0; i < RGBLED_NUM; i++) {
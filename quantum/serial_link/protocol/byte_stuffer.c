@@ -89,6 +89,7 @@ void byte_stuffer_recv_byte(uint8_t link, uint8_t data) {
             } else {
                 // Special case for zeroes
                 state->next_zero               = data;
+                state->long_frame              = data == 0xFF;
                 state->data[state->data_pos++] = 0;
             }
         } else {
@@ -0,0 +1,56 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2016 Fred Sundvik
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef SERIAL_LINK_CRC32_H
+#define SERIAL_LINK_CRC32_H
+
+#include <stdint.h>
+
+// The CRC32 used by the frame validator, the usual reflected 0xEDB88320 one.
+//
+// The backend is selected at compile time:
+//   SERIAL_LINK_CRC_HARDWARE  uses the CRC peripheral of STM32 parts, the
+//                             bytes which don't fill a word go through the
+//                             lookup tables
+//   SERIAL_LINK_CRC_SLICES    number of lookup tables, 1, 4 or 8. With more
+//                             tables the CRC handles 4 or 8 bytes per step,
+//                             at the cost of 1kB of flash per table. Defaults
+//                             to 1 on AVR and to 4 everywhere else.
+#ifndef SERIAL_LINK_CRC_SLICES
+#    if defined(__AVR__)
+#        define SERIAL_LINK_CRC_SLICES 1
+#    else
+#        define SERIAL_LINK_CRC_SLICES 4
+#    endif
+#endif
+
+#define CRC32_INITIAL 0xFFFFFFFF
+
+uint32_t crc32(const uint8_t* data, uint16_t size);
+// Continues a CRC over more data, crc32() is the same as crc32_update() from
+// CRC32_INITIAL with the result inverted. The hardware backend is only used
+// when starting from CRC32_INITIAL.
+uint32_t crc32_update(uint32_t crc, const uint8_t* data, uint16_t size);
+
+#endif
@@ -28,7 +28,9 @@ SOFTWARE.
 #include <stdint.h>
 
 void validator_recv_frame(uint8_t link, uint8_t* data, uint16_t size);
-// The buffer pointed to by the data needs 4 additional bytes
+// The buffer pointed to by the data needs 4 additional bytes. A frame can be
+// forwarded by sending it from route_incoming_frame() without copying it,
+// as long as only its last byte is modified.
 void validator_send_frame(uint8_t link, uint8_t* data, uint16_t size);
 
 #endif
@@ -23,55 +23,75 @@ SOFTWARE.
 */
 
 #include "serial_link/protocol/triple_buffered_object.h"
-#include "serial_link/system/serial_link.h"
 #include <stdbool.h>
 #include <stddef.h>
 
-#define GET_READ_INDEX() object->state & 3
-#define GET_WRITE_INDEX() (object->state >> 2) & 3
-#define GET_SHARED_INDEX() (object->state >> 4) & 3
-#define GET_DATA_AVAILABLE() (object->state >> 6) & 1
+// The indices and the data available flag are packed into the state byte,
+// so that a read or a write swaps them all at once with a compare and swap.
+// Cortex-M0 has no exclusive load and store instructions, so it does the
+// compare and swap under the serial link lock instead.
+#if !defined(__ARM_ARCH_6M__) && !defined(TRIPLE_BUFFER_USE_LOCK)
+#    define TRIPLE_BUFFER_LOCK_FREE
+#else
+#    include "serial_link/system/serial_link.h"
+#endif
 
-#define SET_READ_INDEX(i) object->state = ((object->state & ~3) | i)
-#define SET_WRITE_INDEX(i) object->state = ((object->state & ~(3 << 2)) | (i << 2))
-#define SET_SHARED_INDEX(i) object->state = ((object->state & ~(3 << 4)) | (i << 4))
-#define SET_DATA_AVAILABLE(i) object->state = ((object->state & ~(1 << 6)) | (i << 6))
+#define GET_READ_INDEX(state) ((state)&3)
+#define GET_WRITE_INDEX(state) (((state) >> 2) & 3)
+#define GET_SHARED_INDEX(state) (((state) >> 4) & 3)
+#define GET_DATA_AVAILABLE(state) (((state) >> 6) & 1)
 
-void triple_buffer_init(triple_buffer_object_t* object) {
-    object->state = 0;
-    SET_WRITE_INDEX(0);
-    SET_READ_INDEX(1);
-    SET_SHARED_INDEX(2);
-    SET_DATA_AVAILABLE(0);
+#define MAKE_STATE(read, write, shared, available) ((read) | ((write) << 2) | ((shared) << 4) | ((available) << 6))
+
+static inline uint8_t load_state(triple_buffer_object_t* object) {
+#ifdef TRIPLE_BUFFER_LOCK_FREE
+    return __atomic_load_n(&object->state, __ATOMIC_ACQUIRE);
+#else
+    return *(volatile uint8_t*)&object->state;
+#endif
 }
 
-void* triple_buffer_read_internal(uint16_t object_size, triple_buffer_object_t* object) {
+// Replaces the state with desired if it still is expected, otherwise
+// updates expected with the current state
+static inline bool compare_and_swap_state(triple_buffer_object_t* object, uint8_t* expected, uint8_t desired) {
+#ifdef TRIPLE_BUFFER_LOCK_FREE
+    return __atomic_compare_exchange_n(&object->state, expected, desired, true, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+#else
+    bool swapped;
     serial_link_lock();
-    if (GET_DATA_AVAILABLE()) {
-        uint8_t shared_index = GET_SHARED_INDEX();
-        uint8_t read_index   = GET_READ_INDEX();
-        SET_READ_INDEX(shared_index);
-        SET_SHARED_INDEX(read_index);
-        SET_DATA_AVAILABLE(false);
-        serial_link_unlock();
-        return object->buffer + object_size * shared_index;
+    swapped = object->state == *expected;
+    if (swapped) {
+        object->state = desired;
     } else {
-        serial_link_unlock();
-        return NULL;
+        *expected = object->state;
     }
+    serial_link_unlock();
+    return swapped;
+#endif
+}
+
+void triple_buffer_init(triple_buffer_object_t* object) { object->state = MAKE_STATE(1, 0, 2, false); }
+
+void* triple_buffer_read_internal(uint16_t object_size, triple_buffer_object_t* object) {
+    uint8_t state = load_state(object);
+    uint8_t shared_index;
+    do {
+        if (!GET_DATA_AVAILABLE(state)) {
+            return NULL;
+        }
+        shared_index = GET_SHARED_INDEX(state);
+    } while (!compare_and_swap_state(object, &state, MAKE_STATE(shared_index, GET_WRITE_INDEX(state), GET_READ_INDEX(state), false)));
+    return object->buffer + object_size * shared_index;
 }
 
 void* triple_buffer_begin_write_internal(uint16_t object_size, triple_buffer_object_t* object) {
-    uint8_t write_index = GET_WRITE_INDEX();
+    // Only the writer changes the write index
+    uint8_t write_index = GET_WRITE_INDEX(load_state(object));
     return object->buffer + object_size * write_index;
 }
 
 void triple_buffer_end_write_internal(triple_buffer_object_t* object) {
-    serial_link_lock();
-    uint8_t shared_index = GET_SHARED_INDEX();
-    uint8_t write_index  = GET_WRITE_INDEX();
-    SET_SHARED_INDEX(write_index);
-    SET_WRITE_INDEX(shared_index);
-    SET_DATA_AVAILABLE(true);
-    serial_link_unlock();
+    uint8_t state = load_state(object);
+    while (!compare_and_swap_state(object, &state, MAKE_STATE(GET_READ_INDEX(state), GET_SHARED_INDEX(state), GET_WRITE_INDEX(state), true))) {
+    }
 }
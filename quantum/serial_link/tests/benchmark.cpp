@@ -0,0 +1,237 @@
+#include "gtest/gtest.h"
+#include <chrono>
+#include <cstdio>
+#include <vector>
+extern "C" {
+#include "serial_link/protocol/byte_stuffer.h"
+#include "serial_link/protocol/frame_validator.h"
+#include "serial_link/protocol/crc32.h"
+#include "serial_link/protocol/frame_router.h"
+#include "serial_link/protocol/physical.h"
+extern const uint32_t poly8_lookup[256];
+}
+#if defined(__x86_64__) || defined(__i386__)
+#    include <x86intrin.h>
+#endif
+
+// Throughput of the serial_link protocol stack on the host. Run it with
+//   make test:serial_link_benchmark
+// The numbers are only comparable between runs on the same machine, the
+// point is to see the effect of changes to the stack.
+
+#ifndef SERIAL_LINK_BENCHMARK_ITERATIONS
+#    define SERIAL_LINK_BENCHMARK_ITERATIONS 2000
+#endif
+
+// Destination byte added by the router, and the CRC added by the validator
+#define FRAME_OVERHEAD 5
+
+static const uint16_t frame_sizes[] = {4, 16, 64, 256, 1000};
+
+static std::vector<uint8_t> wire[NUM_LINKS];
+static bool                 capture_wire;
+static uint32_t             frames_received;
+static uint32_t             bytes_received;
+static uintptr_t            stack_deepest;
+
+static void __attribute__((noinline)) mark_stack(void) {
+    volatile uint8_t marker;
+    uintptr_t        address = (uintptr_t)&marker;
+    if (address < stack_deepest) {
+        stack_deepest = address;
+    }
+}
+
+extern "C" void send_data(uint8_t link, const uint8_t* data, uint16_t size) {
+    mark_stack();
+    if (capture_wire) {
+        wire[link].insert(wire[link].end(), data, data + size);
+    }
+}
+
+extern "C" void transport_recv_frame(uint8_t from, uint8_t* data, uint16_t size) {
+    mark_stack();
+    frames_received++;
+    bytes_received += size;
+}
+
+static uint64_t read_cycles(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+class SerialLinkBenchmark : public testing::Test {
+   public:
+    SerialLinkBenchmark() {
+        init_byte_stuffer();
+        router_set_master(true);
+        capture_wire    = false;
+        frames_received = 0;
+        bytes_received  = 0;
+        for (auto& link : wire) {
+            link.clear();
+        }
+        // Random data, with the occasional zero for the byte stuffer
+        uint32_t seed = 1;
+        for (auto& byte : data) {
+            seed = seed * 1103515245 + 12345;
+            byte = seed >> 16;
+        }
+    }
+
+    void start() {
+        start_time   = std::chrono::steady_clock::now();
+        start_cycles = read_cycles();
+    }
+
+    // Prints the time it took to process bytes since start()
+    void report(const char* name, uint16_t frame_size, uint64_t bytes) {
+        uint64_t cycles  = read_cycles() - start_cycles;
+        double   seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+        printf("%-28s %5u %10.2f MB/s", name, frame_size, bytes / seconds / 1e6);
+        if (cycles) {
+            printf(" %8.2f cycles/byte", (double)cycles / bytes);
+        }
+        printf("\n");
+    }
+
+    // Encodes a frame the way it arrives on the down link of the master
+    std::vector<uint8_t> encode_frame(uint16_t size, uint8_t last_byte = 1) {
+        uint8_t buffer[MAX_FRAME_SIZE];
+        std::copy(data, data + size, buffer);
+        buffer[size] = last_byte;
+        wire[DOWN_LINK].clear();
+        capture_wire = true;
+        validator_send_frame(DOWN_LINK, buffer, size + 1);
+        capture_wire = false;
+        return wire[DOWN_LINK];
+    }
+
+    uint8_t                               data[MAX_FRAME_SIZE];
+    std::chrono::steady_clock::time_point start_time;
+    uint64_t                              start_cycles;
+};
+
+TEST_F(SerialLinkBenchmark, byte_stuffing) {
+    uint8_t buffer[MAX_FRAME_SIZE];
+    for (uint16_t size : frame_sizes) {
+        start();
+        for (int i = 0; i < SERIAL_LINK_BENCHMARK_ITERATIONS; i++) {
+            std::copy(data, data + size, buffer);
+            byte_stuffer_send_frame(DOWN_LINK, buffer, size);
+        }
+        report("stuff", size, (uint64_t)size * SERIAL_LINK_BENCHMARK_ITERATIONS);
+    }
+}
+
+TEST_F(SerialLinkBenchmark, crc_validation) {
+    uint8_t buffer[MAX_FRAME_SIZE];
+    for (uint16_t size : frame_sizes) {
+        // The last byte is the sender of the frame, the master routes it
+        // up to the transport
+        std::copy(data, data + size + 1, buffer);
+        buffer[size] = 1;
+        capture_wire = true;
+        validator_send_frame(DOWN_LINK, buffer, size + 1);
+        capture_wire = false;
+
+        start();
+        for (int i = 0; i < SERIAL_LINK_BENCHMARK_ITERATIONS; i++) {
+            validator_recv_frame(DOWN_LINK, buffer, size + FRAME_OVERHEAD);
+        }
+        report("crc check", size, (uint64_t)size * SERIAL_LINK_BENCHMARK_ITERATIONS);
+        EXPECT_EQ(frames_received, SERIAL_LINK_BENCHMARK_ITERATIONS);
+        frames_received = 0;
+    }
+}
+
+TEST_F(SerialLinkBenchmark, send_path) {
+    uint8_t buffer[MAX_FRAME_SIZE];
+    for (uint16_t size : frame_sizes) {
+        start();
+        for (int i = 0; i < SERIAL_LINK_BENCHMARK_ITERATIONS; i++) {
+            std::copy(data, data + size, buffer);
+            router_send_frame(1, buffer, size);
+        }
+        report("route + crc + stuff", size, (uint64_t)size * SERIAL_LINK_BENCHMARK_ITERATIONS);
+    }
+}
+
+TEST_F(SerialLinkBenchmark, receive_path) {
+    for (uint16_t size : frame_sizes) {
+        std::vector<uint8_t> encoded = encode_frame(size);
+
+        start();
+        for (int i = 0; i < SERIAL_LINK_BENCHMARK_ITERATIONS; i++) {
+            for (uint8_t byte : encoded) {
+                byte_stuffer_recv_byte(DOWN_LINK, byte);
+            }
+        }
+        report("unstuff + crc + route", size, (uint64_t)size * SERIAL_LINK_BENCHMARK_ITERATIONS);
+        EXPECT_EQ(frames_received, SERIAL_LINK_BENCHMARK_ITERATIONS);
+        EXPECT_EQ(bytes_received, (uint32_t)size * SERIAL_LINK_BENCHMARK_ITERATIONS);
+        frames_received = 0;
+        bytes_received  = 0;
+    }
+}
+
+TEST_F(SerialLinkBenchmark, forward_path) {
+    router_set_master(false);
+    for (uint16_t size : frame_sizes) {
+        // Addressed to the next slave down the chain
+        std::vector<uint8_t> encoded = encode_frame(size, 2);
+
+        start();
+        for (int i = 0; i < SERIAL_LINK_BENCHMARK_ITERATIONS; i++) {
+            for (uint8_t byte : encoded) {
+                byte_stuffer_recv_byte(UP_LINK, byte);
+            }
+        }
+        report("unstuff + crc + forward", size, (uint64_t)size * SERIAL_LINK_BENCHMARK_ITERATIONS);
+        EXPECT_EQ(frames_received, 0u);
+    }
+
+    // The forwarded frame is valid for the next slave
+    std::vector<uint8_t> expected = encode_frame(frame_sizes[0], 1);
+    std::vector<uint8_t> encoded  = encode_frame(frame_sizes[0], 2);
+    wire[DOWN_LINK].clear();
+    capture_wire = true;
+    for (uint8_t byte : encoded) {
+        byte_stuffer_recv_byte(UP_LINK, byte);
+    }
+    capture_wire = false;
+    EXPECT_EQ(wire[DOWN_LINK], expected);
+}
+
+TEST_F(SerialLinkBenchmark, memory_usage) {
+    uint8_t   buffer[MAX_FRAME_SIZE];
+    uint16_t  size = frame_sizes[sizeof(frame_sizes) / sizeof(frame_sizes[0]) - 1];
+    uint8_t   base_marker;
+    uintptr_t base = (uintptr_t)&base_marker;
+
+    std::copy(data, data + size, buffer);
+    stack_deepest = base;
+    router_send_frame(1, buffer, size);
+    uintptr_t send_stack = base - stack_deepest;
+
+    std::vector<uint8_t> encoded = encode_frame(size);
+    stack_deepest                = base;
+    for (uint8_t byte : encoded) {
+        byte_stuffer_recv_byte(DOWN_LINK, byte);
+    }
+    uintptr_t receive_stack = base - stack_deepest;
+
+    // The byte stuffer keeps a frame buffer per link, the stack usage is the
+    // depth reached below this function on the way to the physical layer
+    // and to the transport
+    printf("receive buffers       %6u bytes\n", (unsigned)(NUM_LINKS * MAX_FRAME_SIZE));
+    printf("crc tables            %6u bytes\n", (unsigned)(sizeof(poly8_lookup) * SERIAL_LINK_CRC_SLICES));
+    printf("send stack            %6u bytes\n", (unsigned)send_stack);
+    printf("receive stack         %6u bytes\n", (unsigned)receive_stack);
+    printf("send buffer overhead  %6u bytes\n", FRAME_OVERHEAD);
+    printf("wire overhead         %6u bytes for a %u byte frame\n", (unsigned)(encoded.size() - size), size);
+    EXPECT_EQ(frames_received, 1u);
+}
@@ -448,3 +448,17 @@ TEST_F(ByteStuffer, sends_and_receives_full_roundtrip_254_bytes_and_then_zero) {
         byte_stuffer_recv_byte(1, d);
     }
 }
+
+TEST_F(ByteStuffer, sends_and_receives_full_roundtrip_zero_and_then_256_bytes) {
+    uint8_t original_data[257];
+    int     i;
+    original_data[0] = 0;
+    for (i = 1; i < 257; i++) {
+        original_data[i] = i;
+    }
+    byte_stuffer_send_frame(0, original_data, sizeof(original_data));
+    EXPECT_CALL(*this, validator_recv_frame(_, _, _)).With(Args<1, 2>(ElementsAreArray(original_data)));
+    for (auto& d : sent_data) {
+        byte_stuffer_recv_byte(1, d);
+    }
+}
@@ -0,0 +1,81 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2016 Fred Sundvik
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "gtest/gtest.h"
+#include <string.h>
+extern "C" {
+#include "serial_link/protocol/crc32.h"
+}
+
+// Bit by bit, the way the tables were generated
+static uint32_t reference_crc32(const uint8_t* data, uint16_t size) {
+    uint32_t crc = 0xFFFFFFFF;
+    for (uint16_t i = 0; i < size; i++) {
+        crc ^= data[i];
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc >> 1) ^ (crc & 1 ? 0xEDB88320 : 0);
+        }
+    }
+    return crc ^ 0xFFFFFFFF;
+}
+
+TEST(CRC32, calculates_check_value) {
+    const char* check = "123456789";
+    EXPECT_EQ(crc32((const uint8_t*)check, 9), 0xCBF43926);
+}
+
+TEST(CRC32, empty_data_is_zero) { EXPECT_EQ(crc32(nullptr, 0), 0u); }
+
+TEST(CRC32, matches_frame_validator_test_vectors) {
+    uint8_t one_byte[]   = {0x44};
+    uint8_t five_bytes[] = {1, 2, 3, 4, 5};
+    EXPECT_EQ(crc32(one_byte, 1), 0xA3B36A04);
+    EXPECT_EQ(crc32(five_bytes, 5), 0x470B99F4);
+}
+
+// Covers every remainder of the sliced loop, at every alignment
+TEST(CRC32, matches_reference_for_all_sizes_and_alignments) {
+    uint8_t  data[300];
+    uint32_t seed = 1;
+    for (auto& byte : data) {
+        seed = seed * 1103515245 + 12345;
+        byte = seed >> 16;
+    }
+    for (uint16_t offset = 0; offset < 8; offset++) {
+        for (uint16_t size = 0; size <= 256; size++) {
+            ASSERT_EQ(crc32(data + offset, size), reference_crc32(data + offset, size)) << "size " << size << " offset " << offset;
+        }
+    }
+}
+
+TEST(CRC32, detects_single_bit_errors) {
+    uint8_t data[64];
+    memset(data, 0x5A, sizeof(data));
+    uint32_t crc = crc32(data, sizeof(data));
+    for (uint16_t bit = 0; bit < sizeof(data) * 8; bit++) {
+        data[bit / 8] ^= 1 << (bit % 8);
+        EXPECT_NE(crc32(data, sizeof(data)), crc);
+        data[bit / 8] ^= 1 << (bit % 8);
+    }
+}
@@ -1,6 +1,10 @@
 TEST_LIST +=\
 	serial_link_byte_stuffer\
 	serial_link_frame_validator\
+	serial_link_crc32\
+	serial_link_crc32_byte\
+	serial_link_crc32_slice8\
 	serial_link_frame_router\
 	serial_link_triple_buffered_object\
-	serial_link_transport
\ No newline at end of file
+	serial_link_transport\
+	serial_link_benchmark
\ No newline at end of file
@@ -23,6 +23,8 @@ SOFTWARE.
 */
 
 #include "gtest/gtest.h"
+#include <atomic>
+#include <thread>
 extern "C" {
 #include "serial_link/protocol/triple_buffered_object.h"
 }
@@ -78,3 +80,60 @@ TEST_F(TripleBufferedObject, performs_two_writes_in_the_middle_of_read) {
     EXPECT_EQ(*triple_buffer_read(&test_object), 3);
     EXPECT_EQ(triple_buffer_read(&test_object), nullptr);
 }
+
+struct stress_object {
+    uint8_t state;
+    struct {
+        uint32_t sequence;
+        uint32_t check;
+    } buffer[3];
+};
+
+// The writer and the reader run on their own threads, the reader must only
+// ever see complete objects, in the order they were written
+TEST(TripleBufferedObjectThreads, reads_consistent_objects_while_writing) {
+    const uint32_t        writes = 200000;
+    struct stress_object  object;
+    std::atomic<bool>     done(false);
+    uint32_t              reads         = 0;
+    uint32_t              torn          = 0;
+    uint32_t              out_of_order  = 0;
+    uint32_t              last_sequence = 0;
+    triple_buffer_init((triple_buffer_object_t*)&object);
+
+    std::thread writer([&]() {
+        for (uint32_t i = 1; i <= writes; i++) {
+            auto* data     = triple_buffer_begin_write(&object);
+            data->sequence = i;
+            data->check    = ~i;
+            triple_buffer_end_write(&object);
+        }
+        done = true;
+    });
+
+    while (last_sequence != writes) {
+        bool writer_done = done;
+        auto* data       = triple_buffer_read(&object);
+        if (data == nullptr) {
+            // The last write is always readable after the writer is done
+            if (writer_done) {
+                break;
+            }
+            continue;
+        }
+        reads++;
+        if (data->check != ~data->sequence) {
+            torn++;
+        }
+        if (data->sequence <= last_sequence) {
+            out_of_order++;
+        }
+        last_sequence = data->sequence;
+    }
+    writer.join();
+
+    EXPECT_EQ(last_sequence, writes);
+    EXPECT_GT(reads, 0u);
+    EXPECT_EQ(torn, 0u);
+    EXPECT_EQ(out_of_order, 0u);
+}
@@ -12,8 +12,9 @@
 // When using serial, the user must define RGBLIGHT_SPLIT explicitly
 //  in config.h as needed.
 //      see quantum/rgblight_post_config.h
-#    if defined(RGBLIGHT_ENABLE) && defined(RGBLIGHT_SPLIT)
-// When using serial and RGBLIGHT_SPLIT need separate transaction
+//
+// Each split transaction is a separate serial transaction.
+#    ifndef SERIAL_USE_MULTI_TRANSACTION
 #        define SERIAL_USE_MULTI_TRANSACTION
 #    endif
 #endif
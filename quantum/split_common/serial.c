@@ -163,6 +163,26 @@
 #    define SERIAL_DELAY_HALF1 (SERIAL_DELAY / 2)
 #    define SERIAL_DELAY_HALF2 (SERIAL_DELAY - SERIAL_DELAY / 2)
 
+#    ifdef SELECT_SOFT_SERIAL_FALLBACK_SPEED
+// Slower speed the link can be switched to at runtime.
+// It keeps the cycle adjustments of the main speed.
+#        if SELECT_SOFT_SERIAL_FALLBACK_SPEED == 1
+#            define SERIAL_FALLBACK_DELAY 6  // micro sec
+#        elif SELECT_SOFT_SERIAL_FALLBACK_SPEED == 2
+#            define SERIAL_FALLBACK_DELAY 12  // micro sec
+#        elif SELECT_SOFT_SERIAL_FALLBACK_SPEED == 3
+#            define SERIAL_FALLBACK_DELAY 24  // micro sec
+#        elif SELECT_SOFT_SERIAL_FALLBACK_SPEED == 4
+#            define SERIAL_FALLBACK_DELAY 36  // micro sec
+#        elif SELECT_SOFT_SERIAL_FALLBACK_SPEED == 5
+#            define SERIAL_FALLBACK_DELAY 48  // micro sec
+#        else
+#            error invalid SELECT_SOFT_SERIAL_FALLBACK_SPEED value
+#        endif
+#        define SERIAL_FALLBACK_DELAY_HALF1 (SERIAL_FALLBACK_DELAY / 2)
+#        define SERIAL_FALLBACK_DELAY_HALF2 (SERIAL_FALLBACK_DELAY - SERIAL_FALLBACK_DELAY / 2)
+#    endif
+
 #    define SLAVE_INT_WIDTH_US 1
 #    ifndef SERIAL_USE_MULTI_TRANSACTION
 #        define SLAVE_INT_RESPONSE_TIME SERIAL_DELAY
@@ -174,6 +194,7 @@
 static SSTD_t *Transaction_table      = NULL;
 static uint8_t Transaction_table_size = 0;
 
+#    ifndef SELECT_SOFT_SERIAL_FALLBACK_SPEED
 inline static void serial_delay(void) ALWAYS_INLINE;
 inline static void serial_delay(void) { _delay_us(SERIAL_DELAY); }
 
@@ -183,6 +204,45 @@ inline static void serial_delay_half1(void) { _delay_us(SERIAL_DELAY_HALF1); }
 inline static void serial_delay_half2(void) ALWAYS_INLINE;
 inline static void serial_delay_half2(void) { _delay_us(SERIAL_DELAY_HALF2); }
 
+#        define SYNC_RECV_WAIT (SERIAL_DELAY * 5)
+#    else
+static volatile bool serial_fallback = false;
+
+void soft_serial_set_fallback(bool fallback) { serial_fallback = fallback; }
+
+bool soft_serial_is_fallback(void) { return serial_fallback; }
+
+// The speed check adds a few cycles per bit on both sides alike
+inline static void serial_delay(void) ALWAYS_INLINE;
+inline static void serial_delay(void) {
+    if (serial_fallback) {
+        _delay_us(SERIAL_FALLBACK_DELAY);
+    } else {
+        _delay_us(SERIAL_DELAY);
+    }
+}
+
+inline static void serial_delay_half1(void) ALWAYS_INLINE;
+inline static void serial_delay_half1(void) {
+    if (serial_fallback) {
+        _delay_us(SERIAL_FALLBACK_DELAY_HALF1);
+    } else {
+        _delay_us(SERIAL_DELAY_HALF1);
+    }
+}
+
+inline static void serial_delay_half2(void) ALWAYS_INLINE;
+inline static void serial_delay_half2(void) {
+    if (serial_fallback) {
+        _delay_us(SERIAL_FALLBACK_DELAY_HALF2);
+    } else {
+        _delay_us(SERIAL_DELAY_HALF2);
+    }
+}
+
+#        define SYNC_RECV_WAIT (serial_fallback ? SERIAL_FALLBACK_DELAY * 5 : SERIAL_DELAY * 5)
+#    endif
+
 inline static void serial_output(void) ALWAYS_INLINE;
 inline static void serial_output(void) { setPinOutput(SOFT_SERIAL_PIN); }
 
@@ -225,7 +285,8 @@ void soft_serial_target_init(SSTD_t *sstd_table, int sstd_table_size) {
 // Used by the sender to synchronize timing with the reciver.
 static void sync_recv(void) NO_INLINE;
 static void sync_recv(void) {
-    for (uint8_t i = 0; i < SERIAL_DELAY * 5 && serial_read_pin(); i++) {
+    uint8_t wait = SYNC_RECV_WAIT;
+    for (uint8_t i = 0; i < wait && serial_read_pin(); i++) {
     }
     // This shouldn't hang if the target disconnects because the
     // serial line will float to high if the target does disconnect.
@@ -19,6 +19,9 @@
 // //// USE flexible API (using multi-type transaction function)
 //   #define SERIAL_USE_MULTI_TRANSACTION
 //
+//  OPTIONAL: #define SELECT_SOFT_SERIAL_FALLBACK_SPEED ? // ? = 1,2,3,4,5
+//                       slower speed that can be selected at runtime
+//
 // /////////////////////////////////////////////////////////////////
 
 // Soft Serial Transaction Descriptor
@@ -60,3 +63,9 @@ int soft_serial_transaction(int sstd_index);
 #ifdef SERIAL_USE_MULTI_TRANSACTION
 int soft_serial_get_and_clean_status(int sstd_index);
 #endif
+
+#ifdef SELECT_SOFT_SERIAL_FALLBACK_SPEED
+// both sides must use the same speed
+void soft_serial_set_fallback(bool fallback);
+bool soft_serial_is_fallback(void);
+#endif
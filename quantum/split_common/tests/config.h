@@ -0,0 +1,4 @@
+#pragma once
+
+#define MATRIX_ROWS 4
+#define MATRIX_COLS 8
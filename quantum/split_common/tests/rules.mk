@@ -0,0 +1,22 @@
+split_common_transactions_SRC := \
+	$(QUANTUM_PATH)/split_common/tests/transactions_tests.cpp \
+	$(QUANTUM_PATH)/split_common/transactions.c \
+	$(TMK_PATH)/common/test/timer.c
+
+split_common_transactions_DEFS := -DSPLIT_TRANSACTION_STATS
+
+split_common_transport_SRC := \
+	$(QUANTUM_PATH)/split_common/tests/transport_tests.cpp \
+	$(QUANTUM_PATH)/split_common/tests/serial_sim.c \
+	$(QUANTUM_PATH)/split_common/transport.c \
+	$(QUANTUM_PATH)/split_common/transactions.c \
+	$(TMK_PATH)/common/test/timer.c
+
+split_common_transport_INC := $(QUANTUM_PATH)/split_common/tests
+split_common_transport_CONFIG := $(QUANTUM_PATH)/split_common/tests/config.h
+split_common_transport_DEFS := -DSERIAL_USE_MULTI_TRANSACTION -DBACKLIGHT_ENABLE -DNO_DEBUG
+
+split_common_transport_delta_SRC := $(split_common_transport_SRC)
+split_common_transport_delta_INC := $(split_common_transport_INC)
+split_common_transport_delta_CONFIG := $(split_common_transport_CONFIG)
+split_common_transport_delta_DEFS := $(split_common_transport_DEFS) -DSPLIT_TRANSPORT_DELTA -DSELECT_SOFT_SERIAL_FALLBACK_SPEED=2
@@ -0,0 +1,250 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "split_common/serial.h"
+#include "serial_sim.h"
+
+// From the test timer
+void advance_time(uint32_t ms);
+
+#define SIM_TRANSACTIONS_MAX 16
+#define SIM_BUFFER_SIZE 255
+
+// Interrupt pulse, transaction id with its bit count and acknowledge
+#define SIM_HANDSHAKE_BITS 16
+// Sync, 8 data bits and a parity bit
+#define SIM_BYTE_BITS 10
+
+static serial_sim_config_t sim_config;
+static serial_sim_stats_t  sim_stats;
+static uint32_t            sim_random_state;
+static uint16_t            sim_pending_us;
+static bool                sim_connected;
+static bool                sim_in_slave;
+
+static SSTD_t *sim_table;
+static int     sim_table_size;
+
+// The slave half copy of the transaction buffers, swapped with the real
+// ones while the slave half runs
+static uint8_t sim_i2t[SIM_TRANSACTIONS_MAX][SIM_BUFFER_SIZE];
+static uint8_t sim_t2i[SIM_TRANSACTIONS_MAX][SIM_BUFFER_SIZE];
+static uint8_t sim_status[SIM_TRANSACTIONS_MAX];
+
+// Speed selected by each half, indexed by sim_in_slave
+static bool sim_fallback[2];
+
+void serial_sim_get_default_config(serial_sim_config_t *config) {
+    memset(config, 0, sizeof(serial_sim_config_t));
+    config->bit_time_us          = 7;
+    config->fallback_bit_time_us = 26;
+    config->timeout_us           = 20;
+    config->seed                 = 1;
+}
+
+void serial_sim_set_config(const serial_sim_config_t *config) {
+    sim_config       = *config;
+    sim_random_state = config->seed ? config->seed : 1;
+}
+
+void serial_sim_init(const serial_sim_config_t *config) {
+    serial_sim_config_t defaults;
+    if (config == NULL) {
+        serial_sim_get_default_config(&defaults);
+        config = &defaults;
+    }
+    serial_sim_set_config(config);
+    serial_sim_clear_stats();
+    sim_pending_us = 0;
+    sim_connected  = true;
+    sim_in_slave   = false;
+    memset(sim_fallback, 0, sizeof(sim_fallback));
+    memset(sim_i2t, 0, sizeof(sim_i2t));
+    memset(sim_t2i, 0, sizeof(sim_t2i));
+    memset(sim_status, 0, sizeof(sim_status));
+}
+
+void serial_sim_set_connected(bool connected) { sim_connected = connected; }
+
+const serial_sim_stats_t *serial_sim_get_stats(void) { return &sim_stats; }
+
+void serial_sim_clear_stats(void) { memset(&sim_stats, 0, sizeof(sim_stats)); }
+
+static void sim_swap(uint8_t *a, uint8_t *b, uint8_t size) {
+    for (uint8_t i = 0; i < size; i++) {
+        uint8_t tmp = a[i];
+        a[i]        = b[i];
+        b[i]        = tmp;
+    }
+}
+
+static void sim_swap_halves(void) {
+    for (int id = 0; id < sim_table_size && id < SIM_TRANSACTIONS_MAX; id++) {
+        SSTD_t *trans = &sim_table[id];
+        if (trans->initiator2target_buffer) {
+            sim_swap(trans->initiator2target_buffer, sim_i2t[id], trans->initiator2target_buffer_size);
+        }
+        if (trans->target2initiator_buffer) {
+            sim_swap(trans->target2initiator_buffer, sim_t2i[id], trans->target2initiator_buffer_size);
+        }
+        if (trans->status) {
+            sim_swap(trans->status, &sim_status[id], 1);
+        }
+    }
+    sim_in_slave = !sim_in_slave;
+}
+
+void serial_sim_run_slave(void (*task)(void)) {
+    if (sim_in_slave) {
+        task();
+        return;
+    }
+    sim_swap_halves();
+    task();
+    sim_swap_halves();
+}
+
+// xorshift32, so that runs are reproducible on any host
+static uint32_t sim_random(void) {
+    sim_random_state ^= sim_random_state << 13;
+    sim_random_state ^= sim_random_state >> 17;
+    sim_random_state ^= sim_random_state << 5;
+    return sim_random_state;
+}
+
+static bool sim_bit_error(void) {
+    uint32_t ppm = sim_fallback[0] ? sim_config.fallback_bit_error_ppm : sim_config.bit_error_ppm;
+    if (ppm && sim_random() % 1000000 < ppm) {
+        sim_stats.bit_errors++;
+        return true;
+    }
+    return false;
+}
+
+static void sim_elapse(uint32_t us) {
+    sim_stats.wire_time_us += us;
+    sim_pending_us += us;
+    while (sim_pending_us >= 1000) {
+        advance_time(1);
+        sim_pending_us -= 1000;
+    }
+}
+
+static void sim_elapse_bits(uint16_t bits) { sim_elapse((uint32_t)bits * (sim_fallback[0] ? sim_config.fallback_bit_time_us : sim_config.bit_time_us)); }
+
+static uint8_t sim_bit_count(uint16_t bits) {
+    uint8_t count = 0;
+    for (; bits; bits >>= 1) {
+        count += bits & 1;
+    }
+    return count;
+}
+
+// Same id encoding as serial.c: 4 bits of id followed by their bit count
+static bool sim_send_tid(int tid) {
+    uint8_t frame = (tid << 3) | (7 & sim_bit_count(tid));
+    for (uint8_t bit = 0; bit < 7; bit++) {
+        if (sim_bit_error()) {
+            frame ^= 1 << bit;
+        }
+    }
+    // A valid but different id would make the halves disagree on the
+    // transaction layout, treat it like an id the slave rejects
+    return frame == ((tid << 3) | (7 & sim_bit_count(tid)));
+}
+
+// Returns false on a parity error, the received data is stored anyway
+static bool sim_send_packet(const uint8_t *from, uint8_t *to, uint8_t size) {
+    bool ok = true;
+    for (uint8_t i = 0; i < size; i++) {
+        uint16_t frame = from[i] | ((sim_bit_count(from[i]) & 1) << 8);
+        for (uint8_t bit = 0; bit < 9; bit++) {
+            if (sim_bit_error()) {
+                frame ^= 1 << bit;
+            }
+        }
+        to[i] = frame & 0xFF;
+        if ((sim_bit_count(to[i]) & 1) != (frame >> 8)) {
+            ok = false;
+        } else if (to[i] != from[i]) {
+            sim_stats.undetected_errors++;
+        }
+        sim_stats.bytes++;
+    }
+    sim_elapse_bits(size * SIM_BYTE_BITS);
+    return ok;
+}
+
+void soft_serial_initiator_init(SSTD_t *sstd_table, int sstd_table_size) {
+    sim_table      = sstd_table;
+    sim_table_size = sstd_table_size;
+}
+
+void soft_serial_target_init(SSTD_t *sstd_table, int sstd_table_size) {
+    sim_table      = sstd_table;
+    sim_table_size = sstd_table_size;
+}
+
+static int sim_initiator_result(SSTD_t *trans, int status) {
+    *trans->status = status;
+    if (status == TRANSACTION_NO_RESPONSE) {
+        sim_stats.no_response++;
+    } else if (status == TRANSACTION_DATA_ERROR) {
+        sim_stats.data_errors++;
+    }
+    return status;
+}
+
+int soft_serial_transaction(int sstd_index) {
+    if (sim_in_slave || sstd_index < 0 || sstd_index >= sim_table_size || sstd_index >= SIM_TRANSACTIONS_MAX) {
+        return TRANSACTION_TYPE_ERROR;
+    }
+    SSTD_t *trans = &sim_table[sstd_index];
+
+    sim_stats.transactions++;
+    sim_elapse_bits(SIM_HANDSHAKE_BITS);
+
+    // A slave on another speed reads garbage instead of the id
+    bool answered = sim_connected && sim_fallback[0] == sim_fallback[1] && sim_config.latency_us <= sim_config.timeout_us;
+    if (answered && sim_config.dropout_percent && sim_random() % 100 < sim_config.dropout_percent) {
+        answered = false;
+    }
+    if (!answered || !sim_send_tid(sstd_index)) {
+        sim_elapse(sim_config.timeout_us);
+        return sim_initiator_result(trans, TRANSACTION_NO_RESPONSE);
+    }
+    sim_elapse(sim_config.latency_us);
+
+    // Target send phase
+    if (trans->target2initiator_buffer_size > 0) {
+        if (!sim_send_packet(sim_t2i[sstd_index], trans->target2initiator_buffer, trans->target2initiator_buffer_size)) {
+            // The slave still waits for data that never comes
+            sim_status[sstd_index] = trans->initiator2target_buffer_size > 0 ? TRANSACTION_DATA_ERROR : TRANSACTION_ACCEPTED;
+            return sim_initiator_result(trans, TRANSACTION_DATA_ERROR);
+        }
+    }
+
+    // Target receive phase, the master can't tell whether it went through
+    sim_status[sstd_index] = TRANSACTION_ACCEPTED;
+    if (trans->initiator2target_buffer_size > 0) {
+        if (!sim_send_packet(trans->initiator2target_buffer, sim_i2t[sstd_index], trans->initiator2target_buffer_size)) {
+            sim_status[sstd_index] = TRANSACTION_DATA_ERROR;
+        }
+    }
+
+    return sim_initiator_result(trans, TRANSACTION_END);
+}
+
+int soft_serial_get_and_clean_status(int sstd_index) {
+    SSTD_t *trans  = &sim_table[sstd_index];
+    int     retval = *trans->status;
+    *trans->status = 0;
+    return retval;
+}
+
+#ifdef SELECT_SOFT_SERIAL_FALLBACK_SPEED
+void soft_serial_set_fallback(bool fallback) { sim_fallback[sim_in_slave] = fallback; }
+
+bool soft_serial_is_fallback(void) { return sim_fallback[sim_in_slave]; }
+#endif
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// /////////////////////////////////////////////////////////////////
+// Host simulation of the soft serial link
+//
+// Implements the serial.h API on top of a simulated wire, so that
+// transport.c runs unmodified in the native test build. Both halves live
+// in the same process and share the transaction table, so the sim keeps a
+// second copy of every transaction buffer: the master half uses the real
+// buffers, and serial_sim_run_slave() swaps the slave copy in while the
+// slave half runs. A transaction behaves like the target interrupt firing
+// on the slave half: it moves data between the master buffers and the
+// slave copy, through the wire.
+//
+// Everything is deterministic for a given config, including the seed of
+// the bit errors and dropouts. Time spent on the wire advances the test
+// timer.
+// /////////////////////////////////////////////////////////////////
+
+typedef struct _serial_sim_config_t {
+    // Time of a bit on the wire, at the main and at the fallback speed
+    uint16_t bit_time_us;
+    uint16_t fallback_bit_time_us;
+    // Delay before the slave acknowledges a transaction. The master gives
+    // up on a slave slower than timeout_us.
+    uint16_t latency_us;
+    uint16_t timeout_us;
+    // Probability that a bit gets flipped on the wire, in bits per million,
+    // at the main and at the fallback speed
+    uint32_t bit_error_ppm;
+    uint32_t fallback_bit_error_ppm;
+    // Percentage of transactions the slave misses entirely
+    uint8_t  dropout_percent;
+    uint32_t seed;
+} serial_sim_config_t;
+
+typedef struct _serial_sim_stats_t {
+    uint32_t transactions;
+    uint32_t no_response;
+    uint32_t data_errors;
+    // Data bytes carried by the wire, in both directions
+    uint32_t bytes;
+    uint32_t bit_errors;
+    // Corrupted bytes that passed the parity check
+    uint32_t undetected_errors;
+    uint32_t wire_time_us;
+} serial_sim_stats_t;
+
+// Defaults: about 137kbps, like SELECT_SOFT_SERIAL_SPEED 1, on a clean wire
+void serial_sim_init(const serial_sim_config_t *config);
+void serial_sim_get_default_config(serial_sim_config_t *config);
+void serial_sim_set_config(const serial_sim_config_t *config);
+
+// A disconnected slave never answers
+void serial_sim_set_connected(bool connected);
+
+// Runs the slave half code, e.g. transport_slave_init() or a scan calling
+// transport_slave(). Transactions must be registered on the master half
+// first, so that the sim knows which buffers belong to each half.
+void serial_sim_run_slave(void (*task)(void));
+
+const serial_sim_stats_t *serial_sim_get_stats(void);
+void                      serial_sim_clear_stats(void);
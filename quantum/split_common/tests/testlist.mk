@@ -0,0 +1,4 @@
+TEST_LIST +=\
+	split_common_transactions\
+	split_common_transport\
+	split_common_transport_delta
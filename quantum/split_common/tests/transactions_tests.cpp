@@ -0,0 +1,289 @@
+#include "gtest/gtest.h"
+#include <string.h>
+extern "C" {
+#include "split_common/transactions.h"
+void set_time(uint32_t t);
+void advance_time(uint32_t ms);
+}
+
+// Loopback stand-in for a transport: the slave half is a plain memory
+// region per transaction, and each transaction succeeds or fails as told
+static uint8_t slave_memory[SPLIT_TRANSACTIONS_MAX][64];
+static bool    slave_received[SPLIT_TRANSACTIONS_MAX];
+static uint8_t transact_status;
+static int     transact_count[SPLIT_TRANSACTIONS_MAX];
+
+static bool loopback_add(uint8_t id, const split_transaction_t* transaction) { return transaction->size <= sizeof(slave_memory[id]); }
+
+static uint8_t loopback_transact(uint8_t id, const split_transaction_t* transaction) {
+    transact_count[id]++;
+    if (transact_status != SPLIT_TRANSACTION_OK) {
+        return transact_status;
+    }
+    if (transaction->direction == SPLIT_MASTER_TO_SLAVE) {
+        memcpy(slave_memory[id], transaction->buffer, transaction->size);
+        slave_received[id] = true;
+    } else {
+        memcpy(transaction->buffer, slave_memory[id], transaction->size);
+    }
+    return SPLIT_TRANSACTION_OK;
+}
+
+static bool loopback_slave_sync(uint8_t id, const split_transaction_t* transaction) {
+    if (transaction->direction == SPLIT_SLAVE_TO_MASTER) {
+        memcpy(slave_memory[id], transaction->buffer, transaction->size);
+        return false;
+    }
+    if (!slave_received[id]) {
+        return false;
+    }
+    memcpy(transaction->buffer, slave_memory[id], transaction->size);
+    slave_received[id] = false;
+    return true;
+}
+
+static const split_transport_driver_t loopback_driver = {
+    .overhead_us  = 100,
+    .byte_time_us = 10,
+    .add          = loopback_add,
+    .transact     = loopback_transact,
+    .slave_sync   = loopback_slave_sync,
+};
+
+static bool always_dirty(void) { return true; }
+static bool never_dirty(void) { return false; }
+
+static bool dirty_once_flag;
+static bool dirty_once(void) {
+    bool dirty      = dirty_once_flag;
+    dirty_once_flag = false;
+    return dirty;
+}
+
+static int  received_count;
+static void count_received(void) { received_count++; }
+
+class SplitTransactions : public testing::Test {
+   public:
+    SplitTransactions() {
+        set_time(0);
+        memset(slave_memory, 0, sizeof(slave_memory));
+        memset(slave_received, 0, sizeof(slave_received));
+        memset(transact_count, 0, sizeof(transact_count));
+        transact_status = SPLIT_TRANSACTION_OK;
+        received_count  = 0;
+        dirty_once_flag = false;
+        split_transactions_init(&loopback_driver);
+    }
+};
+
+TEST_F(SplitTransactions, rejects_invalid_registrations) {
+    uint8_t             data[128];
+    split_transaction_t small = {data, 4, SPLIT_MASTER_TO_SLAVE};
+    split_transaction_t large = {data, sizeof(data), SPLIT_MASTER_TO_SLAVE};
+    EXPECT_FALSE(split_transaction_register(SPLIT_TRANSACTIONS_MAX, &small));
+    EXPECT_FALSE(split_transaction_register(SPLIT_TRANSACTION_USER, NULL));
+    EXPECT_FALSE(split_transaction_register(SPLIT_TRANSACTION_USER, &large));
+    EXPECT_TRUE(split_transaction_register(SPLIT_TRANSACTION_USER, &small));
+}
+
+TEST_F(SplitTransactions, does_not_run_unregistered_transaction) {
+    EXPECT_EQ(split_transaction_run(SPLIT_TRANSACTION_USER), SPLIT_TRANSACTION_NOT_REGISTERED);
+    EXPECT_EQ(transact_count[SPLIT_TRANSACTION_USER], 0);
+}
+
+TEST_F(SplitTransactions, reads_slave_data) {
+    uint8_t             data[4]     = {0};
+    split_transaction_t transaction = {data, sizeof(data), SPLIT_SLAVE_TO_MASTER, NULL, count_received};
+    split_transaction_register(SPLIT_TRANSACTION_USER, &transaction);
+    memcpy(slave_memory[SPLIT_TRANSACTION_USER], "\x01\x02\x03\x04", 4);
+    EXPECT_EQ(split_transaction_run(SPLIT_TRANSACTION_USER), SPLIT_TRANSACTION_OK);
+    EXPECT_EQ(memcmp(data, "\x01\x02\x03\x04", 4), 0);
+    EXPECT_EQ(received_count, 1);
+}
+
+TEST_F(SplitTransactions, does_not_call_received_on_failure) {
+    uint8_t             data[4]     = {0};
+    split_transaction_t transaction = {data, sizeof(data), SPLIT_SLAVE_TO_MASTER, NULL, count_received};
+    split_transaction_register(SPLIT_TRANSACTION_USER, &transaction);
+    transact_status = SPLIT_TRANSACTION_CHECKSUM_ERROR;
+    EXPECT_EQ(split_transaction_run(SPLIT_TRANSACTION_USER), SPLIT_TRANSACTION_CHECKSUM_ERROR);
+    EXPECT_EQ(received_count, 0);
+}
+
+TEST_F(SplitTransactions, schedules_only_dirty_transactions) {
+    uint8_t             data = 0;
+    split_transaction_t clean{&data, 1, SPLIT_MASTER_TO_SLAVE, never_dirty};
+    split_transaction_t dirty{&data, 1, SPLIT_MASTER_TO_SLAVE, always_dirty};
+    split_transaction_t manual{&data, 1, SPLIT_MASTER_TO_SLAVE, NULL};
+    split_transaction_register(SPLIT_TRANSACTION_USER, &clean);
+    split_transaction_register(SPLIT_TRANSACTION_USER + 1, &dirty);
+    split_transaction_register(SPLIT_TRANSACTION_USER + 2, &manual);
+    EXPECT_TRUE(split_transactions_master_task());
+    EXPECT_EQ(transact_count[SPLIT_TRANSACTION_USER], 0);
+    EXPECT_EQ(transact_count[SPLIT_TRANSACTION_USER + 1], 1);
+    EXPECT_EQ(transact_count[SPLIT_TRANSACTION_USER + 2], 0);
+}
+
+TEST_F(SplitTransactions, retries_dirty_transaction_until_it_succeeds) {
+    uint8_t             data = 0;
+    split_transaction_t transaction{&data, 1, SPLIT_MASTER_TO_SLAVE, dirty_once};
+    split_transaction_register(SPLIT_TRANSACTION_USER, &transaction);
+    dirty_once_flag = true;
+    transact_status = SPLIT_TRANSACTION_NAK;
+    EXPECT_FALSE(split_transactions_master_task());
+    EXPECT_FALSE(split_transactions_master_task());
+    transact_status = SPLIT_TRANSACTION_OK;
+    EXPECT_TRUE(split_transactions_master_task());
+    EXPECT_TRUE(split_transactions_master_task());
+    EXPECT_EQ(transact_count[SPLIT_TRANSACTION_USER], 2 * (1 + SPLIT_TRANSACTION_RETRIES) + 1);
+}
+
+TEST_F(SplitTransactions, cancels_a_failed_transaction) {
+    uint8_t             data = 0;
+    split_transaction_t transaction{&data, 1, SPLIT_MASTER_TO_SLAVE, dirty_once};
+    split_transaction_register(SPLIT_TRANSACTION_USER, &transaction);
+    dirty_once_flag = true;
+    transact_status = SPLIT_TRANSACTION_NAK;
+    EXPECT_FALSE(split_transactions_master_task());
+    split_transaction_cancel(SPLIT_TRANSACTION_USER);
+    transact_status = SPLIT_TRANSACTION_OK;
+    EXPECT_TRUE(split_transactions_master_task());
+    EXPECT_EQ(transact_count[SPLIT_TRANSACTION_USER], 1 + SPLIT_TRANSACTION_RETRIES);
+
+    // Until it is dirty again
+    dirty_once_flag = true;
+    EXPECT_TRUE(split_transactions_master_task());
+    EXPECT_EQ(transact_count[SPLIT_TRANSACTION_USER], 2 + SPLIT_TRANSACTION_RETRIES);
+}
+
+TEST_F(SplitTransactions, retries_failed_transaction_at_once) {
+    uint8_t             data = 0;
+    split_transaction_t transaction{&data, 1, SPLIT_SLAVE_TO_MASTER};
+    split_transaction_register(SPLIT_TRANSACTION_USER, &transaction);
+    transact_status = SPLIT_TRANSACTION_NAK;
+    EXPECT_EQ(split_transaction_run(SPLIT_TRANSACTION_USER), SPLIT_TRANSACTION_NAK);
+    EXPECT_EQ(transact_count[SPLIT_TRANSACTION_USER], 1 + SPLIT_TRANSACTION_RETRIES);
+}
+
+TEST_F(SplitTransactions, stops_retrying_and_scheduling_when_link_is_down) {
+    uint8_t             data = 0;
+    split_transaction_t probe{&data, 1, SPLIT_SLAVE_TO_MASTER};
+    split_transaction_t scheduled{&data, 1, SPLIT_MASTER_TO_SLAVE, always_dirty};
+    split_transaction_register(SPLIT_TRANSACTION_SLAVE_STATE, &probe);
+    split_transaction_register(SPLIT_TRANSACTION_USER, &scheduled);
+    transact_status = SPLIT_TRANSACTION_NAK;
+    for (int i = 0; i < SPLIT_LINK_DOWN_FAILURES; i++) {
+        split_transaction_run(SPLIT_TRANSACTION_SLAVE_STATE);
+    }
+    EXPECT_FALSE(split_link_is_up());
+    memset(transact_count, 0, sizeof(transact_count));
+    split_transaction_run(SPLIT_TRANSACTION_SLAVE_STATE);
+    EXPECT_FALSE(split_transactions_master_task());
+    EXPECT_EQ(transact_count[SPLIT_TRANSACTION_SLAVE_STATE], 1);
+    EXPECT_EQ(transact_count[SPLIT_TRANSACTION_USER], 0);
+
+    transact_status = SPLIT_TRANSACTION_OK;
+    split_transaction_run(SPLIT_TRANSACTION_SLAVE_STATE);
+    EXPECT_TRUE(split_link_is_up());
+    EXPECT_TRUE(split_transactions_master_task());
+    EXPECT_EQ(transact_count[SPLIT_TRANSACTION_USER], 1);
+}
+
+TEST_F(SplitTransactions, rate_limits_transactions) {
+    uint8_t             data = 0;
+    split_transaction_t transaction{&data, 1, SPLIT_MASTER_TO_SLAVE, always_dirty, NULL, 10};
+    split_transaction_register(SPLIT_TRANSACTION_USER, &transaction);
+    for (int i = 0; i < 25; i++) {
+        split_transactions_master_task();
+        advance_time(1);
+    }
+    EXPECT_EQ(transact_count[SPLIT_TRANSACTION_USER], 2);
+}
+
+TEST_F(SplitTransactions, shares_budget_round_robin) {
+    // Each of these costs more than half of the budget
+    static uint8_t      data[(SPLIT_TRANSACTION_BUDGET_US / 2) / 10];
+    split_transaction_t transaction{data, sizeof(data), SPLIT_MASTER_TO_SLAVE, always_dirty};
+    split_transaction_register(SPLIT_TRANSACTION_USER, &transaction);
+    split_transaction_register(SPLIT_TRANSACTION_USER + 1, &transaction);
+    split_transaction_register(SPLIT_TRANSACTION_USER + 2, &transaction);
+    split_transactions_master_task();
+    EXPECT_EQ(transact_count[SPLIT_TRANSACTION_USER], 1);
+    EXPECT_EQ(transact_count[SPLIT_TRANSACTION_USER + 1], 0);
+    split_transactions_master_task();
+    split_transactions_master_task();
+    EXPECT_EQ(transact_count[SPLIT_TRANSACTION_USER], 1);
+    EXPECT_EQ(transact_count[SPLIT_TRANSACTION_USER + 1], 1);
+    EXPECT_EQ(transact_count[SPLIT_TRANSACTION_USER + 2], 1);
+}
+
+TEST_F(SplitTransactions, runs_small_transactions_together) {
+    uint8_t             data = 0;
+    split_transaction_t transaction{&data, 1, SPLIT_MASTER_TO_SLAVE, always_dirty};
+    split_transaction_register(SPLIT_TRANSACTION_USER, &transaction);
+    split_transaction_register(SPLIT_TRANSACTION_USER + 1, &transaction);
+    split_transactions_master_task();
+    EXPECT_EQ(transact_count[SPLIT_TRANSACTION_USER], 1);
+    EXPECT_EQ(transact_count[SPLIT_TRANSACTION_USER + 1], 1);
+}
+
+TEST_F(SplitTransactions, slave_receives_master_data) {
+    uint8_t             data        = 0x42;
+    split_transaction_t transaction = {&data, 1, SPLIT_MASTER_TO_SLAVE, dirty_once, count_received};
+    split_transaction_register(SPLIT_TRANSACTION_USER, &transaction);
+    dirty_once_flag = true;
+    split_transactions_master_task();
+    data = 0;
+    split_transactions_slave_task();
+    EXPECT_EQ(data, 0x42);
+    EXPECT_EQ(received_count, 1);
+    split_transactions_slave_task();
+    EXPECT_EQ(received_count, 1);
+}
+
+TEST_F(SplitTransactions, slave_publishes_its_data) {
+    uint8_t             data        = 0x42;
+    split_transaction_t transaction = {&data, 1, SPLIT_SLAVE_TO_MASTER};
+    split_transaction_register(SPLIT_TRANSACTION_USER, &transaction);
+    split_transactions_slave_task();
+    EXPECT_EQ(slave_memory[SPLIT_TRANSACTION_USER][0], 0x42);
+}
+
+#ifdef SPLIT_TRANSACTION_STATS
+TEST_F(SplitTransactions, counts_results) {
+    uint8_t             data = 0;
+    split_transaction_t transaction{&data, 1, SPLIT_SLAVE_TO_MASTER};
+    split_transaction_register(SPLIT_TRANSACTION_USER, &transaction);
+    split_transaction_clear_stats();
+    split_transaction_run(SPLIT_TRANSACTION_USER);
+    transact_status = SPLIT_TRANSACTION_TIMEOUT;
+    split_transaction_run(SPLIT_TRANSACTION_USER);
+    transact_status = SPLIT_TRANSACTION_CHECKSUM_ERROR;
+    split_transaction_run(SPLIT_TRANSACTION_USER);
+    const split_transaction_stats_t* stats = split_transaction_get_stats(SPLIT_TRANSACTION_USER);
+    EXPECT_EQ(stats->success, 1);
+    EXPECT_EQ(stats->nak, 0);
+    EXPECT_EQ(stats->timeout, 1 + SPLIT_TRANSACTION_RETRIES);
+    EXPECT_EQ(stats->checksum_error, 1 + SPLIT_TRANSACTION_RETRIES);
+}
+
+TEST_F(SplitTransactions, measures_latency_from_first_failure) {
+    uint8_t             data = 0;
+    split_transaction_t transaction{&data, 1, SPLIT_SLAVE_TO_MASTER};
+    split_transaction_register(SPLIT_TRANSACTION_USER, &transaction);
+    split_transaction_clear_stats();
+    transact_status = SPLIT_TRANSACTION_NAK;
+    split_transaction_run(SPLIT_TRANSACTION_USER);
+    advance_time(3);
+    split_transaction_run(SPLIT_TRANSACTION_USER);
+    advance_time(4);
+    transact_status = SPLIT_TRANSACTION_OK;
+    split_transaction_run(SPLIT_TRANSACTION_USER);
+    EXPECT_EQ(split_transaction_get_stats(SPLIT_TRANSACTION_USER)->last_latency, 7);
+    advance_time(4);
+    split_transaction_run(SPLIT_TRANSACTION_USER);
+    EXPECT_EQ(split_transaction_get_stats(SPLIT_TRANSACTION_USER)->last_latency, 0);
+    EXPECT_EQ(split_transaction_get_stats(SPLIT_TRANSACTION_USER)->max_latency, 7);
+}
+#endif
@@ -0,0 +1,266 @@
+#include "gtest/gtest.h"
+#include <string.h>
+extern "C" {
+#include "split_common/transport.h"
+#include "split_common/transactions.h"
+#include "split_common/serial.h"
+#include "serial_sim.h"
+void set_time(uint32_t t);
+void advance_time(uint32_t ms);
+}
+
+#define ROWS_PER_HAND (MATRIX_ROWS / 2)
+
+static matrix_row_t master_matrix[ROWS_PER_HAND];
+static matrix_row_t slave_matrix[ROWS_PER_HAND];
+
+// Backlight of the master half, and what the slave half was told to show
+static uint8_t master_backlight_level;
+static uint8_t slave_backlight_level;
+static uint8_t slave_backlight_max;
+static int     slave_backlight_updates;
+// Disconnects the slave when the master reads the level to send
+static bool disconnect_on_backlight;
+
+extern "C" {
+bool    is_backlight_enabled(void) { return master_backlight_level > 0; }
+uint8_t get_backlight_level(void) {
+    if (disconnect_on_backlight) {
+        serial_sim_set_connected(false);
+    }
+    return master_backlight_level;
+}
+void backlight_set(uint8_t level) {
+    slave_backlight_level = level;
+    if (level > slave_backlight_max) {
+        slave_backlight_max = level;
+    }
+    slave_backlight_updates++;
+}
+}
+
+static void slave_scan(void) { transport_slave(slave_matrix); }
+
+class SplitTransport : public testing::Test {
+   public:
+    SplitTransport() { reset(); }
+
+    void reset() {
+        set_time(0);
+        serial_sim_init(NULL);
+        memset(master_matrix, 0, sizeof(master_matrix));
+        memset(slave_matrix, 0, sizeof(slave_matrix));
+        master_backlight_level = 0;
+        transport_master_init();
+        serial_sim_run_slave(transport_slave_init);
+
+        // Both halves share transport.c, so the master side may still hold
+        // the state of the previous test. A failed scan forces a full sync.
+        serial_sim_set_connected(false);
+        scan();
+        serial_sim_set_connected(true);
+        scan(2);
+        slave_backlight_updates = 0;
+        slave_backlight_max     = 0;
+        disconnect_on_backlight = false;
+        serial_sim_clear_stats();
+    }
+
+    // The slave publishes its state, then the master scans
+    bool scan() {
+        serial_sim_run_slave(slave_scan);
+        bool ok = transport_master(master_matrix);
+        advance_time(1);
+        return ok;
+    }
+
+    void scan(int count) {
+        for (int i = 0; i < count; i++) {
+            scan();
+        }
+    }
+
+    bool matrices_match() { return memcmp(master_matrix, slave_matrix, sizeof(master_matrix)) == 0; }
+
+    // Scans until the master sees the slave matrix, returns the scans it took
+    int scans_until_synced(int limit) {
+        for (int i = 1; i <= limit; i++) {
+            scan();
+            if (matrices_match()) {
+                return i;
+            }
+        }
+        return limit + 1;
+    }
+
+    serial_sim_stats_t noisy_run() {
+        set_config([](serial_sim_config_t *config) {
+            config->bit_error_ppm   = 2000;
+            config->dropout_percent = 5;
+            config->seed            = 1234;
+        });
+        for (int i = 0; i < 200; i++) {
+            if (i % 5 == 0) {
+                slave_matrix[i % ROWS_PER_HAND] ^= 1 << (i % MATRIX_COLS);
+            }
+            scan();
+        }
+        return *serial_sim_get_stats();
+    }
+
+    void set_config(void (*adjust)(serial_sim_config_t *config)) {
+        serial_sim_config_t config;
+        serial_sim_get_default_config(&config);
+        adjust(&config);
+        serial_sim_set_config(&config);
+    }
+};
+
+TEST_F(SplitTransport, master_reads_slave_matrix) {
+    slave_matrix[0] = 0x81;
+    slave_matrix[1] = 0x10;
+    EXPECT_TRUE(scan());
+    EXPECT_TRUE(matrices_match());
+}
+
+TEST_F(SplitTransport, slave_receives_backlight_level_once) {
+    master_backlight_level = 3;
+    scan(2);
+    EXPECT_EQ(slave_backlight_level, 3);
+    EXPECT_EQ(slave_backlight_updates, 1);
+    scan(10);
+    EXPECT_EQ(slave_backlight_updates, 1);
+}
+
+TEST_F(SplitTransport, idle_link_traffic) {
+    const uint32_t state_size = sizeof(matrix_row_t) * ROWS_PER_HAND;
+    scan(100);
+    const serial_sim_stats_t *stats = serial_sim_get_stats();
+#ifdef SPLIT_TRANSPORT_DELTA
+    // Only the sync sequence, and at most one periodic full transfer
+    EXPECT_LE(stats->bytes, 100 + state_size);
+#else
+    EXPECT_EQ(stats->transactions, 100u);
+    EXPECT_EQ(stats->bytes, 100 * state_size);
+#endif
+}
+
+TEST_F(SplitTransport, typing_reaches_master_on_next_scan) {
+    for (int i = 0; i < 50; i++) {
+        slave_matrix[i % ROWS_PER_HAND] ^= 1 << (i % MATRIX_COLS);
+        EXPECT_EQ(scans_until_synced(10), 1);
+    }
+}
+
+TEST_F(SplitTransport, slow_slave_times_out) {
+    set_config([](serial_sim_config_t *config) { config->latency_us = config->timeout_us + 1; });
+    slave_matrix[0] = 0x01;
+    EXPECT_FALSE(scan());
+    EXPECT_FALSE(matrices_match());
+    EXPECT_GT(serial_sim_get_stats()->no_response, 0u);
+}
+
+TEST_F(SplitTransport, link_goes_down_and_recovers) {
+    master_backlight_level = 1;
+    scan(2);
+    serial_sim_set_connected(false);
+    slave_matrix[1] = 0x20;
+    master_backlight_level = 4;
+    for (int i = 0; i < SPLIT_LINK_DOWN_FAILURES; i++) {
+        EXPECT_FALSE(scan());
+    }
+    EXPECT_FALSE(split_link_is_up());
+    EXPECT_EQ(slave_backlight_level, 1);
+
+    serial_sim_set_connected(true);
+    EXPECT_TRUE(scan());
+    EXPECT_TRUE(split_link_is_up());
+    EXPECT_TRUE(matrices_match());
+    scan();
+    EXPECT_EQ(slave_backlight_level, 4);
+}
+
+TEST_F(SplitTransport, resends_the_backlight_level_after_a_reset) {
+    // The link goes down while the level is sent
+    master_backlight_level  = 2;
+    disconnect_on_backlight = true;
+    scan();
+    disconnect_on_backlight = false;
+    EXPECT_FALSE(scan());
+
+    serial_sim_set_connected(true);
+    scan(2);
+    EXPECT_EQ(slave_backlight_level, 2);
+    EXPECT_EQ(slave_backlight_max, 2);
+}
+
+#ifdef SELECT_SOFT_SERIAL_FALLBACK_SPEED
+// Losing that many transactions also moves the halves to the fallback
+// speed, which takes a few hundred scans
+#    define DROPOUT_SYNC_SCANS 500
+#else
+#    define DROPOUT_SYNC_SCANS 20
+#endif
+
+TEST_F(SplitTransport, survives_dropouts) {
+    set_config([](serial_sim_config_t *config) { config->dropout_percent = 30; });
+    for (int i = 0; i < 50; i++) {
+        slave_matrix[i % ROWS_PER_HAND] ^= 1 << (i % MATRIX_COLS);
+        EXPECT_LE(scans_until_synced(DROPOUT_SYNC_SCANS), DROPOUT_SYNC_SCANS);
+    }
+    EXPECT_GT(serial_sim_get_stats()->no_response, 0u);
+}
+
+TEST_F(SplitTransport, recovers_from_bit_errors) {
+    set_config([](serial_sim_config_t *config) { config->bit_error_ppm = 5000; });
+    for (int i = 0; i < 500; i++) {
+        if (i % 10 == 0) {
+            slave_matrix[(i / 10) % ROWS_PER_HAND] ^= 1 << (i % MATRIX_COLS);
+        }
+        scan();
+    }
+    const serial_sim_stats_t *stats = serial_sim_get_stats();
+    EXPECT_GT(stats->bit_errors, 0u);
+    EXPECT_GT(stats->data_errors, 0u);
+
+    // Corruption which slipped past the parity check is repaired by the
+    // next transfer, at the latest by the periodic full sync
+    set_config([](serial_sim_config_t *config) {});
+    EXPECT_LE(scans_until_synced(300), 300);
+}
+
+TEST_F(SplitTransport, runs_are_deterministic) {
+    serial_sim_stats_t first = noisy_run();
+    reset();
+    serial_sim_stats_t second = noisy_run();
+    EXPECT_EQ(memcmp(&first, &second, sizeof(serial_sim_stats_t)), 0);
+    EXPECT_GT(first.transactions, 0u);
+}
+
+#ifdef SELECT_SOFT_SERIAL_FALLBACK_SPEED
+static bool slave_fallback;
+static void read_slave_fallback(void) { slave_fallback = soft_serial_is_fallback(); }
+
+TEST_F(SplitTransport, switches_to_fallback_speed_on_a_noisy_link) {
+    set_config([](serial_sim_config_t *config) { config->bit_error_ppm = 20000; });
+    scan(2000);
+    serial_sim_run_slave(read_slave_fallback);
+    EXPECT_TRUE(soft_serial_is_fallback());
+    EXPECT_TRUE(slave_fallback);
+
+    // The fallback speed is clean
+    serial_sim_clear_stats();
+    slave_matrix[0] = 0x42;
+    EXPECT_EQ(scans_until_synced(10), 1);
+    EXPECT_EQ(serial_sim_get_stats()->bit_errors, 0u);
+}
+
+TEST_F(SplitTransport, halves_agree_on_a_speed_after_a_reset) {
+    // The slave restarts at the main speed while the master is on the
+    // fallback speed
+    soft_serial_set_fallback(true);
+    slave_matrix[0] = 0x42;
+    EXPECT_LE(scans_until_synced(1000), 1000);
+    EXPECT_TRUE(split_link_is_up());
+}
+#endif
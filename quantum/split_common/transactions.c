@@ -0,0 +1,211 @@
+#include <stddef.h>
+#include <string.h>
+
+#include "transactions.h"
+#include "timer.h"
+
+typedef struct _split_transaction_entry_t {
+    const split_transaction_t *transaction;
+    uint16_t                   last_run;
+    bool                       pending;
+#ifdef SPLIT_TRANSACTION_STATS
+    bool                      due;
+    uint16_t                  due_since;
+    split_transaction_stats_t stats;
+#endif
+} split_transaction_entry_t;
+
+static const split_transport_driver_t *transport_driver = NULL;
+static split_transaction_entry_t       transaction_table[SPLIT_TRANSACTIONS_MAX];
+static uint8_t                         next_scheduled       = 0;
+static uint8_t                         consecutive_failures = 0;
+
+#ifdef SPLIT_TRANSACTION_STATS
+static void stats_increment(uint16_t *counter) {
+    if (*counter < UINT16_MAX) {
+        (*counter)++;
+    }
+}
+
+static void stats_mark_due(split_transaction_entry_t *entry) {
+    if (!entry->due) {
+        entry->due       = true;
+        entry->due_since = timer_read();
+    }
+}
+
+static void stats_record(split_transaction_entry_t *entry, uint8_t status) {
+    split_transaction_stats_t *stats = &entry->stats;
+    switch (status) {
+        case SPLIT_TRANSACTION_OK:
+            stats_increment(&stats->success);
+            stats->last_latency = entry->due ? timer_elapsed(entry->due_since) : 0;
+            if (stats->last_latency > stats->max_latency) {
+                stats->max_latency = stats->last_latency;
+            }
+            entry->due = false;
+            break;
+        case SPLIT_TRANSACTION_NAK:
+            stats_increment(&stats->nak);
+            stats_mark_due(entry);
+            break;
+        case SPLIT_TRANSACTION_TIMEOUT:
+            stats_increment(&stats->timeout);
+            stats_mark_due(entry);
+            break;
+        case SPLIT_TRANSACTION_CHECKSUM_ERROR:
+            stats_increment(&stats->checksum_error);
+            stats_mark_due(entry);
+            break;
+    }
+}
+
+const split_transaction_stats_t *split_transaction_get_stats(uint8_t id) {
+    if (id >= SPLIT_TRANSACTIONS_MAX) {
+        return NULL;
+    }
+    return &transaction_table[id].stats;
+}
+
+void split_transaction_clear_stats(void) {
+    for (uint8_t id = 0; id < SPLIT_TRANSACTIONS_MAX; id++) {
+        memset(&transaction_table[id].stats, 0, sizeof(split_transaction_stats_t));
+    }
+}
+#else
+#    define stats_mark_due(entry)
+#    define stats_record(entry, status)
+#endif
+
+void split_transactions_init(const split_transport_driver_t *driver) {
+    transport_driver     = driver;
+    next_scheduled       = 0;
+    consecutive_failures = 0;
+    memset(transaction_table, 0, sizeof(transaction_table));
+}
+
+bool split_transaction_register(uint8_t id, const split_transaction_t *transaction) {
+    if (id >= SPLIT_TRANSACTIONS_MAX || transaction == NULL) {
+        return false;
+    }
+    if (transport_driver && transport_driver->add && !transport_driver->add(id, transaction)) {
+        return false;
+    }
+    transaction_table[id].transaction = transaction;
+    transaction_table[id].last_run    = timer_read();
+    transaction_table[id].pending     = false;
+    return true;
+}
+
+uint8_t split_transaction_run(uint8_t id) {
+    if (id >= SPLIT_TRANSACTIONS_MAX || transaction_table[id].transaction == NULL || transport_driver == NULL) {
+        return SPLIT_TRANSACTION_NOT_REGISTERED;
+    }
+
+    split_transaction_entry_t *entry       = &transaction_table[id];
+    const split_transaction_t *transaction = entry->transaction;
+
+    uint8_t status = transport_driver->transact(id, transaction);
+    stats_record(entry, status);
+
+    // A failure on a healthy link is most likely a glitch, so try again at
+    // once. Once the link looks down, don't spend the scan on retries.
+    for (uint8_t retry = 0; status != SPLIT_TRANSACTION_OK && retry < SPLIT_TRANSACTION_RETRIES && consecutive_failures < SPLIT_LINK_DOWN_FAILURES; retry++) {
+        consecutive_failures++;
+        status = transport_driver->transact(id, transaction);
+        stats_record(entry, status);
+    }
+
+    if (status != SPLIT_TRANSACTION_OK) {
+        if (consecutive_failures < UINT8_MAX) {
+            consecutive_failures++;
+        }
+        return status;
+    }
+
+    consecutive_failures = 0;
+    entry->last_run      = timer_read();
+    entry->pending       = false;
+    if (transaction->direction == SPLIT_SLAVE_TO_MASTER && transaction->received) {
+        transaction->received();
+    }
+    return status;
+}
+
+void split_transaction_cancel(uint8_t id) {
+    if (id < SPLIT_TRANSACTIONS_MAX) {
+        transaction_table[id].pending = false;
+    }
+}
+
+bool split_link_is_up(void) { return consecutive_failures < SPLIT_LINK_DOWN_FAILURES; }
+
+static uint16_t transaction_cost(const split_transaction_t *transaction) { return transport_driver->overhead_us + transaction->size * transport_driver->byte_time_us; }
+
+bool split_transactions_master_task(void) {
+    // Only explicitly run transactions probe a link which is down
+    if (transport_driver == NULL || !split_link_is_up()) {
+        return false;
+    }
+
+    bool     success = true;
+    uint16_t spent   = 0;
+    uint8_t  id      = next_scheduled;
+
+    for (uint8_t i = 0; i < SPLIT_TRANSACTIONS_MAX; i++, id = (id + 1) % SPLIT_TRANSACTIONS_MAX) {
+        split_transaction_entry_t *entry       = &transaction_table[id];
+        const split_transaction_t *transaction = entry->transaction;
+
+        if (transaction == NULL || transaction->is_dirty == NULL) {
+            continue;
+        }
+        if (transaction->min_interval && timer_elapsed(entry->last_run) < transaction->min_interval) {
+            continue;
+        }
+        if (!entry->pending) {
+            entry->pending = transaction->is_dirty();
+            if (!entry->pending) {
+                continue;
+            }
+            stats_mark_due(entry);
+        }
+
+        // Always let at least one transaction through, so that one larger
+        // than the budget can't starve
+        uint16_t cost = transaction_cost(transaction);
+        if (spent > 0 && spent + cost > SPLIT_TRANSACTION_BUDGET_US) {
+            // Out of time, continue from here on the next scan
+            next_scheduled = id;
+            return success;
+        }
+        spent += cost;
+
+        if (split_transaction_run(id) != SPLIT_TRANSACTION_OK) {
+            success = false;
+            if (!split_link_is_up()) {
+                next_scheduled = id;
+                return success;
+            }
+        }
+    }
+
+    return success;
+}
+
+void split_transactions_slave_task(void) {
+    if (transport_driver == NULL) {
+        return;
+    }
+
+    // Transactions are handled in id order, so a transaction can be used to
+    // announce updates of transactions with lower ids
+    for (uint8_t id = 0; id < SPLIT_TRANSACTIONS_MAX; id++) {
+        const split_transaction_t *transaction = transaction_table[id].transaction;
+        if (transaction == NULL) {
+            continue;
+        }
+        if (transport_driver->slave_sync(id, transaction) && transaction->direction == SPLIT_MASTER_TO_SLAVE && transaction->received) {
+            transaction->received();
+        }
+    }
+}
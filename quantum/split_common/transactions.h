@@ -0,0 +1,130 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// /////////////////////////////////////////////////////////////////
+// Split transaction registry
+//
+// Every piece of data exchanged between the two halves is declared as a
+// transaction: a buffer of a fixed size that travels in one direction.
+// Both halves must register the same transactions with the same ids.
+// The master runs them through the transport driver, round-robin and
+// within a time budget per scan, while the slave hands them over to (or
+// receives them from) the transport in split_transactions_slave_task().
+// /////////////////////////////////////////////////////////////////
+
+// The serial transport encodes transaction ids on 4 bits
+#ifndef SPLIT_TRANSACTIONS_MAX
+#    define SPLIT_TRANSACTIONS_MAX 16
+#endif
+
+// Estimated time on the wire the scheduled transactions may take per scan
+#ifndef SPLIT_TRANSACTION_BUDGET_US
+#    define SPLIT_TRANSACTION_BUDGET_US 1000
+#endif
+
+// Immediate retries of a failed transaction, while the link looks healthy
+#ifndef SPLIT_TRANSACTION_RETRIES
+#    define SPLIT_TRANSACTION_RETRIES 1
+#endif
+
+// Failures in a row after which the link is considered down: failed
+// transactions are no longer retried and scheduled transactions wait
+// until an explicitly run one goes through again
+#ifndef SPLIT_LINK_DOWN_FAILURES
+#    define SPLIT_LINK_DOWN_FAILURES 5
+#endif
+
+// Transactions used by split_common itself. Keyboards and keymaps can use
+// ids from SPLIT_TRANSACTION_USER up to SPLIT_TRANSACTIONS_MAX - 1.
+enum split_transaction_id {
+    SPLIT_TRANSACTION_SLAVE_STATE = 0,
+    SPLIT_TRANSACTION_SYNC,
+    SPLIT_TRANSACTION_BACKLIGHT,
+    SPLIT_TRANSACTION_RGBLIGHT,
+    SPLIT_TRANSACTION_USER,
+};
+
+typedef enum {
+    SPLIT_MASTER_TO_SLAVE = 0,
+    SPLIT_SLAVE_TO_MASTER,
+} split_direction_t;
+
+// Result of a transaction, as seen from the master
+enum split_transaction_status {
+    SPLIT_TRANSACTION_OK = 0,
+    SPLIT_TRANSACTION_NAK,             // the slave did not answer
+    SPLIT_TRANSACTION_TIMEOUT,         // the slave stopped answering in the middle of the transfer
+    SPLIT_TRANSACTION_CHECKSUM_ERROR,  // the data was corrupted on the wire
+    SPLIT_TRANSACTION_NOT_REGISTERED,
+};
+
+typedef struct _split_transaction_t {
+    void *            buffer;
+    uint8_t           size;
+    split_direction_t direction;
+    // Master only: returns true when the transaction should run. Once it
+    // returned true, the transaction is retried until it succeeds.
+    // NULL means the transaction is never scheduled automatically and only
+    // runs through split_transaction_run().
+    bool (*is_dirty)(void);
+    // Called on the receiving half once new data landed in buffer
+    void (*received)(void);
+    // Minimum time between two runs of the transaction, in milliseconds
+    uint16_t min_interval;
+} split_transaction_t;
+
+// Implemented by each transport (serial, I2C, ...)
+typedef struct _split_transport_driver_t {
+    // Estimated cost of a transaction on the wire, used for the time budget
+    uint16_t overhead_us;
+    uint16_t byte_time_us;
+    // Called when a transaction is registered, returns false if the
+    // transport has no room for it
+    bool (*add)(uint8_t id, const split_transaction_t *transaction);
+    // Master: performs the transaction, returns a split_transaction_status
+    uint8_t (*transact)(uint8_t id, const split_transaction_t *transaction);
+    // Slave: publishes slave to master data, and returns true when new
+    // master to slave data was copied to the buffer
+    bool (*slave_sync)(uint8_t id, const split_transaction_t *transaction);
+} split_transport_driver_t;
+
+#ifdef SPLIT_TRANSACTION_STATS
+// Counters are saturating, latency is the time in milliseconds between a
+// transaction becoming due (dirty, or failing) and its successful run
+typedef struct _split_transaction_stats_t {
+    uint16_t success;
+    uint16_t nak;
+    uint16_t timeout;
+    uint16_t checksum_error;
+    uint16_t last_latency;
+    uint16_t max_latency;
+} split_transaction_stats_t;
+
+const split_transaction_stats_t *split_transaction_get_stats(uint8_t id);
+void                             split_transaction_clear_stats(void);
+#endif
+
+void split_transactions_init(const split_transport_driver_t *driver);
+
+// Both halves must register a transaction before it is used. The
+// transaction descriptor must stay valid as long as it is registered.
+bool split_transaction_register(uint8_t id, const split_transaction_t *transaction);
+
+// Master: runs a transaction immediately, bypassing the scheduler
+uint8_t split_transaction_run(uint8_t id);
+
+// Master: drops a failed or deferred run of the transaction, is_dirty() is
+// asked again on the next scan
+void split_transaction_cancel(uint8_t id);
+
+// Master: false once SPLIT_LINK_DOWN_FAILURES transactions failed in a row
+bool split_link_is_up(void);
+
+// Master: runs the pending transactions that fit in the time budget,
+// returns false if any of them failed
+bool split_transactions_master_task(void);
+
+// Slave: exchanges the registered buffers with the transport
+void split_transactions_slave_task(void);
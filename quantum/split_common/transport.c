@@ -4,6 +4,8 @@
 #include "config.h"
 #include "matrix.h"
 #include "quantum.h"
+#include "debug.h"
+#include "transactions.h"
 
 #define ROWS_PER_HAND (MATRIX_ROWS / 2)
 
@@ -21,28 +23,131 @@ static pin_t encoders_pad[] = ENCODERS_PAD_A;
 #    define NUMBER_OF_ENCODERS (sizeof(encoders_pad) / sizeof(pin_t))
 #endif
 
-#if defined(USE_I2C) || defined(EH)
-
-#    include "i2c_master.h"
-#    include "i2c_slave.h"
-
-typedef struct _I2C_slave_buffer_t {
+// State of the slave half, sent to the master
+typedef struct _split_slave_state_t {
+    // TODO: if MATRIX_COLS > 8 change to uint8_t packed_matrix[] for pack/unpack
     matrix_row_t smatrix[ROWS_PER_HAND];
-    uint8_t      backlight_level;
-#    if defined(RGBLIGHT_ENABLE) && defined(RGBLIGHT_SPLIT)
-    rgblight_syncinfo_t rgblight_sync;
-#    endif
-#    ifdef ENCODER_ENABLE
+#ifdef ENCODER_ENABLE
     uint8_t encoder_state[NUMBER_OF_ENCODERS];
+#endif
+} split_slave_state_t;
+
+static volatile split_slave_state_t slave_state = {};
+
+static const split_transaction_t slave_state_transaction = {
+    .buffer    = (void *)&slave_state,
+    .size      = sizeof(slave_state),
+    .direction = SPLIT_SLAVE_TO_MASTER,
+};
+
+#ifdef SPLIT_TRANSPORT_DELTA
+// The slave bumps its sync sequence every time the matrix or encoder state
+// it publishes changes, so the master only has to poll a single byte and
+// can skip the full transfer while nothing happens on the other half.
+// A full transfer is still forced every SPLIT_FULL_SYNC_INTERVAL ms, and
+// after any failed transaction, to recover from lost or corrupted updates.
+#    ifndef SPLIT_FULL_SYNC_INTERVAL
+#        define SPLIT_FULL_SYNC_INTERVAL 250
 #    endif
-} I2C_slave_buffer_t;
 
-static I2C_slave_buffer_t *const i2c_buffer = (I2C_slave_buffer_t *)i2c_slave_reg;
+static volatile uint8_t slave_sync_sequence = 0;
+static uint8_t          last_sync_sequence;
+static uint16_t         last_full_sync;
+static bool             full_sync_required = true;
+
+// Must have a higher id than the slave state, so that the slave publishes
+// the new sequence only once the data it describes is in place
+static const split_transaction_t sync_transaction = {
+    .buffer    = (void *)&slave_sync_sequence,
+    .size      = sizeof(slave_sync_sequence),
+    .direction = SPLIT_SLAVE_TO_MASTER,
+};
+
+static bool transport_sync_required(uint8_t sequence) {
+    if (full_sync_required || sequence != last_sync_sequence || timer_elapsed(last_full_sync) > SPLIT_FULL_SYNC_INTERVAL) {
+        return true;
+    }
+    return false;
+}
+
+static void transport_sync_done(uint8_t sequence) {
+    last_sync_sequence = sequence;
+    last_full_sync     = timer_read();
+    full_sync_required = false;
+}
+#endif
+
+#ifdef BACKLIGHT_ENABLE
+static uint8_t split_backlight_level;
+// Sends the level even if it didn't change, for the first level and when
+// the slave may have been reset
+static bool split_backlight_resend = true;
+
+static bool backlight_is_dirty(void) {
+    uint8_t level = is_backlight_enabled() ? get_backlight_level() : 0;
+    if (level == split_backlight_level && !split_backlight_resend) {
+        return false;
+    }
+    split_backlight_level  = level;
+    split_backlight_resend = false;
+    return true;
+}
+
+static void backlight_received(void) { backlight_set(split_backlight_level); }
+
+static const split_transaction_t backlight_transaction = {
+    .buffer    = &split_backlight_level,
+    .size      = sizeof(split_backlight_level),
+    .direction = SPLIT_MASTER_TO_SLAVE,
+    .is_dirty  = backlight_is_dirty,
+    .received  = backlight_received,
+};
+#endif
+
+#if defined(RGBLIGHT_ENABLE) && defined(RGBLIGHT_SPLIT)
+// When MCUs on both sides drive their respective RGB LED chains,
+// it is necessary to synchronize, so it is necessary to communicate RGB
+// information. In that case, define RGBLIGHT_SPLIT with info on the number
+// of LEDs on each half.
+//
+// Otherwise, if the master side MCU drives both sides RGB LED chains,
+// there is no need to communicate.
+static rgblight_syncinfo_t rgblight_sync;
+
+static bool rgblight_is_dirty(void) {
+    if (!rgblight_get_change_flags()) {
+        return false;
+    }
+    rgblight_get_syncinfo(&rgblight_sync);
+    rgblight_clear_change_flags();
+    return true;
+}
+
+static void rgblight_received(void) {
+    if (rgblight_sync.status.change_flags != 0) {
+        rgblight_update_sync(&rgblight_sync, false);
+    }
+}
+
+static const split_transaction_t rgblight_transaction = {
+    .buffer    = &rgblight_sync,
+    .size      = sizeof(rgblight_sync),
+    .direction = SPLIT_MASTER_TO_SLAVE,
+    .is_dirty  = rgblight_is_dirty,
+    .received  = rgblight_received,
+};
+#endif
 
-#    define I2C_BACKLIGHT_START offsetof(I2C_slave_buffer_t, backlight_level)
-#    define I2C_RGB_START offsetof(I2C_slave_buffer_t, rgblight_sync)
-#    define I2C_KEYMAP_START offsetof(I2C_slave_buffer_t, smatrix)
-#    define I2C_ENCODER_START offsetof(I2C_slave_buffer_t, encoder_state)
+#if defined(USE_I2C) || defined(EH)
+
+#    include "i2c_master.h"
+#    include "i2c_slave.h"
+
+// Each transaction gets its own region of the slave registers, in id order.
+// Master to slave regions are followed by a counter, written last by the
+// master, which tells the slave that a complete update arrived.
+static uint8_t i2c_region_size[SPLIT_TRANSACTIONS_MAX];
+static uint8_t i2c_update_counter[SPLIT_TRANSACTIONS_MAX];
 
 #    define TIMEOUT 100
 
@@ -50,200 +155,399 @@ static I2C_slave_buffer_t *const i2c_buffer = (I2C_slave_buffer_t *)i2c_slave_re
 #        define SLAVE_I2C_ADDRESS 0x32
 #    endif
 
-// Get rows from other half over i2c
-bool transport_master(matrix_row_t matrix[]) {
-    i2c_readReg(SLAVE_I2C_ADDRESS, I2C_KEYMAP_START, (void *)matrix, sizeof(i2c_buffer->smatrix), TIMEOUT);
-
-    // write backlight info
+// The built-in transactions always fit, keyboards' own ones are checked
+// when they are registered
+#    define I2C_REGION_SLAVE_STATE sizeof(slave_state)
+#    ifdef SPLIT_TRANSPORT_DELTA
+#        define I2C_REGION_SYNC sizeof(slave_sync_sequence)
+#    else
+#        define I2C_REGION_SYNC 0
+#    endif
 #    ifdef BACKLIGHT_ENABLE
-    uint8_t level = is_backlight_enabled() ? get_backlight_level() : 0;
-    if (level != i2c_buffer->backlight_level) {
-        if (i2c_writeReg(SLAVE_I2C_ADDRESS, I2C_BACKLIGHT_START, (void *)&level, sizeof(level), TIMEOUT) >= 0) {
-            i2c_buffer->backlight_level = level;
-        }
-    }
+#        define I2C_REGION_BACKLIGHT (sizeof(split_backlight_level) + 1)
+#    else
+#        define I2C_REGION_BACKLIGHT 0
 #    endif
-
 #    if defined(RGBLIGHT_ENABLE) && defined(RGBLIGHT_SPLIT)
-    if (rgblight_get_change_flags()) {
-        rgblight_syncinfo_t rgblight_sync;
-        rgblight_get_syncinfo(&rgblight_sync);
-        if (i2c_writeReg(SLAVE_I2C_ADDRESS, I2C_RGB_START, (void *)&rgblight_sync, sizeof(rgblight_sync), TIMEOUT) >= 0) {
-            rgblight_clear_change_flags();
-        }
-    }
+#        define I2C_REGION_RGBLIGHT (sizeof(rgblight_sync) + 1)
+#    else
+#        define I2C_REGION_RGBLIGHT 0
 #    endif
+_Static_assert(I2C_REGION_SLAVE_STATE + I2C_REGION_SYNC + I2C_REGION_BACKLIGHT + I2C_REGION_RGBLIGHT <= I2C_SLAVE_REG_COUNT, "The split transactions don't fit into I2C_SLAVE_REG_COUNT");
 
-#    ifdef ENCODER_ENABLE
-    i2c_readReg(SLAVE_I2C_ADDRESS, I2C_ENCODER_START, (void *)i2c_buffer->encoder_state, sizeof(i2c_buffer->encoder_state), TIMEOUT);
-    encoder_update_raw(i2c_buffer->encoder_state);
-#    endif
+static uint8_t i2c_region_start(uint8_t id) {
+    uint8_t start = 0;
+    for (uint8_t i = 0; i < id; i++) {
+        start += i2c_region_size[i];
+    }
+    return start;
+}
 
+static bool i2c_transaction_add(uint8_t id, const split_transaction_t *transaction) {
+    uint8_t region_size = transaction->size + (transaction->direction == SPLIT_MASTER_TO_SLAVE ? 1 : 0);
+    uint8_t total       = region_size;
+    for (uint8_t i = 0; i < SPLIT_TRANSACTIONS_MAX; i++) {
+        if (i != id) {
+            total += i2c_region_size[i];
+        }
+    }
+    if (total > I2C_SLAVE_REG_COUNT) {
+        return false;
+    }
+    i2c_region_size[id] = region_size;
     return true;
 }
 
-void transport_slave(matrix_row_t matrix[]) {
-    // Copy matrix to I2C buffer
-    memcpy((void *)i2c_buffer->smatrix, (void *)matrix, sizeof(i2c_buffer->smatrix));
+static uint8_t i2c_status_to_transaction(i2c_status_t status) {
+    switch (status) {
+        case I2C_STATUS_SUCCESS:
+            return SPLIT_TRANSACTION_OK;
+        case I2C_STATUS_TIMEOUT:
+            return SPLIT_TRANSACTION_TIMEOUT;
+        default:
+            return SPLIT_TRANSACTION_NAK;
+    }
+}
 
-// Read Backlight Info
-#    ifdef BACKLIGHT_ENABLE
-    backlight_set(i2c_buffer->backlight_level);
-#    endif
+static uint8_t i2c_transaction_transact(uint8_t id, const split_transaction_t *transaction) {
+    uint8_t start = i2c_region_start(id);
 
-#    if defined(RGBLIGHT_ENABLE) && defined(RGBLIGHT_SPLIT)
-    // Update the RGB with the new data
-    if (i2c_buffer->rgblight_sync.status.change_flags != 0) {
-        rgblight_update_sync(&i2c_buffer->rgblight_sync, false);
-        i2c_buffer->rgblight_sync.status.change_flags = 0;
+    if (transaction->direction == SPLIT_SLAVE_TO_MASTER) {
+        return i2c_status_to_transaction(i2c_readReg(SLAVE_I2C_ADDRESS, start, transaction->buffer, transaction->size, TIMEOUT));
     }
-#    endif
 
-#    ifdef ENCODER_ENABLE
-    encoder_state_raw(i2c_buffer->encoder_state);
-#    endif
+    // The counter changes on every attempt, so that a retry is never
+    // mistaken for an update the slave already received
+    uint8_t data[I2C_SLAVE_REG_COUNT];
+    memcpy(data, transaction->buffer, transaction->size);
+    data[transaction->size] = ++i2c_update_counter[id];
+    return i2c_status_to_transaction(i2c_writeReg(SLAVE_I2C_ADDRESS, start, data, transaction->size + 1, TIMEOUT));
+}
+
+static bool i2c_transaction_slave_sync(uint8_t id, const split_transaction_t *transaction) {
+    volatile uint8_t *region = &i2c_slave_reg[i2c_region_start(id)];
+
+    if (transaction->direction == SPLIT_SLAVE_TO_MASTER) {
+        memcpy((void *)region, transaction->buffer, transaction->size);
+        return false;
+    }
+
+    uint8_t counter = region[transaction->size];
+    if (counter == i2c_update_counter[id]) {
+        return false;
+    }
+    memcpy(transaction->buffer, (void *)region, transaction->size);
+    i2c_update_counter[id] = counter;
+    return true;
 }
 
-void transport_master_init(void) { i2c_init(); }
+// Rough cost at 100kHz: address and register bytes, and 9 bits per byte
+static const split_transport_driver_t transport_driver = {
+    .overhead_us  = 300,
+    .byte_time_us = 90,
+    .add          = i2c_transaction_add,
+    .transact     = i2c_transaction_transact,
+    .slave_sync   = i2c_transaction_slave_sync,
+};
+
+static void transport_driver_master_init(void) { i2c_init(); }
 
-void transport_slave_init(void) { i2c_slave_init(SLAVE_I2C_ADDRESS); }
+static void transport_driver_slave_init(void) { i2c_slave_init(SLAVE_I2C_ADDRESS); }
+
+static void transport_driver_slave_task(void) {}
 
 #else  // USE_SERIAL
 
 #    include "serial.h"
 
-typedef struct _Serial_s2m_buffer_t {
-    // TODO: if MATRIX_COLS > 8 change to uint8_t packed_matrix[] for pack/unpack
-    matrix_row_t smatrix[ROWS_PER_HAND];
+// Transaction descriptors of the soft serial driver, filled in as
+// transactions get registered. Unregistered ids transfer nothing.
+static SSTD_t           serial_transactions[SPLIT_TRANSACTIONS_MAX];
+static volatile uint8_t serial_status[SPLIT_TRANSACTIONS_MAX];
+
+static bool serial_transaction_add(uint8_t id, const split_transaction_t *transaction) {
+    SSTD_t *trans = &serial_transactions[id];
+    if (transaction->direction == SPLIT_MASTER_TO_SLAVE) {
+        trans->initiator2target_buffer_size = transaction->size;
+        trans->initiator2target_buffer      = transaction->buffer;
+        trans->target2initiator_buffer_size = 0;
+        trans->target2initiator_buffer      = NULL;
+    } else {
+        trans->initiator2target_buffer_size = 0;
+        trans->initiator2target_buffer      = NULL;
+        trans->target2initiator_buffer_size = transaction->size;
+        trans->target2initiator_buffer      = transaction->buffer;
+    }
+    return true;
+}
 
-#    ifdef ENCODER_ENABLE
-    uint8_t      encoder_state[NUMBER_OF_ENCODERS];
-#    endif
+#    ifdef SELECT_SOFT_SERIAL_FALLBACK_SPEED
+// The halves can't agree on a speed change over a link which doesn't work,
+// so each of them hunts for a working speed on its own: the master switches
+// after SERIAL_FALLBACK_FAILURES failures in a row, the slave after
+// SERIAL_FALLBACK_TIMEOUT ms without any transaction. The slave waits much
+// longer, so the master tries both speeds while the slave stays on one.
+// A link which works but loses too many transactions at the main speed
+// switches to the fallback speed for good.
+#        ifndef SERIAL_FALLBACK_FAILURES
+#            define SERIAL_FALLBACK_FAILURES 10
+#        endif
+#        ifndef SERIAL_FALLBACK_TIMEOUT
+#            define SERIAL_FALLBACK_TIMEOUT 200
+#        endif
+// Each failure weighs this many successes, so the fallback kicks in above
+// a failure rate of about 1 / (SERIAL_FALLBACK_ERROR_WEIGHT + 1)
+#        ifndef SERIAL_FALLBACK_ERROR_WEIGHT
+#            define SERIAL_FALLBACK_ERROR_WEIGHT 16
+#        endif
+#        define SERIAL_FALLBACK_ERROR_LIMIT 128
+
+static uint8_t  serial_failures;
+static uint8_t  serial_error_score;
+static uint16_t serial_last_activity;
+static bool     serial_fallback_hold;
+static uint16_t serial_fallback_hold_start;
+
+static void serial_fallback_switch(bool fallback) {
+    soft_serial_set_fallback(fallback);
+    serial_failures      = 0;
+    serial_error_score   = 0;
+    serial_fallback_hold = false;
+}
 
-} Serial_s2m_buffer_t;
+static void serial_fallback_init(void) {
+    serial_fallback_switch(false);
+    serial_last_activity = timer_read();
+}
 
-typedef struct _Serial_m2s_buffer_t {
-#    ifdef BACKLIGHT_ENABLE
-    uint8_t backlight_level;
-#    endif
-} Serial_m2s_buffer_t;
+static void serial_fallback_master_update(int status) {
+    if (status == TRANSACTION_END) {
+        serial_failures = 0;
+        if (serial_error_score > 0) {
+            serial_error_score--;
+        }
+        return;
+    }
 
-#    if defined(RGBLIGHT_ENABLE) && defined(RGBLIGHT_SPLIT)
-// When MCUs on both sides drive their respective RGB LED chains,
-// it is necessary to synchronize, so it is necessary to communicate RGB
-// information. In that case, define RGBLIGHT_SPLIT with info on the number
-// of LEDs on each half.
-//
-// Otherwise, if the master side MCU drives both sides RGB LED chains,
-// there is no need to communicate.
+    // A link which is down fails in long runs, only the first failure of a
+    // run counts towards the error rate
+    if (++serial_failures == 1) {
+        serial_error_score = serial_error_score > UINT8_MAX - SERIAL_FALLBACK_ERROR_WEIGHT ? UINT8_MAX : serial_error_score + SERIAL_FALLBACK_ERROR_WEIGHT;
+        if (serial_error_score >= SERIAL_FALLBACK_ERROR_LIMIT && !soft_serial_is_fallback()) {
+            serial_fallback_switch(true);
+            // The slave only follows once it misses the master for
+            // SERIAL_FALLBACK_TIMEOUT ms, don't hunt back before that
+            serial_fallback_hold       = true;
+            serial_fallback_hold_start = timer_read();
+        }
+        return;
+    }
 
-typedef struct _Serial_rgblight_t {
-    rgblight_syncinfo_t rgblight_sync;
-} Serial_rgblight_t;
+    if (serial_failures >= SERIAL_FALLBACK_FAILURES) {
+        if (serial_fallback_hold && timer_elapsed(serial_fallback_hold_start) <= 2 * SERIAL_FALLBACK_TIMEOUT) {
+            serial_failures = SERIAL_FALLBACK_FAILURES;
+            return;
+        }
+        serial_fallback_switch(!soft_serial_is_fallback());
+    }
+}
 
-volatile Serial_rgblight_t serial_rgblight = {};
-uint8_t volatile status_rgblight           = 0;
+static void serial_fallback_slave_task(void) {
+    if (timer_elapsed(serial_last_activity) > SERIAL_FALLBACK_TIMEOUT) {
+        serial_fallback_switch(!soft_serial_is_fallback());
+        serial_last_activity = timer_read();
+    }
+}
+#    else
+#        define serial_fallback_init()
+#        define serial_fallback_master_update(status)
+#        define serial_fallback_slave_task()
 #    endif
 
-volatile Serial_s2m_buffer_t serial_s2m_buffer = {};
-volatile Serial_m2s_buffer_t serial_m2s_buffer = {};
-uint8_t volatile status0                       = 0;
+static uint8_t serial_transaction_transact(uint8_t id, const split_transaction_t *transaction) {
+    int status = soft_serial_transaction(id);
+    serial_fallback_master_update(status);
+
+    switch (status) {
+        case TRANSACTION_END:
+            return SPLIT_TRANSACTION_OK;
+        case TRANSACTION_DATA_ERROR:
+            return SPLIT_TRANSACTION_CHECKSUM_ERROR;
+        default:
+            return SPLIT_TRANSACTION_NAK;
+    }
+}
 
-enum serial_transaction_id {
-    GET_SLAVE_MATRIX = 0,
-#    if defined(RGBLIGHT_ENABLE) && defined(RGBLIGHT_SPLIT)
-    PUT_RGBLIGHT,
+static bool serial_transaction_slave_sync(uint8_t id, const split_transaction_t *transaction) {
+    // The target interrupt reads and writes the buffers directly
+    int status = soft_serial_get_and_clean_status(id);
+#    ifdef SELECT_SOFT_SERIAL_FALLBACK_SPEED
+    if (status == TRANSACTION_ACCEPTED) {
+        serial_last_activity = timer_read();
+    }
 #    endif
-};
+    return transaction->direction == SPLIT_MASTER_TO_SLAVE && status == TRANSACTION_ACCEPTED;
+}
 
-SSTD_t transactions[] = {
-    [GET_SLAVE_MATRIX] =
-        {
-            (uint8_t *)&status0,
-            sizeof(serial_m2s_buffer),
-            (uint8_t *)&serial_m2s_buffer,
-            sizeof(serial_s2m_buffer),
-            (uint8_t *)&serial_s2m_buffer,
-        },
-#    if defined(RGBLIGHT_ENABLE) && defined(RGBLIGHT_SPLIT)
-    [PUT_RGBLIGHT] =
-        {
-            (uint8_t *)&status_rgblight, sizeof(serial_rgblight), (uint8_t *)&serial_rgblight, 0, NULL  // no slave to master transfer
-        },
-#    endif
+// Rough cost at the default speed: sync pulse, 8 data bits and a parity bit per byte
+static const split_transport_driver_t transport_driver = {
+    .overhead_us  = 100,
+    .byte_time_us = 70,
+    .add          = serial_transaction_add,
+    .transact     = serial_transaction_transact,
+    .slave_sync   = serial_transaction_slave_sync,
 };
 
-void transport_master_init(void) { soft_serial_initiator_init(transactions, TID_LIMIT(transactions)); }
+static void serial_transactions_init(void) {
+    for (uint8_t id = 0; id < SPLIT_TRANSACTIONS_MAX; id++) {
+        serial_transactions[id].status = (uint8_t *)&serial_status[id];
+    }
+    serial_fallback_init();
+}
+
+static void transport_driver_master_init(void) {
+    serial_transactions_init();
+    soft_serial_initiator_init(serial_transactions, SPLIT_TRANSACTIONS_MAX);
+}
 
-void transport_slave_init(void) { soft_serial_target_init(transactions, TID_LIMIT(transactions)); }
+static void transport_driver_slave_init(void) {
+    serial_transactions_init();
+    soft_serial_target_init(serial_transactions, SPLIT_TRANSACTIONS_MAX);
+}
 
-#    if defined(RGBLIGHT_ENABLE) && defined(RGBLIGHT_SPLIT)
+static void transport_driver_slave_task(void) { serial_fallback_slave_task(); }
 
-// rgblight synchronization information communication.
+#endif
 
-void transport_rgblight_master(void) {
-    if (rgblight_get_change_flags()) {
-        rgblight_get_syncinfo((rgblight_syncinfo_t *)&serial_rgblight.rgblight_sync);
-        if (soft_serial_transaction(PUT_RGBLIGHT) == TRANSACTION_END) {
-            rgblight_clear_change_flags();
-        }
+static void transport_register(uint8_t id, const split_transaction_t *transaction) {
+    if (!split_transaction_register(id, transaction)) {
+        dprintf("split transaction %u could not be registered\n", id);
     }
 }
 
-void transport_rgblight_slave(void) {
-    if (status_rgblight == TRANSACTION_ACCEPTED) {
-        rgblight_update_sync((rgblight_syncinfo_t *)&serial_rgblight.rgblight_sync, false);
-        status_rgblight = TRANSACTION_END;
-    }
+static void transport_register_transactions(void) {
+    split_transactions_init(&transport_driver);
+    transport_register(SPLIT_TRANSACTION_SLAVE_STATE, &slave_state_transaction);
+#ifdef SPLIT_TRANSPORT_DELTA
+    transport_register(SPLIT_TRANSACTION_SYNC, &sync_transaction);
+#endif
+#ifdef BACKLIGHT_ENABLE
+    transport_register(SPLIT_TRANSACTION_BACKLIGHT, &backlight_transaction);
+#endif
+#if defined(RGBLIGHT_ENABLE) && defined(RGBLIGHT_SPLIT)
+    transport_register(SPLIT_TRANSACTION_RGBLIGHT, &rgblight_transaction);
+#endif
 }
 
-#    else
-#        define transport_rgblight_master()
-#        define transport_rgblight_slave()
-#    endif
+void transport_master_init(void) {
+    transport_driver_master_init();
+    transport_register_transactions();
+}
 
-bool transport_master(matrix_row_t matrix[]) {
-#    ifndef SERIAL_USE_MULTI_TRANSACTION
-    if (soft_serial_transaction() != TRANSACTION_END) {
-        return false;
-    }
-#    else
-    transport_rgblight_master();
-    if (soft_serial_transaction(GET_SLAVE_MATRIX) != TRANSACTION_END) {
+void transport_slave_init(void) {
+    transport_driver_slave_init();
+    transport_register_transactions();
+}
+
+static bool transport_read_slave_state(matrix_row_t matrix[]) {
+    if (split_transaction_run(SPLIT_TRANSACTION_SLAVE_STATE) != SPLIT_TRANSACTION_OK) {
         return false;
     }
-#    endif
 
     // TODO:  if MATRIX_COLS > 8 change to unpack()
     for (int i = 0; i < ROWS_PER_HAND; ++i) {
-        matrix[i] = serial_s2m_buffer.smatrix[i];
+        matrix[i] = slave_state.smatrix[i];
     }
 
-#    ifdef BACKLIGHT_ENABLE
-    // Write backlight level for slave to read
-    serial_m2s_buffer.backlight_level = is_backlight_enabled() ? get_backlight_level() : 0;
-#    endif
+#ifdef ENCODER_ENABLE
+    encoder_update_raw((uint8_t *)slave_state.encoder_state);
+#endif
 
-#    ifdef ENCODER_ENABLE
-    encoder_update_raw((uint8_t *)serial_s2m_buffer.encoder_state);
-#    endif
+    return true;
+}
+
+static bool transport_sync_slave_state(matrix_row_t matrix[]) {
+#ifdef SPLIT_TRANSPORT_DELTA
+    if (split_transaction_run(SPLIT_TRANSACTION_SYNC) != SPLIT_TRANSACTION_OK) {
+        full_sync_required = true;
+        return false;
+    }
+
+    uint8_t sequence = slave_sync_sequence;
+    if (!transport_sync_required(sequence)) {
+        return true;
+    }
+    if (!transport_read_slave_state(matrix)) {
+        full_sync_required = true;
+        return false;
+    }
+    transport_sync_done(sequence);
+    return true;
+#else
+    return transport_read_slave_state(matrix);
+#endif
+}
+
+bool transport_master(matrix_row_t matrix[]) {
+    if (!transport_sync_slave_state(matrix)) {
+#ifdef BACKLIGHT_ENABLE
+        // the slave may have been reset, send the current level again once
+        // it is back rather than a level which failed before
+        split_backlight_resend = true;
+        split_transaction_cancel(SPLIT_TRANSACTION_BACKLIGHT);
+#endif
+        return false;
+    }
+
+    split_transactions_master_task();
 
     return true;
 }
 
 void transport_slave(matrix_row_t matrix[]) {
-    transport_rgblight_slave();
+#ifdef SPLIT_TRANSPORT_DELTA
+    bool changed = false;
+#endif
+
     // TODO: if MATRIX_COLS > 8 change to pack()
     for (int i = 0; i < ROWS_PER_HAND; ++i) {
-        serial_s2m_buffer.smatrix[i] = matrix[i];
+#ifdef SPLIT_TRANSPORT_DELTA
+        changed |= slave_state.smatrix[i] != matrix[i];
+#endif
+        slave_state.smatrix[i] = matrix[i];
     }
-#    ifdef BACKLIGHT_ENABLE
-    backlight_set(serial_m2s_buffer.backlight_level);
-#    endif
 
-#    ifdef ENCODER_ENABLE
-    encoder_state_raw((uint8_t *)serial_s2m_buffer.encoder_state);
+#ifdef ENCODER_ENABLE
+    uint8_t encoder_state[NUMBER_OF_ENCODERS];
+    encoder_state_raw(encoder_state);
+    for (uint8_t i = 0; i < NUMBER_OF_ENCODERS; ++i) {
+#    ifdef SPLIT_TRANSPORT_DELTA
+        changed |= slave_state.encoder_state[i] != encoder_state[i];
 #    endif
+        slave_state.encoder_state[i] = encoder_state[i];
+    }
+#endif
+
+#ifdef SPLIT_TRANSPORT_DELTA
+    if (changed) {
+        slave_sync_sequence++;
+    }
+#endif
+
+    split_transactions_slave_task();
+    transport_driver_slave_task();
 }
 
+#ifdef SPLIT_TRANSACTION_STATS
+void transport_print_stats(void) {
+    for (uint8_t id = 0; id < SPLIT_TRANSACTIONS_MAX; id++) {
+        const split_transaction_stats_t *stats = split_transaction_get_stats(id);
+        if (stats->success || stats->nak || stats->timeout || stats->checksum_error) {
+            uprintf("split %u: ok %u nak %u timeout %u checksum %u latency %u max %u\n", id, stats->success, stats->nak, stats->timeout, stats->checksum_error, stats->last_latency, stats->max_latency);
+        }
+    }
+#    ifdef SELECT_SOFT_SERIAL_FALLBACK_SPEED
+    uprintf("split serial fallback: %u\n", soft_serial_is_fallback());
+#    endif
+}
 #endif
@@ -8,3 +8,8 @@ void transport_slave_init(void);
 // returns false if valid data not received from slave
 bool transport_master(matrix_row_t matrix[]);
 void transport_slave(matrix_row_t matrix[]);
+
+#ifdef SPLIT_TRANSACTION_STATS
+// prints the split transaction counters to the console
+void transport_print_stats(void);
+#endif
@@ -0,0 +1,8 @@
+#pragma once
+
+#define MATRIX_ROWS 1
+#define MATRIX_COLS 4
+#define DRIVER_LED_TOTAL 4
+
+#define RGB_MATRIX_KEYPRESSES
+#define RGB_MATRIX_STARTUP_MODE RGB_MATRIX_SOLID_REACTIVE_SIMPLE
@@ -0,0 +1,122 @@
+#include "gtest/gtest.h"
+extern "C" {
+#include "rgb_matrix.h"
+void set_time(uint32_t t);
+void advance_time(uint32_t ms);
+}
+
+extern "C" {
+// clang-format off
+led_config_t g_led_config = {{
+    {0, 1, 2, 3}
+}, {
+    {0, 32}, {64, 32}, {128, 32}, {192, 32}
+}, {
+    4, 4, 4, 4
+}};
+// clang-format on
+
+static void sim_init(void) {}
+static void sim_set_color(int index, uint8_t r, uint8_t g, uint8_t b) {}
+static void sim_set_color_all(uint8_t r, uint8_t g, uint8_t b) {}
+static void sim_flush(void) {}
+
+const rgb_matrix_driver_t rgb_matrix_driver = {
+    .init          = sim_init,
+    .set_color     = sim_set_color,
+    .set_color_all = sim_set_color_all,
+    .flush         = sim_flush,
+};
+
+bool eeconfig_is_enabled(void) { return true; }
+void eeconfig_init(void) {}
+}
+
+class RgbMatrix : public testing::Test {
+   public:
+    RgbMatrix() {
+        set_time(0);
+        rgb_matrix_init();
+        // Start at a frame, with no hits left from the previous test
+        frame(UINT16_MAX);
+        rgb_matrix_config.speed = 255;
+        frame();
+    }
+
+    void press(uint8_t col) {
+        keyrecord_t record   = {};
+        record.event.key.row = 0;
+        record.event.key.col = col;
+        record.event.pressed = true;
+        process_rgb_matrix(0, &record);
+    }
+
+    // Runs the task after ms without a run, then until the effects get the
+    // hits of the next frame
+    void frame(uint32_t ms = 0) {
+        advance_time(ms);
+        uint32_t start = g_rgb_counters.tick;
+        do {
+            rgb_matrix_task();
+            advance_time(1);
+        } while (g_rgb_counters.tick == start);
+    }
+};
+
+// At speed 255 a hit expires after 512 * 256 / 255 ms
+static const uint32_t expiry = 514;
+
+TEST_F(RgbMatrix, ages_the_hits) {
+    press(1);
+    frame();
+    ASSERT_EQ(g_last_hit_tracker.count, 1);
+    EXPECT_EQ(g_last_hit_tracker.index[0], 1);
+    uint16_t tick = g_last_hit_tracker.tick[0];
+    EXPECT_LT(tick, expiry);
+
+    frame(100);
+    ASSERT_EQ(g_last_hit_tracker.count, 1);
+    EXPECT_GT(g_last_hit_tracker.tick[0], tick + 100);
+}
+
+TEST_F(RgbMatrix, expires_the_oldest_hits_first) {
+    press(0);
+    frame(300);
+    press(1);
+    frame(300);
+    ASSERT_EQ(g_last_hit_tracker.count, 1);
+    EXPECT_EQ(g_last_hit_tracker.index[0], 1);
+
+    frame(expiry);
+    EXPECT_EQ(g_last_hit_tracker.count, 0);
+}
+
+TEST_F(RgbMatrix, expires_the_hits_after_a_longer_gap) {
+    for (uint32_t gap : {expiry, expiry + 1, 600u, 65000u, 65500u, 65536u + 10, 200000u}) {
+        press(0);
+        advance_time(100);
+        press(1);
+        frame(gap);
+        EXPECT_EQ(g_last_hit_tracker.count, 0) << "after " << gap << " ms";
+
+        // A new hit is the only one
+        press(2);
+        frame();
+        ASSERT_EQ(g_last_hit_tracker.count, 1) << "after " << gap << " ms";
+        EXPECT_EQ(g_last_hit_tracker.index[0], 2);
+        EXPECT_LT(g_last_hit_tracker.tick[0], 100);
+        frame(expiry);
+    }
+}
+
+TEST_F(RgbMatrix, keeps_the_hits_at_the_slowest_speed) {
+    // The expiry is capped to the 16 bit tick
+    rgb_matrix_config.speed = 1;
+    press(0);
+    frame(60000);
+    ASSERT_EQ(g_last_hit_tracker.count, 1);
+    EXPECT_GE(g_last_hit_tracker.tick[0], 60000);
+
+    frame(10000);
+    EXPECT_EQ(g_last_hit_tracker.count, 0);
+}
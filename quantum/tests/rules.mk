@@ -0,0 +1,10 @@
+rgb_matrix_SRC := \
+	$(QUANTUM_PATH)/tests/rgb_matrix_tests.cpp \
+	$(QUANTUM_PATH)/rgb_matrix.c \
+	$(QUANTUM_PATH)/color.c \
+	$(TMK_PATH)/common/test/timer.c \
+	$(TMK_PATH)/common/test/eeprom.c
+
+rgb_matrix_INC := $(QUANTUM_PATH)/tests
+rgb_matrix_CONFIG := $(QUANTUM_PATH)/tests/config.h
+rgb_matrix_DEFS := -DRGB_MATRIX_ENABLE -DNO_PRINT -DNO_DEBUG
@@ -0,0 +1,282 @@
+/* Copyright 2019 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Renders the songs of song_list.h into WAV files on the host.
+ *
+ * The song is played the way the timer 3 interrupt of audio.c plays it,
+ * with audio_synth.c and voices.c, and the timer itself is simulated: each
+ * interrupt plays one period of ICR3 + 1 timer ticks on the pin, which is
+ * high for the first OCR3A + 1 of them. A period of 0 is one tick of
+ * silence. The pin is filtered down to the sample rate of the WAV file.
+ *
+ * The time spent in the interrupt code is measured, in cycles of the host
+ * CPU where they can be read and in nanoseconds otherwise.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <unistd.h>
+#if defined(__x86_64__) || defined(__i386__)
+#    include <x86intrin.h>
+#else
+#    include <time.h>
+#endif
+
+#include "audio.h"
+#include "audio_synth.h"
+
+// The globals of audio.c which voices.c uses
+uint16_t envelope_index = 0;
+float    note_timbre    = TIMBRE_DEFAULT;
+float    polyphony_rate = 0;
+bool     glissando      = true;
+
+#define SONG_ENTRY(name) static float name##_notes[][2] = SONG(name);
+#include "song_table.h"
+#undef SONG_ENTRY
+
+typedef struct {
+    const char *name;
+    float (*notes)[][2];
+    uint16_t count;
+} song_entry_t;
+
+#define SONG_ENTRY(name) {#name, &name##_notes, NOTE_ARRAY_SIZE(name##_notes)},
+static const song_entry_t songs[] = {
+#include "song_table.h"
+};
+#undef SONG_ENTRY
+
+#define SONG_COUNT (sizeof(songs) / sizeof(songs[0]))
+
+#if defined(__x86_64__) || defined(__i386__)
+#    define CYCLE_UNIT "cycles"
+static inline uint64_t read_cycles(void) { return __rdtsc(); }
+#else
+#    define CYCLE_UNIT "ns"
+static inline uint64_t read_cycles(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+}
+#endif
+
+/*
+ * WAV output, 16 bit mono PCM
+ */
+
+// Levels of the pin in the WAV file, the DC offset doesn't matter
+#define PIN_HIGH 0x3FFF
+#define PIN_LOW (-0x4000)
+
+typedef struct {
+    FILE *   file;
+    uint32_t sample_rate;
+    uint32_t tick_rate;
+    uint32_t samples;
+    // Timer ticks in the current sample, times the sample rate, and the
+    // sum of the levels over them
+    uint64_t fill;
+    int64_t  sum;
+} wav_t;
+
+static void write_u16(FILE *file, uint16_t value) {
+    fputc(value & 0xFF, file);
+    fputc(value >> 8, file);
+}
+
+static void write_u32(FILE *file, uint32_t value) {
+    write_u16(file, value & 0xFFFF);
+    write_u16(file, value >> 16);
+}
+
+static void write_header(wav_t *wav) {
+    fwrite("RIFF", 1, 4, wav->file);
+    write_u32(wav->file, 36 + wav->samples * 2);
+    fwrite("WAVEfmt ", 1, 8, wav->file);
+    write_u32(wav->file, 16);
+    write_u16(wav->file, 1);  // PCM
+    write_u16(wav->file, 1);  // mono
+    write_u32(wav->file, wav->sample_rate);
+    write_u32(wav->file, wav->sample_rate * 2);
+    write_u16(wav->file, 2);
+    write_u16(wav->file, 16);
+    fwrite("data", 1, 4, wav->file);
+    write_u32(wav->file, wav->samples * 2);
+}
+
+// Adds ticks of the timer at a level of the pin, and writes out each
+// sample which is complete
+static void wav_add(wav_t *wav, int16_t level, uint32_t ticks) {
+    uint64_t remaining = (uint64_t)ticks * wav->sample_rate;
+    while (remaining > 0) {
+        uint64_t take = wav->tick_rate - wav->fill;
+        if (take > remaining) {
+            take = remaining;
+        }
+        wav->sum += level * (int64_t)take;
+        wav->fill += take;
+        remaining -= take;
+        if (wav->fill == wav->tick_rate) {
+            write_u16(wav->file, (uint16_t)(int16_t)(wav->sum / (int64_t)wav->tick_rate));
+            wav->samples++;
+            wav->fill = 0;
+            wav->sum  = 0;
+        }
+    }
+}
+
+// The vibrato of audio.c at its default rate and strength
+#ifdef VIBRATO_ENABLE
+static audio_vibrato_t vibrato_state;
+#endif
+
+/*
+ * Command line
+ */
+
+static void usage(const char *program) {
+    fprintf(stderr,
+            "usage: %s [-o FILE] [-r RATE] [-t TEMPO] [-v VOICE] SONG\n"
+            "       %s -l\n"
+            "\n"
+            "  -o FILE   WAV file to write, SONG.wav by default\n"
+            "  -r RATE   sample rate of the WAV file, 44100 by default\n"
+            "  -t TEMPO  tempo of the song, %d by default\n"
+            "  -v VOICE  voice from voices.h, from 0 to %d\n"
+            "  -l        list the songs of song_list.h\n",
+            program, program, TEMPO_DEFAULT, number_of_voices - 1);
+    exit(1);
+}
+
+static const song_entry_t *find_song(const char *name) {
+    for (size_t i = 0; i < SONG_COUNT; i++) {
+        if (strcasecmp(songs[i].name, name) == 0) {
+            return &songs[i];
+        }
+    }
+    return NULL;
+}
+
+int main(int argc, char **argv) {
+    const char *output      = NULL;
+    uint32_t    sample_rate = 44100;
+    uint8_t     tempo       = TEMPO_DEFAULT;
+    int         option;
+
+    while ((option = getopt(argc, argv, "o:r:t:v:l")) != -1) {
+        switch (option) {
+            case 'o':
+                output = optarg;
+                break;
+            case 'r':
+                sample_rate = strtoul(optarg, NULL, 10);
+                break;
+            case 't':
+                tempo = strtoul(optarg, NULL, 10);
+                break;
+            case 'v': {
+                int v = atoi(optarg);
+                if (v < 0 || v >= number_of_voices) {
+                    usage(argv[0]);
+                }
+                set_voice(v);
+                break;
+            }
+            case 'l':
+                for (size_t i = 0; i < SONG_COUNT; i++) {
+                    printf("%s\n", songs[i].name);
+                }
+                return 0;
+            default:
+                usage(argv[0]);
+        }
+    }
+    if (optind != argc - 1 || sample_rate == 0 || tempo == 0) {
+        usage(argv[0]);
+    }
+
+    const song_entry_t *entry = find_song(argv[optind]);
+    if (!entry) {
+        fprintf(stderr, "%s: unknown song %s, see -l\n", argv[0], argv[optind]);
+        return 1;
+    }
+
+    char default_output[64];
+    if (!output) {
+        size_t i;
+        for (i = 0; entry->name[i] && i < sizeof(default_output) - 5; i++) {
+            default_output[i] = tolower(entry->name[i]);
+        }
+        strcpy(&default_output[i], ".wav");
+        output = default_output;
+    }
+
+    wav_t wav = {0};
+    wav.sample_rate = sample_rate;
+    wav.tick_rate   = F_CPU / CPU_PRESCALER;
+    wav.file        = fopen(output, "wb");
+    if (!wav.file) {
+        perror(output);
+        return 1;
+    }
+    // Filled in once the length is known
+    write_header(&wav);
+
+#ifdef VIBRATO_ENABLE
+    audio_vibrato_init(&vibrato_state, 0.125, .5);
+#endif
+
+    audio_song_t song;
+    audio_song_start(&song, entry->notes, entry->count, false, tempo);
+#ifdef VIBRATO_ENABLE
+    song.vibrato = &vibrato_state;
+#endif
+    envelope_index = 0;
+
+    uint64_t interrupts = 0;
+    uint64_t cycles     = 0;
+    uint64_t ticks      = 0;
+    while (true) {
+        audio_timer_t timer;
+        uint64_t      start = read_cycles();
+        bool          over  = audio_song_period(&song, tempo, &timer) == AUDIO_SONG_OVER;
+        cycles += read_cycles() - start;
+        interrupts++;
+
+        if (timer.period == 0) {
+            wav_add(&wav, PIN_LOW, 1);
+            ticks++;
+        } else {
+            wav_add(&wav, PIN_HIGH, timer.duty + 1);
+            wav_add(&wav, PIN_LOW, timer.period - timer.duty);
+            ticks += timer.period + 1;
+        }
+        if (over) {
+            break;
+        }
+    }
+
+    rewind(wav.file);
+    write_header(&wav);
+    fclose(wav.file);
+
+    printf("%s: %u samples, %.2f seconds at %u Hz\n", output, wav.samples, (double)ticks / wav.tick_rate, sample_rate);
+    printf("%llu interrupts, %.1f " CYCLE_UNIT " per interrupt, %.1f " CYCLE_UNIT " per sample\n", (unsigned long long)interrupts, (double)cycles / interrupts, wav.samples ? (double)cycles / wav.samples : 0);
+    return 0;
+}